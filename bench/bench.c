@@ -0,0 +1,402 @@
+// Throughput benchmark for CSV load and store, cell access and teardown.
+//
+// Generates a deterministic synthetic CSV, runs each operation a few times and
+// prints the best run of each as one JSON object on stdout, so results of two
+// builds can be compared with a script. Build and run with `make bench`, or
+// run ./bench_dataframe --help for the options.
+
+#include "dataframe.h"
+#include "dfio.h"
+#include "dfstats.h"
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Number of distinct values in generated categorical columns
+#define NUM_CATEGORIES 16
+
+// Longest line the stdio reader accepts
+#define STDIO_LINE_LIMIT 1023
+
+// Shape of the generated input and how to run the benchmark
+typedef struct {
+    size_t rows;
+    size_t int_columns;
+    size_t float_columns;
+    size_t string_columns;
+    size_t categorical_columns;
+    size_t string_length; // Average length of generated strings
+    double quote_ratio;   // Fraction of strings that are quoted with an embedded comma and quote
+    uint64_t seed;
+    size_t threads;       // Threads for read_csv_parallel, 0 for one per CPU
+    int repeat;           // Runs per operation, the best one is reported
+    const char *path;     // Where the generated CSV is written
+} BenchConfig;
+
+// Best run of one operation
+typedef struct {
+    const char *name;
+    double seconds;
+    size_t bytes; // Bytes processed per run, 0 if not meaningful
+    size_t rows;  // Rows processed per run
+    size_t cells; // Cells processed per run, 0 if not meaningful
+    long peak_rss_kb;
+    int skipped;
+} BenchResult;
+
+static uint64_t rng_state;
+
+// xorshift64*, deterministic for a given seed
+static uint64_t next_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * UINT64_C(2685821657736338717);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Process high-water mark of resident memory, so it only grows from phase to phase
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static size_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static size_t num_columns(const BenchConfig *config) {
+    return config->int_columns + config->float_columns + config->string_columns + config->categorical_columns;
+}
+
+// Column types in generation order: ints, floats, strings, categoricals
+static DataType *column_types(const BenchConfig *config) {
+    size_t total = num_columns(config);
+    DataType *types = malloc(total * sizeof(DataType));
+    if (types == NULL) return NULL;
+    size_t i = 0;
+    for (size_t c = 0; c < config->int_columns; c++) types[i++] = DATA_TYPE_INT;
+    for (size_t c = 0; c < config->float_columns; c++) types[i++] = DATA_TYPE_FLOAT;
+    for (size_t c = 0; c < config->string_columns; c++) types[i++] = DATA_TYPE_STRING;
+    for (size_t c = 0; c < config->categorical_columns; c++) types[i++] = DATA_TYPE_CATEGORICAL;
+    return types;
+}
+
+// Writes the synthetic CSV and returns its longest line, or 0 on failure
+static size_t generate_csv(const BenchConfig *config, const DataType *types) {
+    FILE *fp = fopen(config->path, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Could not create '%s'\n", config->path);
+        return 0;
+    }
+    size_t total = num_columns(config);
+    for (size_t c = 0; c < total; c++) {
+        fprintf(fp, "%sc%zu", c ? "," : "", c);
+    }
+    fputc('\n', fp);
+
+    rng_state = config->seed ? config->seed : 1;
+    size_t longest = 0;
+    char text[4096];
+    for (size_t row = 0; row < config->rows; row++) {
+        long start = ftell(fp);
+        for (size_t c = 0; c < total; c++) {
+            if (c) fputc(',', fp);
+            switch (types[c]) {
+                case DATA_TYPE_INT:
+                    fprintf(fp, "%d", (int)(next_random() % 2000001) - 1000000);
+                    break;
+                case DATA_TYPE_FLOAT:
+                    fprintf(fp, "%.2f", (double)(next_random() % 10000000) / 100.0 - 50000.0);
+                    break;
+                case DATA_TYPE_STRING: {
+                    size_t length = config->string_length / 2 + next_random() % (config->string_length + 1);
+                    if (length >= sizeof(text)) length = sizeof(text) - 1;
+                    for (size_t k = 0; k < length; k++) text[k] = (char)('a' + next_random() % 26);
+                    text[length] = '\0';
+                    if ((double)(next_random() % 1000000) < config->quote_ratio * 1000000.0) {
+                        fprintf(fp, "\"%s, \"\"q\"\"\"", text);
+                    } else {
+                        fputs(text, fp);
+                    }
+                    break;
+                }
+                default:
+                    fprintf(fp, "category_%d", (int)(next_random() % NUM_CATEGORIES));
+                    break;
+            }
+        }
+        fputc('\n', fp);
+        size_t length = (size_t)(ftell(fp) - start);
+        if (length > longest) longest = length;
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Could not write '%s'\n", config->path);
+        return 0;
+    }
+    return longest;
+}
+
+// Loads the CSV with one of the readers
+static DataFrame *load(const BenchConfig *config, DataType *types, int reader) {
+    size_t total = num_columns(config);
+    switch (reader) {
+        case 0:
+            return read_csv(config->path, types, total);
+        case 1:
+            return read_csv_mmap(config->path, types, total);
+        case 2:
+            return read_csv_parallel(config->path, types, total, config->threads);
+        case 3:
+            return read_csv_pipelined(config->path, types, total, NULL);
+        default: {
+            // The DataFrame owns the arena and frees it on teardown; a failed
+            // read never takes the arena over, so it is still ours to free
+            DataFrameArena *arena = arena_create(0);
+            if (arena == NULL) return NULL;
+            DataFrameAllocator allocator = arena_allocator(arena, 1);
+            CsvReadOptions options = {NULL, &allocator};
+            DataFrame *df = read_csv_with_options(config->path, types, total, &options);
+            if (df == NULL) arena_destroy(arena);
+            return df;
+        }
+    }
+}
+
+// Times loads and teardowns with one reader
+static int bench_load(const BenchConfig *config, DataType *types, int reader, BenchResult *loaded,
+                      BenchResult *teardown) {
+    for (int run = 0; run < config->repeat; run++) {
+        double start = now_seconds();
+        DataFrame *df = load(config, types, reader);
+        double middle = now_seconds();
+        if (df == NULL) return -1;
+        loaded->rows = df->num_rows;
+        destroy_dataframe(df);
+        double end = now_seconds();
+        if (run == 0 || middle - start < loaded->seconds) loaded->seconds = middle - start;
+        if (teardown && (run == 0 || end - middle < teardown->seconds)) teardown->seconds = end - middle;
+    }
+    loaded->peak_rss_kb = peak_rss_kb();
+    if (teardown) {
+        teardown->rows = loaded->rows;
+        teardown->peak_rss_kb = loaded->peak_rss_kb;
+    }
+    return 0;
+}
+
+// Times reading every cell with get_value and writing it back with set_value
+static void bench_cells(const BenchConfig *config, DataFrame *df, BenchResult *get, BenchResult *set) {
+    size_t cells = df->num_rows * df->num_columns;
+    volatile long sink = 0;
+    for (int run = 0; run < config->repeat; run++) {
+        double start = now_seconds();
+        for (size_t col = 0; col < df->num_columns; col++) {
+            for (size_t row = 0; row < df->num_rows; row++) {
+                union { int i; float f; char *s; } value;
+                get_value(df, row, col, &value);
+                sink += df->columns[col].type == DATA_TYPE_INT ? value.i : 1;
+            }
+        }
+        double middle = now_seconds();
+        for (size_t col = 0; col < df->num_columns; col++) {
+            DataType type = df->columns[col].type;
+            for (size_t row = 0; row < df->num_rows; row++) {
+                int i = (int)row;
+                float f = (float)row;
+                const void *value = type == DATA_TYPE_INT ? (const void *)&i
+                                    : type == DATA_TYPE_FLOAT ? (const void *)&f
+                                    : type == DATA_TYPE_STRING ? "value" : "category_1";
+                set_value(df, row, col, value);
+            }
+        }
+        double end = now_seconds();
+        if (run == 0 || middle - start < get->seconds) get->seconds = middle - start;
+        if (run == 0 || end - middle < set->seconds) set->seconds = end - middle;
+    }
+    get->rows = set->rows = df->num_rows;
+    get->cells = set->cells = cells;
+    get->peak_rss_kb = set->peak_rss_kb = peak_rss_kb();
+}
+
+static void print_result(const BenchResult *result, int last) {
+    printf("    {\"name\":\"%s\"", result->name);
+    if (result->skipped) {
+        printf(",\"skipped\":true}%s\n", last ? "" : ",");
+        return;
+    }
+    double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+    printf(",\"seconds\":%.6f,\"rows_per_s\":%.0f", result->seconds, (double)result->rows / seconds);
+    if (result->bytes) printf(",\"mb_per_s\":%.2f", (double)result->bytes / seconds / 1e6);
+    if (result->cells) printf(",\"cells_per_s\":%.0f", (double)result->cells / seconds);
+    printf(",\"peak_rss_kb\":%ld}%s\n", result->peak_rss_kb, last ? "" : ",");
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --rows N             rows to generate (default 200000)\n"
+            "  --ints N             INT columns (default 4)\n"
+            "  --floats N           FLOAT columns (default 4)\n"
+            "  --strings N          STRING columns (default 2)\n"
+            "  --categoricals N     CATEGORICAL columns (default 2)\n"
+            "  --string-length N    average string length (default 12)\n"
+            "  --quote-ratio R      fraction of quoted strings, 0 to 1 (default 0.1)\n"
+            "  --seed N             generator seed (default 42)\n"
+            "  --threads N          threads for the parallel reader, 0 for all CPUs (default 0)\n"
+            "  --repeat N           runs per operation, best is reported (default 3)\n"
+            "  --file PATH          generated CSV (default bench_input.csv)\n",
+            program);
+}
+
+static int parse_options(int argc, char **argv, BenchConfig *config) {
+    static const struct option options[] = {
+        {"rows", required_argument, NULL, 'r'},
+        {"ints", required_argument, NULL, 'i'},
+        {"floats", required_argument, NULL, 'f'},
+        {"strings", required_argument, NULL, 's'},
+        {"categoricals", required_argument, NULL, 'c'},
+        {"string-length", required_argument, NULL, 'l'},
+        {"quote-ratio", required_argument, NULL, 'q'},
+        {"seed", required_argument, NULL, 'S'},
+        {"threads", required_argument, NULL, 't'},
+        {"repeat", required_argument, NULL, 'n'},
+        {"file", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (option) {
+            case 'r': config->rows = strtoul(optarg, NULL, 10); break;
+            case 'i': config->int_columns = strtoul(optarg, NULL, 10); break;
+            case 'f': config->float_columns = strtoul(optarg, NULL, 10); break;
+            case 's': config->string_columns = strtoul(optarg, NULL, 10); break;
+            case 'c': config->categorical_columns = strtoul(optarg, NULL, 10); break;
+            case 'l': config->string_length = strtoul(optarg, NULL, 10); break;
+            case 'q': config->quote_ratio = strtod(optarg, NULL); break;
+            case 'S': config->seed = strtoull(optarg, NULL, 10); break;
+            case 't': config->threads = strtoul(optarg, NULL, 10); break;
+            case 'n': config->repeat = atoi(optarg); break;
+            case 'o': config->path = optarg; break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if (num_columns(config) == 0 || config->repeat < 1) {
+        fprintf(stderr, "At least one column and one run are required\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config = {200000, 4, 4, 2, 2, 12, 0.1, 42, 0, 3, "bench_input.csv"};
+    if (parse_options(argc, argv, &config) != 0) {
+        return 1;
+    }
+
+    DataType *types = column_types(&config);
+    if (types == NULL) {
+        fprintf(stderr, "Memory allocation failed for column types\n");
+        return 1;
+    }
+    size_t longest = generate_csv(&config, types);
+    if (longest == 0) {
+        free(types);
+        return 1;
+    }
+    size_t bytes = file_size(config.path);
+    const char *store_path = "bench_output.csv";
+
+    BenchResult results[10];
+    memset(results, 0, sizeof(results));
+    BenchResult *load_stdio = &results[0], *load_mmap = &results[1], *load_parallel = &results[2];
+    BenchResult *store = &results[3], *get = &results[4], *set = &results[5], *teardown = &results[6];
+    BenchResult *load_arena = &results[7], *teardown_arena = &results[8], *load_pipelined = &results[9];
+    load_stdio->name = "load_read_csv";
+    load_mmap->name = "load_read_csv_mmap";
+    load_parallel->name = "load_read_csv_parallel";
+    store->name = "store_save_to_csv";
+    get->name = "cell_get_value";
+    set->name = "cell_set_value";
+    teardown->name = "teardown_destroy_dataframe";
+    load_arena->name = "load_read_csv_arena";
+    teardown_arena->name = "teardown_destroy_dataframe_arena";
+    load_pipelined->name = "load_read_csv_pipelined";
+    load_stdio->bytes = load_mmap->bytes = load_parallel->bytes = load_arena->bytes = load_pipelined->bytes = bytes;
+
+    stats_reset();
+    int status = 0;
+    // read_csv splits lines at its buffer size, so long lines would be misread
+    if (longest > STDIO_LINE_LIMIT) {
+        load_stdio->skipped = 1;
+    } else {
+        status |= bench_load(&config, types, 0, load_stdio, NULL);
+    }
+    status |= bench_load(&config, types, 1, load_mmap, teardown);
+    status |= bench_load(&config, types, 2, load_parallel, NULL);
+    status |= bench_load(&config, types, 4, load_arena, teardown_arena);
+    status |= bench_load(&config, types, 3, load_pipelined, NULL);
+
+    DataFrame *df = status == 0 ? read_csv_mmap(config.path, types, num_columns(&config)) : NULL;
+    if (df != NULL) {
+        for (int run = 0; run < config.repeat; run++) {
+            double start = now_seconds();
+            status |= save_to_csv_with_options(df, store_path, NULL);
+            double seconds = now_seconds() - start;
+            if (run == 0 || seconds < store->seconds) store->seconds = seconds;
+        }
+        store->rows = df->num_rows;
+        store->bytes = file_size(store_path);
+        store->peak_rss_kb = peak_rss_kb();
+        bench_cells(&config, df, get, set);
+        destroy_dataframe(df);
+    } else {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Benchmark failed\n");
+        free(types);
+        return 1;
+    }
+
+    printf("{\n  \"config\":{\"rows\":%zu,\"ints\":%zu,\"floats\":%zu,\"strings\":%zu,\"categoricals\":%zu,"
+           "\"string_length\":%zu,\"quote_ratio\":%.3f,\"seed\":%llu,\"threads\":%zu,\"repeat\":%d},\n",
+           config.rows, config.int_columns, config.float_columns, config.string_columns,
+           config.categorical_columns, config.string_length, config.quote_ratio,
+           (unsigned long long)config.seed, config.threads, config.repeat);
+    printf("  \"input_bytes\":%zu,\n  \"results\":[\n", bytes);
+    for (int i = 0; i < 10; i++) {
+        print_result(&results[i], i == 9);
+    }
+    printf("  ]");
+    if (stats_enabled()) {
+        DataFrameStats stats;
+        stats_snapshot(&stats);
+        printf(",\n  \"stats\":");
+        fflush(stdout);
+        stats_dump(&stats, stdout);
+        printf("}\n");
+    } else {
+        printf("\n}\n");
+    }
+
+    remove(store_path);
+    remove(config.path);
+    free(types);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stdlib.h>
+#include "dataframe.h"
+
+/**
+ * Summary statistics of a numeric column. Integer sums are accumulated exactly
+ * in 64 bits; float sums use pairwise summation in double precision, so the
+ * error grows with the logarithm of the row count rather than linearly.
+ *
+ * NaN values propagate into sum, mean and variance, while min and max skip
+ * them. For an empty column sum is 0 and the other values are NaN.
+ */
+typedef struct {
+    size_t count;    // Number of values
+    double sum;      // Sum of the values
+    double mean;     // Arithmetic mean
+    double min;      // Smallest value
+    double max;      // Largest value
+    double variance; // Sample variance (divides by count - 1), NaN below two values
+} ColumnStats;
+
+/**
+ * Computes every statistic of an INT or FLOAT column. The column is scanned
+ * once for the sum, min and max, and once more for the squared deviations
+ * from the mean, which is more accurate than a sum of squares.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param num_threads The number of threads to split the rows across, 0 for one
+ *                    per online CPU. Small columns always use one thread.
+ * @param stats Receives the statistics.
+ * @return 0 on success, -1 on failure.
+ */
+int column_stats(const DataFrame *df, size_t column, size_t num_threads, ColumnStats *stats);
+
+/**
+ * Computes the sum of an INT or FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param sum Receives the sum.
+ * @return 0 on success, -1 on failure.
+ */
+int column_sum(const DataFrame *df, size_t column, double *sum);
+
+/**
+ * Computes the mean of an INT or FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param mean Receives the mean, NaN for an empty column.
+ * @return 0 on success, -1 on failure.
+ */
+int column_mean(const DataFrame *df, size_t column, double *mean);
+
+/**
+ * Computes the smallest value of an INT or FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param min Receives the minimum, NaN for an empty column.
+ * @return 0 on success, -1 on failure.
+ */
+int column_min(const DataFrame *df, size_t column, double *min);
+
+/**
+ * Computes the largest value of an INT or FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param max Receives the maximum, NaN for an empty column.
+ * @return 0 on success, -1 on failure.
+ */
+int column_max(const DataFrame *df, size_t column, double *max);
+
+/**
+ * Computes the sample variance of an INT or FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT or FLOAT column.
+ * @param variance Receives the variance, NaN below two rows.
+ * @return 0 on success, -1 on failure.
+ */
+int column_variance(const DataFrame *df, size_t column, double *variance);
+
+/**
+ * Counts the non-NULL values of a column of any type. INT and FLOAT columns
+ * have no NULLs, so their count is the row count.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index.
+ * @param count Receives the count.
+ * @return 0 on success, -1 on failure.
+ */
+int column_count(const DataFrame *df, size_t column, size_t *count);
+
+/**
+ * Returns the name of the kernels selected for this CPU ("avx2" or "scalar").
+ */
+const char *aggregate_implementation(void);
+
+#endif // AGGREGATE_H
@@ -0,0 +1,90 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+
+// Compression of a file; zero-initialised options pick it from the file name
+typedef enum {
+    COMPRESSION_AUTO, // gzip for names ending in .gz, zstd for .zst, otherwise none
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD  // Only available in builds made with ZSTD=1
+} Compression;
+
+/**
+ * Resolves COMPRESSION_AUTO from the extension of a file name.
+ *
+ * @param filename The path to the file.
+ * @param compression The requested compression.
+ * @return compression itself, or the compression implied by filename if it is COMPRESSION_AUTO.
+ */
+Compression compression_for_file(const char *filename, Compression compression);
+
+/**
+ * Streaming decompressor reading a compressed file. gzip input may hold
+ * several concatenated members, as produced by appending to a .gz file.
+ */
+typedef struct Decompressor Decompressor;
+
+/**
+ * Opens a compressed file for reading.
+ *
+ * @param filename The path to the file.
+ * @param compression COMPRESSION_GZIP or COMPRESSION_ZSTD.
+ * @return A pointer to the decompressor, or NULL on failure.
+ */
+Decompressor *decompressor_open(const char *filename, Compression compression);
+
+/**
+ * Decompresses up to size bytes into buffer. Takes a void pointer so it can
+ * serve as a ReadAheadSource.
+ *
+ * @param decompressor Pointer to the decompressor.
+ * @param buffer Receives the decompressed bytes.
+ * @param size Capacity of buffer.
+ * @return The number of bytes written, 0 at the end of the input, or -1 on failure.
+ */
+ssize_t decompressor_read(void *decompressor, char *buffer, size_t size);
+
+/**
+ * Closes the file and frees the decompressor.
+ *
+ * @param decompressor Pointer to the decompressor.
+ */
+void decompressor_close(Decompressor *decompressor);
+
+/**
+ * Streaming compressor writing a compressed file.
+ */
+typedef struct Compressor Compressor;
+
+/**
+ * Creates or truncates a file and prepares to write compressed data to it.
+ *
+ * @param filename The path to the file.
+ * @param compression COMPRESSION_GZIP or COMPRESSION_ZSTD.
+ * @param level Codec compression level, or 0 for the codec's default.
+ * @return A pointer to the compressor, or NULL on failure.
+ */
+Compressor *compressor_open(const char *filename, Compression compression, int level);
+
+/**
+ * Compresses size bytes and writes the output that is ready.
+ *
+ * @param compressor Pointer to the compressor.
+ * @param data The bytes to compress.
+ * @param size The number of bytes.
+ * @return 0 on success, -1 on failure.
+ */
+int compressor_write(Compressor *compressor, const char *data, size_t size);
+
+/**
+ * Finishes the compressed stream, closes the file and frees the compressor.
+ *
+ * @param compressor Pointer to the compressor.
+ * @return 0 on success, -1 if finishing, writing or closing failed.
+ */
+int compressor_close(Compressor *compressor);
+
+#endif // COMPRESS_H
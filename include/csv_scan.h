@@ -0,0 +1,95 @@
+#ifndef CSV_SCAN_H
+#define CSV_SCAN_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * A single field located inside a CSV buffer. The bytes are not copied: start
+ * points into the buffer being scanned and length excludes any enclosing quotes
+ * and, for unquoted fields, surrounding whitespace.
+ */
+typedef struct {
+    const char *start;  // First byte of the field contents
+    size_t length;      // Number of bytes in the field contents
+    int quoted;         // Non-zero if the field was enclosed in quotes
+    int escaped;        // Non-zero if the contents contain "" sequences
+} CsvField;
+
+/**
+ * Iterates over the records of a CSV buffer.
+ *
+ * The buffer is indexed one window at a time: each 64-byte block is classified
+ * into delimiter, quote and newline bitmasks with SIMD compares, quoted regions
+ * are removed with a prefix-XOR of the quote mask, and the offsets of the
+ * remaining separators are extracted from the bitmask. Fields are then cut
+ * between consecutive separators without looking at every byte again.
+ */
+typedef struct {
+    const char *end;        // End of the buffer
+    const char *window;     // Start of the currently indexed window
+    const char *scanned;    // First byte not indexed yet
+    const char *position;   // First byte of the next record
+    uint32_t *index;        // Separator offsets relative to window
+    size_t index_count;     // Number of offsets in index
+    size_t index_pos;       // Next offset to consume
+    uint64_t in_quotes;     // All ones if scanned lies inside a quoted field
+    int terminated;         // Whether the last record ended with a newline
+} CsvScanner;
+
+/**
+ * Prepares a scanner over [start, end).
+ *
+ * @param scanner The scanner to initialize.
+ * @param start First byte of the buffer.
+ * @param end One past the last byte of the buffer.
+ * @return 0 on success, -1 on failure.
+ */
+int csv_scanner_init(CsvScanner *scanner, const char *start, const char *end);
+
+/**
+ * Points an initialized scanner at a new buffer, reusing its index memory.
+ *
+ * @param scanner The scanner to reset.
+ * @param start First byte of the buffer.
+ * @param end One past the last byte of the buffer.
+ */
+void csv_scanner_reset(CsvScanner *scanner, const char *start, const char *end);
+
+/**
+ * Releases the memory owned by a scanner.
+ *
+ * @param scanner The scanner to release.
+ */
+void csv_scanner_free(CsvScanner *scanner);
+
+/**
+ * Locates the fields of the next record. At most max_fields fields are stored,
+ * but all fields are counted so callers can detect a mismatch.
+ *
+ * @param scanner The scanner.
+ * @param fields Array receiving the fields.
+ * @param max_fields Capacity of fields.
+ * @param num_fields Receives the number of fields in the record.
+ * @return 1 if a record was read, 0 at the end of the buffer. A record that
+ *         runs into the end of the buffer is returned with terminated unset.
+ */
+int csv_scanner_next_record(CsvScanner *scanner, CsvField *fields, size_t max_fields, size_t *num_fields);
+
+/**
+ * Copies the contents of a field into dst, collapsing escaped quotes. dst must
+ * hold at least field->length + 1 bytes.
+ *
+ * @param field The field to copy.
+ * @param dst Destination buffer, NUL-terminated on return.
+ * @return The number of bytes written, excluding the terminator.
+ */
+size_t csv_copy_field(const CsvField *field, char *dst);
+
+/**
+ * Returns the name of the block classifier picked for this CPU
+ * ("avx2", "sse2" or "scalar").
+ */
+const char *csv_scan_implementation(void);
+
+#endif // CSV_SCAN_H
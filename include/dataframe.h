@@ -1,7 +1,10 @@
 #ifndef DATAFRAME_H
 #define DATAFRAME_H
 
+#include <stdint.h>
 #include <stdlib.h>
+#include "dfalloc.h"
+#include "encoding.h"
 
 // Maximum length for column names
 #define MAX_COLUMN_NAME_LENGTH 64
@@ -10,14 +13,41 @@
 typedef enum {
     DATA_TYPE_INT = 0,
     DATA_TYPE_FLOAT = 1,
-    DATA_TYPE_STRING = 2
+    DATA_TYPE_STRING = 2,
+    DATA_TYPE_CATEGORICAL = 3
 } DataType;
 
+// Offset marking a NULL entry in a string column
+#define STRING_NULL_OFFSET ((size_t)-1)
+
+// Holds the strings of a column packed into one contiguous byte buffer.
+// Each row's offset points at a NUL-terminated string inside bytes.
+typedef struct {
+    char *bytes;      // Packed string contents
+    size_t *offsets;  // Start of each row's string in bytes, or STRING_NULL_OFFSET
+    size_t size;      // Number of bytes used in bytes
+    size_t capacity;  // Number of bytes allocated for bytes
+} StringData;
+
+// Holds a dictionary-encoded column: each row stores the code of its value in
+// a deduplicated dictionary of strings, indexed by a hash table.
+typedef struct {
+    int *codes;              // Dictionary code of each row, or -1 for NULL
+    StringData dictionary;   // Distinct values, dictionary.offsets is indexed by code
+    size_t num_categories;   // Number of distinct values
+    size_t offsets_capacity; // Entries allocated for dictionary.offsets and hashes
+    uint64_t *hashes;        // Hash of each distinct value
+    int *slots;              // Open-addressing table holding code + 1, 0 when empty
+    size_t num_slots;        // Size of slots, a power of two
+} CategoricalData;
+
 // Holds the data for a column in the form of type-specific arrays.
 typedef union {
     int *int_data;          
     float *float_data;
-    char **string_data;
+    StringData string_data;
+    CategoricalData categorical_data;
+    EncodedInts encoded_ints; // INT column whose encoding is not INT_ENCODING_PLAIN
 } ColumnData;
 
 // Represents a single column in a dataframe.
@@ -25,19 +55,32 @@ typedef struct {
     char name[MAX_COLUMN_NAME_LENGTH]; // Column name
     DataType type;                     // Data type of the column
     ColumnData data;                   // Union containing the actual data
+    int borrowed;                      // Nonzero when data points at memory the column does not own
+    IntEncoding encoding;              // Layout of an INT column, INT_ENCODING_PLAIN for other types
+    const DataFrameAllocator *allocator; // Allocator of the owning DataFrame
 } Column;
 
 // Represents a collection of columns and their associated data, forming a 2D data structure (dataframe).
-typedef struct {
-    Column *columns;    // Pointer to an array of Column structs
-    size_t num_columns; // Number of columns
-    size_t num_rows;    // Number of rows
+typedef struct DataFrame {
+    Column *columns;     // Pointer to an array of Column structs
+    size_t num_columns;  // Number of columns
+    size_t num_rows;     // Number of rows
+    size_t capacity;     // Rows allocated in every column, at least num_rows
+    void *mapping;       // File mapping that borrowed columns point into, or NULL
+    size_t mapping_size; // Size of the mapping in bytes
+    DataFrameAllocator allocator; // Serves the DataFrame and all of its column buffers
+    struct DataFrame *parent; // DataFrame whose buffers this view borrows, or NULL
+    size_t refcount;     // One for the owner plus one per live view of this DataFrame
+    size_t *name_slots;  // Open-addressing table of column index + 1 by name hash, 0 when empty
+    size_t num_name_slots; // Size of name_slots, a power of two at least twice num_columns
 } DataFrame;
 
 // Function Prototypes
 
 /**
- * Creates a new DataFrame with the specified number of rows and columns.
+ * Creates a new DataFrame with the specified number of rows and columns. The
+ * columns are allocated for exactly num_rows rows; append_row and append_rows
+ * grow them as needed.
  *
  * @param num_rows The number of rows in the DataFrame.
  * @param num_columns The number of columns in the DataFrame.
@@ -46,7 +89,24 @@ typedef struct {
 DataFrame *create_dataframe(size_t num_rows, size_t num_columns);
 
 /**
- * Adds a column to the DataFrame at the specified index.
+ * Creates a new DataFrame whose memory, including every column buffer added
+ * later, comes from the given allocator. The hooks are copied, their context
+ * must outlive the DataFrame. DataFrames derived from it, such as the results
+ * of take_rows, use the default allocator.
+ *
+ * With an arena, buffers that grow leave their old copy behind in the arena
+ * until it is freed, so reserve_rows up front keeps the footprint down.
+ *
+ * @param num_rows The number of rows in the DataFrame.
+ * @param num_columns The number of columns in the DataFrame.
+ * @param allocator The allocator hooks, or NULL for malloc.
+ * @return A pointer to the newly created DataFrame, or NULL on failure.
+ */
+DataFrame *create_dataframe_with_allocator(size_t num_rows, size_t num_columns, const DataFrameAllocator *allocator);
+
+/**
+ * Adds a column to the DataFrame at the specified index. Fails if another
+ * column already has the name.
  *
  * @param df Pointer to the DataFrame.
  * @param column_index The index at which to add the column.
@@ -56,6 +116,105 @@ DataFrame *create_dataframe(size_t num_rows, size_t num_columns);
  */
 int add_column(DataFrame *df, DataType type, size_t column_index, const char *name);
 
+/**
+ * Adds a column whose data lives in memory owned by the caller, such as a
+ * mapped file, without copying it. The column is copy-on-write: the first call
+ * that modifies it copies its data into memory owned by the DataFrame. The
+ * memory must stay valid until then or until the DataFrame is destroyed.
+ *
+ * For CATEGORICAL columns, codes, dictionary.bytes, dictionary.offsets,
+ * dictionary.size and num_categories must be set; the hash table used to look
+ * up categories is built by this call.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param type The data type of the column.
+ * @param column_index The index at which to add the column.
+ * @param name The name of the column.
+ * @param data The column's data, with num_rows entries.
+ * @return 0 on success, -1 on failure.
+ */
+int attach_column(DataFrame *df, DataType type, size_t column_index, const char *name, const ColumnData *data);
+
+/**
+ * Adds an INT column holding a copy of num_rows values, stored compressed.
+ * Compressed columns are read in place by get_value, aggregations, filters,
+ * group-bys, joins, sorts and the writers; a call that modifies the column or
+ * appends rows decodes it back to plain ints first.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column_index The index at which to add the column.
+ * @param name The name of the column.
+ * @param values Array of num_rows values.
+ * @param encoding INT_ENCODING_RLE, FOR, DELTA, AUTO, or PLAIN for no compression.
+ * @return 0 on success, -1 on failure.
+ */
+int add_int_column(DataFrame *df, size_t column_index, const char *name, const int *values, IntEncoding encoding);
+
+/**
+ * Compresses an existing INT column. Suits columns that are filled first and
+ * then mostly read, such as sorted timestamps, low-range codes or long runs
+ * of one value.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT column.
+ * @param encoding INT_ENCODING_RLE, FOR, DELTA or AUTO to pick the smallest,
+ *                 or PLAIN to decode the column.
+ * @return 0 on success, -1 on failure.
+ */
+int encode_int_column(DataFrame *df, size_t column, IntEncoding encoding);
+
+/**
+ * Returns the index of the column with the given name. Names are kept in a
+ * hash index updated by add_column, attach_column and add_int_column, so the
+ * lookup takes constant time however wide the DataFrame is.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param name The column name.
+ * @return The column index, or -1 if no column has the name.
+ */
+int find_column(const DataFrame *df, const char *name);
+
+/**
+ * Grows every column to hold at least capacity rows without changing num_rows.
+ * New entries are 0 for INT and FLOAT columns and NULL otherwise. Borrowed
+ * columns are copied first. Never shrinks the DataFrame.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param capacity The number of rows to allocate.
+ * @return 0 on success, -1 on failure.
+ */
+int reserve_rows(DataFrame *df, size_t capacity);
+
+/**
+ * Releases the rows allocated beyond num_rows.
+ *
+ * @param df Pointer to the DataFrame.
+ * @return 0 on success, -1 on failure.
+ */
+int shrink_to_fit(DataFrame *df);
+
+/**
+ * Appends one row. When the columns are full their capacity is doubled, so n
+ * appends reallocate each column O(log n) times.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param values Array of num_columns pointers to values as for set_value, where
+ *               a NULL pointer stores 0 or NULL.
+ * @return 0 on success, -1 on failure, in which case num_rows is unchanged.
+ */
+int append_row(DataFrame *df, const void *const *values);
+
+/**
+ * Appends a batch of rows with at most one reallocation per column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param values Array of num_columns arrays of count values as for set_values,
+ *               where a NULL array stores 0 or NULL.
+ * @param count The number of rows to append.
+ * @return 0 on success, -1 on failure, in which case num_rows is unchanged.
+ */
+int append_rows(DataFrame *df, const void *const *values, size_t count);
+
 /**
  * Sets a value in the DataFrame at the specified row and column.
  *
@@ -67,8 +226,24 @@ int add_column(DataFrame *df, DataType type, size_t column_index, const char *na
  */
 int set_value(DataFrame *df, size_t row, size_t column, const void *value);
 
+/**
+ * Sets a string value from a buffer that need not be NUL-terminated. For STRING
+ * columns the bytes are appended to the column's string buffer; for CATEGORICAL
+ * columns the value is looked up in, or added to, the dictionary.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param row The row index.
+ * @param column The column index of a STRING or CATEGORICAL column.
+ * @param value Pointer to the first byte of the string.
+ * @param length The number of bytes in the string.
+ * @return 0 on success, -1 on failure.
+ */
+int set_string_value(DataFrame *df, size_t row, size_t column, const char *value, size_t length);
+
 /**
  * Gets a value from the DataFrame at the specified row and column.
+ * Strings are returned as pointers into the column's buffer and remain valid
+ * until the next string is written to the same column.
  *
  * @param df Pointer to the DataFrame.
  * @param row The row index.
@@ -78,9 +253,226 @@ int set_value(DataFrame *df, size_t row, size_t column, const void *value);
  */
 int get_value(const DataFrame *df, size_t row, size_t column, void *output);
 
+/**
+ * Gets the contiguous values of an INT column so hot loops can run over raw
+ * memory instead of calling get_value per cell. Fails for encoded columns,
+ * which have no contiguous ints.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of an INT column.
+ * @param data Receives a pointer to the first value.
+ * @param length Receives the number of values (the row count).
+ * @return 0 on success, -1 on failure.
+ */
+int get_int_span(const DataFrame *df, size_t column, const int **data, size_t *length);
+
+/**
+ * Gets the contiguous values of a FLOAT column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of a FLOAT column.
+ * @param data Receives a pointer to the first value.
+ * @param length Receives the number of values (the row count).
+ * @return 0 on success, -1 on failure.
+ */
+int get_float_span(const DataFrame *df, size_t column, const float **data, size_t *length);
+
+/**
+ * Gets the contiguous dictionary codes of a CATEGORICAL column.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index of a CATEGORICAL column.
+ * @param codes Receives a pointer to the first code.
+ * @param length Receives the number of codes (the row count).
+ * @return 0 on success, -1 on failure.
+ */
+int get_category_codes(const DataFrame *df, size_t column, const int **codes, size_t *length);
+
+/**
+ * Sets a range of rows of a column from an array in one call.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index.
+ * @param start_row The first row to set.
+ * @param count The number of rows to set.
+ * @param values Array of count values: int for INT, float for FLOAT and
+ *               const char * (NULL allowed) for STRING and CATEGORICAL columns.
+ * @return 0 on success, -1 on failure.
+ */
+int set_values(DataFrame *df, size_t column, size_t start_row, size_t count, const void *values);
+
+/**
+ * Sets a range of rows of a column to the same value. String values are stored
+ * once and shared by every row of the range.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index.
+ * @param start_row The first row to set.
+ * @param count The number of rows to set.
+ * @param value Pointer to the value, as for set_value.
+ * @return 0 on success, -1 on failure.
+ */
+int fill_values(DataFrame *df, size_t column, size_t start_row, size_t count, const void *value);
+
+/**
+ * Copies a range of rows from a column of one DataFrame into a column of the
+ * same type in another (or the same) DataFrame.
+ *
+ * @param dst Pointer to the destination DataFrame.
+ * @param dst_column The destination column index.
+ * @param dst_row The first destination row.
+ * @param src Pointer to the source DataFrame.
+ * @param src_column The source column index.
+ * @param src_row The first source row.
+ * @param count The number of rows to copy.
+ * @return 0 on success, -1 on failure.
+ */
+int copy_values(DataFrame *dst, size_t dst_column, size_t dst_row,
+                const DataFrame *src, size_t src_column, size_t src_row, size_t count);
+
+/**
+ * Row index that gather_values turns into a NULL (or 0 for INT and FLOAT
+ * columns), used for rows without a match.
+ */
+#define GATHER_NULL_ROW ((size_t)-1)
+
+/**
+ * Gathers rows of a source column, in the order given, into the first count
+ * rows of a column of the same type. Strings are copied with one reservation
+ * for the whole gather and categorical codes are translated once per distinct
+ * code. The source and destination must be different columns.
+ *
+ * @param dst Pointer to the destination DataFrame.
+ * @param dst_column The destination column index.
+ * @param src Pointer to the source DataFrame.
+ * @param src_column The source column index.
+ * @param rows Array of count source row indices, or GATHER_NULL_ROW.
+ * @param count The number of rows to gather.
+ * @return 0 on success, -1 on failure.
+ */
+int gather_values(DataFrame *dst, size_t dst_column, const DataFrame *src, size_t src_column,
+                  const size_t *rows, size_t count);
+
+/**
+ * Creates a new DataFrame with the same columns as df holding the given rows
+ * in the given order. Used to materialize filters, joins and sorts.
+ *
+ * @param df Pointer to the source DataFrame.
+ * @param rows Array of count row indices, or GATHER_NULL_ROW.
+ * @param count The number of rows of the new DataFrame.
+ * @return A pointer to the new DataFrame, or NULL on failure.
+ */
+DataFrame *take_rows(const DataFrame *df, const size_t *rows, size_t count);
+
+/**
+ * Creates a view of a range of rows without copying any cells. The view's
+ * columns borrow the buffers of df at an offset and are copy-on-write like
+ * attached columns, so modifying the view never changes df. CATEGORICAL
+ * columns copy their lookup table, and an encoded INT column is decoded unless
+ * the view covers all of its rows.
+ *
+ * While a view is alive df is read-only: calls that would modify it fail.
+ * Views and df may be destroyed in any order, from any thread; df's memory is
+ * released once it and all of its views are destroyed.
+ *
+ * @param df Pointer to the DataFrame, which may itself be a view.
+ * @param start_row The first row of the view.
+ * @param count The number of rows of the view.
+ * @return A pointer to the view, or NULL on failure.
+ */
+DataFrame *slice_rows(const DataFrame *df, size_t start_row, size_t count);
+
+/**
+ * Creates a view of a subset of columns, in the given order, without copying
+ * any cells. Views work as described for slice_rows.
+ *
+ * @param df Pointer to the DataFrame, which may itself be a view.
+ * @param columns Indices of the columns of the view, each at most once.
+ * @param count The number of columns of the view.
+ * @return A pointer to the view, or NULL on failure.
+ */
+DataFrame *select_columns(const DataFrame *df, const size_t *columns, size_t count);
+
+/**
+ * Returns the string stored in a row of a STRING column without bounds checks.
+ *
+ * @param column Pointer to a STRING column.
+ * @param row The row index.
+ * @return The NUL-terminated string, or NULL if the entry is NULL.
+ */
+static inline const char *column_string(const Column *column, size_t row) {
+    size_t offset = column->data.string_data.offsets[row];
+    return offset == STRING_NULL_OFFSET ? NULL : column->data.string_data.bytes + offset;
+}
+
+/**
+ * Returns the value stored in a row of an INT column, plain or encoded,
+ * without bounds checks.
+ *
+ * @param column Pointer to an INT column.
+ * @param row The row index.
+ * @return The value.
+ */
+static inline int column_int(const Column *column, size_t row) {
+    if (column->encoding == INT_ENCODING_PLAIN) {
+        return column->data.int_data[row];
+    }
+    return encoded_int_at(&column->data.encoded_ints, row);
+}
+
+/**
+ * Returns the dictionary code of a value in a CATEGORICAL column, adding the
+ * value to the dictionary if it is not there yet. The column must not be
+ * borrowed; set_string_value copies a borrowed column first.
+ *
+ * @param column Pointer to a CATEGORICAL column.
+ * @param value Pointer to the first byte of the value.
+ * @param length The number of bytes in the value.
+ * @return The code of the value, or -1 on failure.
+ */
+int intern_category(Column *column, const char *value, size_t length);
+
+/**
+ * Looks up the dictionary code of a value in a CATEGORICAL column. Filters and
+ * group-bys use it to turn string comparisons into integer comparisons.
+ *
+ * @param column Pointer to a CATEGORICAL column.
+ * @param value Pointer to the first byte of the value.
+ * @param length The number of bytes in the value.
+ * @return The code of the value, or -1 if the value does not occur.
+ */
+int find_category(const Column *column, const char *value, size_t length);
+
+/**
+ * Returns the dictionary entry for a code of a CATEGORICAL column.
+ *
+ * @param column Pointer to a CATEGORICAL column.
+ * @param code A code in [0, num_categories), or -1.
+ * @return The NUL-terminated value, or NULL for code -1.
+ */
+static inline const char *category_string(const Column *column, int code) {
+    const CategoricalData *categorical = &column->data.categorical_data;
+    return code < 0 ? NULL : categorical->dictionary.bytes + categorical->dictionary.offsets[code];
+}
+
+/**
+ * Returns the string stored in a row of a STRING or CATEGORICAL column without
+ * bounds checks.
+ *
+ * @param column Pointer to a STRING or CATEGORICAL column.
+ * @param row The row index.
+ * @return The NUL-terminated string, or NULL if the entry is NULL.
+ */
+static inline const char *column_text(const Column *column, size_t row) {
+    if (column->type == DATA_TYPE_CATEGORICAL) {
+        return category_string(column, column->data.categorical_data.codes[row]);
+    }
+    return column_string(column, row);
+}
 
 /**
- * Frees all allocated memory within the DataFrame.
+ * Frees all allocated memory within the DataFrame. A DataFrame with live
+ * views is released by the last of them to be destroyed.
  *
  * @param df Pointer to the DataFrame to destroy.
  */
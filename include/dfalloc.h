@@ -0,0 +1,113 @@
+#ifndef DFALLOC_H
+#define DFALLOC_H
+
+#include <stdlib.h>
+
+/**
+ * Memory hooks used for everything a DataFrame allocates: the DataFrame
+ * itself, its column array and every column buffer. reallocate must accept a
+ * NULL pointer, like realloc.
+ *
+ * When destroy is set, destroy_dataframe calls it once instead of releasing
+ * each buffer, which lets an arena that holds a single DataFrame drop the
+ * whole frame in one call.
+ */
+typedef struct {
+    void *(*allocate)(void *context, size_t size);
+    void *(*reallocate)(void *context, void *ptr, size_t size);
+    void (*release)(void *context, void *ptr);
+    void (*destroy)(void *context); // Releases everything at once, or NULL
+    void *context;                  // Passed to every hook
+} DataFrameAllocator;
+
+/**
+ * Bump allocator serving allocations from large blocks. Individual frees are
+ * ignored except for the most recent allocation, which can also be grown or
+ * shrunk in place; memory is returned all at once by arena_reset or
+ * arena_destroy. An arena is not thread-safe.
+ */
+typedef struct DataFrameArena DataFrameArena;
+
+/**
+ * Returns the allocator backed by malloc, realloc and free.
+ */
+const DataFrameAllocator *default_allocator(void);
+
+/**
+ * Creates an empty arena.
+ *
+ * @param block_size Size of the blocks requested from malloc, or 0 for 1 MiB.
+ *                   Larger allocations get a block of their own.
+ * @return A pointer to the new arena, or NULL on failure.
+ */
+DataFrameArena *arena_create(size_t block_size);
+
+/**
+ * Allocates size bytes aligned to 16 bytes.
+ *
+ * @param arena Pointer to the arena.
+ * @param size The number of bytes.
+ * @return A pointer to the memory, or NULL on failure.
+ */
+void *arena_alloc(DataFrameArena *arena, size_t size);
+
+/**
+ * Resizes an allocation. The most recent allocation is resized in place when
+ * its block has room; others are copied to a new allocation.
+ *
+ * @param arena Pointer to the arena.
+ * @param ptr An allocation of this arena, or NULL.
+ * @param size The new size in bytes.
+ * @return A pointer to the memory, or NULL on failure, in which case ptr is unchanged.
+ */
+void *arena_realloc(DataFrameArena *arena, void *ptr, size_t size);
+
+/**
+ * Frees an allocation. Only the most recent allocation is actually reused.
+ *
+ * @param arena Pointer to the arena.
+ * @param ptr An allocation of this arena, or NULL.
+ */
+void arena_free(DataFrameArena *arena, void *ptr);
+
+/**
+ * Discards every allocation but keeps the blocks for reuse.
+ *
+ * @param arena Pointer to the arena.
+ */
+void arena_reset(DataFrameArena *arena);
+
+/**
+ * Returns the number of bytes held in blocks.
+ *
+ * @param arena Pointer to the arena.
+ */
+size_t arena_capacity(const DataFrameArena *arena);
+
+/**
+ * Frees the arena and all of its blocks.
+ *
+ * @param arena Pointer to the arena, may be NULL.
+ */
+void arena_destroy(DataFrameArena *arena);
+
+/**
+ * Returns allocator hooks that serve allocations from an arena.
+ *
+ * With owned set, the DataFrame created with the hooks takes ownership of the
+ * arena and destroy_dataframe frees it, so teardown costs one free per block
+ * whatever the number of columns and strings. The arena must then hold only
+ * that DataFrame. Without owned, several DataFrames can share the arena and
+ * the caller destroys it after them.
+ *
+ * The hand-over only happens once a DataFrame is returned. A function that
+ * fails and returns NULL never destroys the arena, even if it had already
+ * started building the DataFrame, so the caller still destroys it then.
+ *
+ * @param arena Pointer to the arena.
+ * @param owned Nonzero to hand the arena over to the DataFrame.
+ * @return The allocator hooks.
+ */
+DataFrameAllocator arena_allocator(DataFrameArena *arena, int owned);
+
+#endif // DFALLOC_H
@@ -0,0 +1,71 @@
+#ifndef DFHASH_H
+#define DFHASH_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Hash functions shared by the hash tables of the library (categorical
+ * dictionaries, group-by, joins). They are fast non-cryptographic mixes and
+ * must not be used where an adversary controls the keys.
+ */
+
+/**
+ * Scrambles the bits of a 64-bit value (the MurmurHash3 finalizer).
+ *
+ * @param value The value to mix.
+ * @return The mixed value.
+ */
+static inline uint64_t hash_mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * Hashes an integer key.
+ *
+ * @param value The key.
+ * @return The hash of the key.
+ */
+static inline uint64_t hash_int(int64_t value) {
+    return hash_mix((uint64_t)value);
+}
+
+/**
+ * Combines the hash of one more key column into the hash of a composite key.
+ *
+ * @param seed The hash of the preceding key columns.
+ * @param value The hash of the next key column.
+ * @return The hash of the combined key.
+ */
+static inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * Hashes a byte string eight bytes at a time.
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @return The hash of the bytes.
+ */
+static inline uint64_t hash_bytes(const void *data, size_t length) {
+    const unsigned char *ptr = data;
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (uint64_t)length;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, ptr, 8);
+        hash = (hash ^ hash_mix(word)) * 0x9e3779b97f4a7c15ULL;
+        ptr += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, ptr, length);
+    return hash_mix(hash ^ tail);
+}
+
+#endif // DFHASH_H
@@ -3,15 +3,49 @@
 
 #include <stdlib.h>
 #include "dataframe.h"
+#include "readahead.h"
+
+// Options for writing CSV files
+typedef struct {
+    int float_precision;     // Digits after the decimal point for FLOAT columns
+    Compression compression; // Output compression; COMPRESSION_AUTO picks it from the file name
+    int compression_level;   // Codec compression level, or 0 for the codec's default
+} CsvWriteOptions;
+
+/*
+ * Files whose names end in .gz or .zst are compressed and decompressed on the
+ * fly by every reader and writer below: readers decompress on a background
+ * thread ahead of parsing, and writers compress each buffer as it is flushed.
+ * zstd needs a build made with ZSTD=1.
+ */
+
+// Options for reading CSV files
+typedef struct {
+    const char *const *columns;          // Names of the columns to load, one per type, or NULL for every column
+    const DataFrameAllocator *allocator; // Allocator for the new DataFrame, or NULL for malloc
+} CsvReadOptions;
 
 /**
  * Saves the DataFrame to a CSV file.
+ * FLOAT columns are written with two decimals. Names ending in .gz or .zst
+ * are written compressed.
  *
  * @param df Pointer to the DataFrame.
  * @param filename The name of the CSV file.
  */
 void save_to_csv(const DataFrame *df, const char *filename);
 
+/**
+ * Saves the DataFrame to a CSV file with the given options.
+ * Rows are formatted into a large buffer that is written with few system calls.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param filename The name of the CSV file.
+ * @param options Output options, or NULL for the defaults.
+ * @return 0 on success, -1 on failure.
+ */
+int save_to_csv_with_options(const DataFrame *df, const char *filename, const CsvWriteOptions *options);
+
 /**
  * Prints the DataFrame to the console (for debugging).
  *
@@ -22,6 +56,8 @@ void print_dataframe(const DataFrame *df);
 
 /**
  * @brief Creates a dataframe from a CSV file
+ *
+ * Compressed files are read as read_csv_pipelined reads them.
  * 
  * @param filename 
  * @param types 
@@ -30,4 +66,160 @@ void print_dataframe(const DataFrame *df);
  */
 DataFrame *read_csv(const char *filename, DataType *types, size_t num_columns);
 
+/**
+ * @brief Creates a dataframe from a memory-mapped CSV file
+ *
+ * Finds row boundaries and parses fields in a single pass over the mapped
+ * bytes. Lines have no length limit and quoted fields may span lines.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @return DataFrame* The created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_mmap(const char *filename, DataType *types, size_t num_columns);
+
+/**
+ * @brief Creates a dataframe from a subset of the columns of a CSV file
+ *
+ * Reads through a memory mapping like read_csv_mmap, but only materializes the
+ * columns named in options->columns, in that order. The fields of the other
+ * columns are located by the tokenizer and skipped: they are neither copied
+ * nor converted, and fields after the last named column are not even cut out
+ * of the record. Every record must still have as many fields as the header.
+ * Without a column list every column is loaded. The DataFrame's memory comes
+ * from options->allocator, so a whole-frame arena makes its teardown O(1).
+ * An owned arena belongs to the returned DataFrame; when the read fails the
+ * arena is left untouched and stays with the caller.
+ * Compressed files cannot be mapped; they are streamed instead and must be
+ * read without a column list.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each named column.
+ * @param num_columns The number of named columns, or of all columns without a column list.
+ * @param options Read options, or NULL to read every column as read_csv_mmap does.
+ * @return DataFrame* The created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_with_options(const char *filename, DataType *types, size_t num_columns,
+                                 const CsvReadOptions *options);
+
+/**
+ * @brief Creates a dataframe from a CSV file using several threads
+ *
+ * The file is cut into byte ranges that are resolved to record boundaries,
+ * taking quoted fields that contain newlines into account. Each chunk is parsed
+ * on its own thread and the chunks are stitched together in file order. Quote
+ * characters are assumed to follow RFC 4180, i.e. only appear around fields or
+ * doubled inside quoted fields.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param num_threads The number of threads to use, or 0 for one per online CPU.
+ * @return DataFrame* The created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_parallel(const char *filename, DataType *types, size_t num_columns, size_t num_threads);
+
+/**
+ * @brief Creates a dataframe from a CSV file while a background thread reads ahead
+ *
+ * Reads the file through a ring of blocks filled by a reader thread, so disk
+ * reads overlap with tokenizing and converting. Unlike read_csv_mmap the file
+ * is never mapped, which suits pipes, network file systems and direct I/O.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param options Read-ahead tuning, or NULL for the defaults.
+ * @return DataFrame* The created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_pipelined(const char *filename, DataType *types, size_t num_columns,
+                              const ReadAheadOptions *options);
+
+/**
+ * Streaming CSV reader that yields fixed-size batches of rows. Its input
+ * buffer and batch DataFrame are reused, so peak memory depends on the batch
+ * size rather than the size of the file.
+ */
+typedef struct CsvReader CsvReader;
+
+/**
+ * @brief Opens a streaming CSV reader and reads the header
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param batch_size The maximum number of rows per batch.
+ * @return CsvReader* The reader, or NULL on failure.
+ */
+CsvReader *csv_reader_open(const char *filename, DataType *types, size_t num_columns, size_t batch_size);
+
+/**
+ * @brief Opens a streaming CSV reader whose input is read ahead on a background thread
+ *
+ * A reader thread fills a ring of aligned blocks from the file while the
+ * caller parses, so reading and parsing overlap. Batches are produced exactly
+ * as csv_reader_open's are.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param batch_size The maximum number of rows per batch.
+ * @param options Read-ahead tuning, or NULL for the defaults.
+ * @return CsvReader* The reader, or NULL on failure.
+ */
+CsvReader *csv_reader_open_pipelined(const char *filename, DataType *types, size_t num_columns, size_t batch_size,
+                                     const ReadAheadOptions *options);
+
+/**
+ * @brief Reads the next batch of rows
+ *
+ * The batch is owned by the reader and is overwritten by the next call.
+ * Categorical dictionaries carry over between batches, so codes are stable
+ * for the whole file.
+ *
+ * @param reader The reader.
+ * @param batch Receives the batch; batch->num_rows holds its row count.
+ * @return int 1 if a batch was read, 0 at the end of the input, -1 on failure.
+ */
+int csv_reader_next_batch(CsvReader *reader, DataFrame **batch);
+
+/**
+ * @brief Closes a streaming CSV reader and frees its batch
+ *
+ * @param reader The reader.
+ */
+void csv_reader_close(CsvReader *reader);
+
+/**
+ * @brief Saves the DataFrame in the binary columnar format
+ *
+ * The file holds a header with the schema followed by each column's arrays as
+ * they are laid out in memory, every block aligned to 64 bytes. Strings are
+ * stored as offsets plus bytes. Files are only readable on machines with the
+ * same byte order and word size.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param filename The name of the binary file.
+ * @return int 0 on success, -1 on failure.
+ */
+int save_binary(const DataFrame *df, const char *filename);
+
+/**
+ * @brief Loads a DataFrame written by save_binary
+ *
+ * The file is memory-mapped and the columns point into the mapping, so nothing
+ * is parsed or copied and pages are read on first access. The columns are
+ * borrowed: a column is copied into memory of its own the first time it is
+ * modified. The header, the block layout and the row contents are validated:
+ * every string offset must fall inside its column's bytes and every category
+ * code must name a category, so a corrupt file is rejected instead of read out
+ * of bounds. This reads each offset and code once. Categorical dictionaries
+ * are hashed on load.
+ *
+ * @param filename The path to the binary file.
+ * @return DataFrame* The loaded DataFrame, or NULL on failure.
+ */
+DataFrame *load_binary(const char *filename);
+
 #endif //DFIO_H
\ No newline at end of file
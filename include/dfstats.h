@@ -0,0 +1,116 @@
+#ifndef DFSTATS_H
+#define DFSTATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Event counters
+typedef enum {
+    STATS_BYTES_READ = 0,    // Bytes of input read or mapped
+    STATS_BYTES_WRITTEN = 1, // Bytes of output written
+    STATS_ROWS_PARSED = 2,   // Records stored into DataFrames by the readers
+    STATS_ROWS_WRITTEN = 3,  // Rows formatted by the writers
+    STATS_ALLOCATIONS = 4,   // Column and string buffer allocations and reallocations
+    STATS_NUM_COUNTERS = 5
+} StatsCounter;
+
+// Timed stages
+typedef enum {
+    STAGE_READ = 0,     // Reading or mapping input
+    STAGE_TOKENIZE = 1, // Splitting records into fields
+    STAGE_CONVERT = 2,  // Converting fields to numbers and storing strings
+    STAGE_FORMAT = 3,   // Formatting rows for output
+    STAGE_WRITE = 4,    // Writing output
+    STATS_NUM_STAGES = 5
+} StatsStage;
+
+// Totals over every thread since the last reset. The readers time a window of
+// records per interval rather than each record.
+typedef struct {
+    uint64_t counters[STATS_NUM_COUNTERS];  // Indexed by StatsCounter
+    uint64_t stage_ns[STATS_NUM_STAGES];    // Nanoseconds spent in each stage
+    uint64_t stage_calls[STATS_NUM_STAGES]; // Number of timed intervals per stage
+} DataFrameStats;
+
+/**
+ * Instrumentation is compiled in when the library is built with
+ * DF_ENABLE_STATS defined (make STATS=1). Each thread then updates counters of
+ * its own, so updates need no locks or atomic read-modify-writes; snapshots
+ * add up the counters of all threads. Without the flag the macros below
+ * expand to nothing and snapshots are all zero.
+ */
+#ifdef DF_ENABLE_STATS
+#define STATS_ADD(counter, amount) stats_add((counter), (uint64_t)(amount))
+#define STATS_TIMER_START(timer) uint64_t timer = stats_now()
+#define STATS_TIMER_STOP(timer, stage) stats_record((stage), stats_now() - (timer))
+#else
+#define STATS_ADD(counter, amount) ((void)0)
+#define STATS_TIMER_START(timer) ((void)0)
+#define STATS_TIMER_STOP(timer, stage) ((void)0)
+#endif
+
+/**
+ * Adds to a counter of the calling thread. Use STATS_ADD instead, which
+ * compiles out.
+ *
+ * @param counter The counter.
+ * @param amount The amount to add.
+ */
+void stats_add(StatsCounter counter, uint64_t amount);
+
+/**
+ * Adds a timed interval to a stage of the calling thread. Use
+ * STATS_TIMER_STOP instead, which compiles out.
+ *
+ * @param stage The stage.
+ * @param ns The length of the interval in nanoseconds.
+ */
+void stats_record(StatsStage stage, uint64_t ns);
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ */
+uint64_t stats_now(void);
+
+/**
+ * Returns whether instrumentation was compiled in.
+ */
+int stats_enabled(void);
+
+/**
+ * Adds up the counters of every thread, including threads that have exited.
+ * Counters of running threads are read without stopping them, so a snapshot
+ * taken during an operation may be slightly behind.
+ *
+ * @param stats Receives the totals.
+ */
+void stats_snapshot(DataFrameStats *stats);
+
+/**
+ * Sets every counter of every thread to zero. Should not run concurrently
+ * with instrumented operations.
+ */
+void stats_reset(void);
+
+/**
+ * Returns the name of a counter, such as "bytes_read".
+ */
+const char *stats_counter_name(StatsCounter counter);
+
+/**
+ * Returns the name of a stage, such as "tokenize".
+ */
+const char *stats_stage_name(StatsStage stage);
+
+/**
+ * Writes a snapshot as a single-line JSON object holding "enabled", a
+ * "counters" object and a "stages" object with the nanoseconds and calls of
+ * each stage.
+ *
+ * @param stats The snapshot to write.
+ * @param out The stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+int stats_dump(const DataFrameStats *stats, FILE *out);
+
+#endif // DFSTATS_H
@@ -0,0 +1,99 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "dfalloc.h"
+
+// Storage layouts of INT columns
+typedef enum {
+    INT_ENCODING_PLAIN = 0, // One int per row
+    INT_ENCODING_RLE = 1,   // Runs of equal values
+    INT_ENCODING_FOR = 2,   // Frame of reference: value minus the column minimum, bit-packed
+    INT_ENCODING_DELTA = 3, // Difference to the previous row minus the smallest difference, bit-packed
+    INT_ENCODING_AUTO = 4   // Whichever of RLE, FOR and DELTA is smallest, only accepted by encoders
+} IntEncoding;
+
+// Rows per DELTA block; each block restarts from a stored anchor value
+#define DELTA_BLOCK_ROWS 128
+
+/**
+ * A compressed INT column. The fields used depend on the encoding: RLE keeps
+ * runs, FOR and DELTA keep bit_width bits per row in packed. min and max are
+ * kept for every encoding so scans can skip work the range already decides.
+ */
+typedef struct {
+    IntEncoding encoding; // RLE, FOR or DELTA
+    size_t num_values;    // Number of rows
+    int min;              // Smallest value, INT_MAX when empty
+    int max;              // Largest value, INT_MIN when empty
+    int *run_values;      // RLE: value of each run
+    size_t *run_ends;     // RLE: one past the last row of each run, ascending
+    size_t num_runs;      // RLE: number of runs
+    uint64_t *packed;     // FOR and DELTA: bit_width bits per row, low bits first
+    unsigned bit_width;   // FOR and DELTA: bits per row, 0 when all packed values are 0
+    int64_t reference;    // FOR: the minimum; DELTA: the smallest difference
+    int *anchors;         // DELTA: value of the first row of each block
+} EncodedInts;
+
+/**
+ * Compresses an array of ints.
+ *
+ * @param values The values to encode.
+ * @param count The number of values.
+ * @param encoding RLE, FOR, DELTA or AUTO.
+ * @param allocator Allocator for the encoded buffers.
+ * @param encoded Receives the encoded values.
+ * @return 0 on success, -1 on failure.
+ */
+int encode_ints(const int *values, size_t count, IntEncoding encoding, const DataFrameAllocator *allocator,
+                EncodedInts *encoded);
+
+/**
+ * Decodes a range of values.
+ *
+ * @param encoded The encoded values.
+ * @param start The first row to decode.
+ * @param count The number of rows to decode.
+ * @param out Receives count values.
+ */
+void decode_ints(const EncodedInts *encoded, size_t start, size_t count, int *out);
+
+/**
+ * Returns the value of one row. RLE rows are found by binary search over the
+ * runs, DELTA rows by adding up to DELTA_BLOCK_ROWS - 1 differences.
+ *
+ * @param encoded The encoded values.
+ * @param row The row index.
+ */
+int encoded_int_at(const EncodedInts *encoded, size_t row);
+
+/**
+ * Returns the index of the RLE run holding a row.
+ *
+ * @param encoded RLE encoded values.
+ * @param row The row index.
+ */
+size_t encoded_run_at(const EncodedInts *encoded, size_t row);
+
+/**
+ * Returns the number of bytes held by the encoded buffers.
+ *
+ * @param encoded The encoded values.
+ */
+size_t encoded_ints_size(const EncodedInts *encoded);
+
+/**
+ * Releases the encoded buffers.
+ *
+ * @param encoded The encoded values.
+ * @param allocator The allocator that encode_ints used.
+ */
+void free_encoded_ints(EncodedInts *encoded, const DataFrameAllocator *allocator);
+
+/**
+ * Returns the name of an encoding, such as "rle".
+ */
+const char *int_encoding_name(IntEncoding encoding);
+
+#endif // ENCODING_H
@@ -0,0 +1,118 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "dataframe.h"
+
+// Comparison applied between each row of a column and a constant
+typedef enum {
+    COMPARE_EQ = 0,
+    COMPARE_NE = 1,
+    COMPARE_LT = 2,
+    COMPARE_LE = 3,
+    COMPARE_GT = 4,
+    COMPARE_GE = 5
+} CompareOp;
+
+/**
+ * A set of rows stored as a bitmap, one bit per row. Bits past num_rows are
+ * always zero so masks can be combined and counted a word at a time.
+ */
+typedef struct {
+    uint64_t *words;  // Bit i % 64 of word i / 64 is set when row i is selected
+    size_t num_rows;  // Number of rows covered by the mask
+} RowMask;
+
+/**
+ * Prepares an empty mask over num_rows rows.
+ *
+ * @param mask The mask to initialize.
+ * @param num_rows The number of rows.
+ * @return 0 on success, -1 on failure.
+ */
+int row_mask_init(RowMask *mask, size_t num_rows);
+
+/**
+ * Releases the memory owned by a mask.
+ *
+ * @param mask The mask to free.
+ */
+void row_mask_free(RowMask *mask);
+
+/**
+ * Evaluates column <op> value for every row into a mask, replacing its
+ * contents. INT and FLOAT columns are compared 64 rows at a time with
+ * branch-free SIMD compares. CATEGORICAL columns compare codes, looking the
+ * value up in the dictionary once. NULL strings never match, and neither do
+ * NaNs except for COMPARE_NE.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param column The column index.
+ * @param op The comparison.
+ * @param value Pointer to an int for INT, a float for FLOAT, or a
+ *              NUL-terminated string for STRING and CATEGORICAL columns.
+ *              Strings are ordered by strcmp.
+ * @param mask An initialized mask over df->num_rows rows.
+ * @return 0 on success, -1 on failure.
+ */
+int filter_compare(const DataFrame *df, size_t column, CompareOp op, const void *value, RowMask *mask);
+
+/**
+ * Intersects dst with src, leaving the result in dst.
+ *
+ * @param dst The mask to update.
+ * @param src A mask over the same number of rows.
+ * @return 0 on success, -1 if the masks have different sizes.
+ */
+int row_mask_and(RowMask *dst, const RowMask *src);
+
+/**
+ * Unites dst with src, leaving the result in dst.
+ *
+ * @param dst The mask to update.
+ * @param src A mask over the same number of rows.
+ * @return 0 on success, -1 if the masks have different sizes.
+ */
+int row_mask_or(RowMask *dst, const RowMask *src);
+
+/**
+ * Inverts a mask in place.
+ *
+ * @param mask The mask to invert.
+ */
+void row_mask_not(RowMask *mask);
+
+/**
+ * Counts the selected rows of a mask.
+ *
+ * @param mask The mask.
+ * @return The number of selected rows.
+ */
+size_t row_mask_count(const RowMask *mask);
+
+/**
+ * Converts a mask into a selection vector: the ascending indices of its
+ * selected rows.
+ *
+ * @param mask The mask.
+ * @param count Receives the number of indices.
+ * @return A malloc'd array of indices that the caller frees, or NULL on failure.
+ */
+size_t *row_mask_selection(const RowMask *mask, size_t *count);
+
+/**
+ * Creates a new DataFrame holding the selected rows of df.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param mask A mask over df->num_rows rows.
+ * @return A pointer to the new DataFrame, or NULL on failure.
+ */
+DataFrame *filter_rows(const DataFrame *df, const RowMask *mask);
+
+/**
+ * Returns the name of the kernels selected for this CPU ("avx2" or "scalar").
+ */
+const char *filter_implementation(void);
+
+#endif // FILTER_H
@@ -0,0 +1,50 @@
+#ifndef GROUPBY_H
+#define GROUPBY_H
+
+#include <stdlib.h>
+#include "dataframe.h"
+
+// Aggregate function computed per group
+typedef enum {
+    AGGREGATE_SUM = 0,   // Sum of an INT or FLOAT column, output as FLOAT
+    AGGREGATE_COUNT = 1, // Number of non-NULL values of any column, output as INT
+    AGGREGATE_MIN = 2,   // Smallest value of an INT or FLOAT column, output with the input type
+    AGGREGATE_MAX = 3,   // Largest value of an INT or FLOAT column, output with the input type
+    AGGREGATE_MEAN = 4   // Mean of an INT or FLOAT column, output as FLOAT
+} AggregateOp;
+
+// One output column of a group-by
+typedef struct {
+    size_t column;    // Input column index
+    AggregateOp op;   // Function to compute
+    const char *name; // Output column name, or NULL for "<op>_<column name>"
+} Aggregation;
+
+/**
+ * Groups the rows of a DataFrame by one or more key columns and computes
+ * aggregates per group.
+ *
+ * Key hashes are computed a block of rows at a time and looked up in an
+ * open-addressing table; aggregates are then updated one column at a time.
+ * With several threads, each thread builds a partial table over a slice of the
+ * rows and the partial tables are merged at the end.
+ *
+ * The result holds the key columns followed by one column per aggregation,
+ * with one row per group in order of first appearance. Sums and means are
+ * accumulated in double precision. NULL strings form their own group. Min and
+ * max skip NaNs, so a group holding only NaNs gets an infinite min and max.
+ * A count above INT_MAX does not fit its INT column and fails the call.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param key_columns Indices of the INT, STRING or CATEGORICAL key columns.
+ * @param num_keys The number of key columns, at least one.
+ * @param aggregations The aggregates to compute.
+ * @param num_aggregations The number of aggregates.
+ * @param num_threads The number of threads, 0 for one per online CPU. Small
+ *                    inputs always use one thread.
+ * @return A new DataFrame with one row per group, or NULL on failure.
+ */
+DataFrame *group_by(const DataFrame *df, const size_t *key_columns, size_t num_keys,
+                    const Aggregation *aggregations, size_t num_aggregations, size_t num_threads);
+
+#endif // GROUPBY_H
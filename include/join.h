@@ -0,0 +1,49 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <stdlib.h>
+#include "dataframe.h"
+
+// Rows kept by a join
+typedef enum {
+    JOIN_INNER = 0, // Pairs of rows whose keys match
+    JOIN_LEFT = 1   // Pairs of matching rows plus every left row without a match
+} JoinType;
+
+// Options for hash_join
+typedef struct {
+    JoinType type;   // Inner or left join
+    int partitioned; // Non-zero to radix-partition both sides before joining
+} JoinOptions;
+
+/**
+ * Joins two DataFrames on one key column each.
+ *
+ * A chained hash table is built over the smaller side (always the right side
+ * for left joins) and probed with the rows of the other side in batches whose
+ * buckets are prefetched before any chain is followed. In partitioned mode
+ * both sides are first scattered by the top bits of their key hashes so that
+ * each partition's table fits in cache; this pays off once the build side
+ * outgrows the cache.
+ *
+ * Keys are INT on both sides, or STRING or CATEGORICAL on both sides (compared
+ * as text). NULL keys never match. The result holds every left column followed
+ * by the right columns except the right key; right names that clash with a
+ * left name get a "_right" suffix. Columns are filled with one gather each.
+ * Right columns of unmatched rows in a left join are NULL, or 0 for INT and
+ * FLOAT columns.
+ *
+ * Rows come out in probe order, with the matches of each probe row in build
+ * order; partitioned joins emit them partition by partition.
+ *
+ * @param left Pointer to the left DataFrame.
+ * @param left_key The key column index in left.
+ * @param right Pointer to the right DataFrame.
+ * @param right_key The key column index in right.
+ * @param options Join options, or NULL for an unpartitioned inner join.
+ * @return A new DataFrame holding the joined rows, or NULL on failure.
+ */
+DataFrame *hash_join(const DataFrame *left, size_t left_key, const DataFrame *right, size_t right_key,
+                     const JoinOptions *options);
+
+#endif // JOIN_H
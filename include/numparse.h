@@ -0,0 +1,57 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <stdlib.h>
+
+// Outcome of converting a field to a number
+typedef enum {
+    PARSE_OK = 0,       // The field holds a valid number
+    PARSE_EMPTY = 1,    // The field is empty or blank; the value is set to 0
+    PARSE_INVALID = 2,  // The field is not a number of the requested type
+    PARSE_OVERFLOW = 3  // The number does not fit the requested type
+} ParseStatus;
+
+/**
+ * Converts a decimal integer to an int. The field holds an optional sign and
+ * digits, optionally surrounded by spaces or tabs; it need not be
+ * NUL-terminated. Runs of eight digits are converted at once with SWAR
+ * arithmetic on a 64-bit word. Unlike atoi the conversion does not depend on
+ * the locale and rejects trailing garbage.
+ *
+ * @param start Pointer to the first byte of the field.
+ * @param length The number of bytes in the field.
+ * @param value Receives the number, or 0 unless the status is PARSE_OK.
+ * @return The parse status.
+ */
+ParseStatus parse_int32(const char *start, size_t length, int *value);
+
+/**
+ * Converts a decimal number to the nearest float. The field holds an optional
+ * sign, digits with an optional decimal point and an optional exponent, or
+ * inf, infinity or nan, optionally surrounded by spaces or tabs.
+ *
+ * Numbers whose significant digits form an integer of at most 2^24 and whose
+ * decimal exponent is within 10 of zero (such as prices and measurements) are
+ * converted with a single float multiplication or division of exact operands,
+ * which is correctly rounded. Other numbers fall back to strtof_l in the "C"
+ * locale, which is also correctly rounded, so the result never goes through a
+ * double and never depends on LC_NUMERIC.
+ *
+ * @param start Pointer to the first byte of the field.
+ * @param length The number of bytes in the field.
+ * @param value Receives the number, or 0 for PARSE_EMPTY and PARSE_INVALID.
+ *              Numbers too large for a float give PARSE_OVERFLOW and an
+ *              infinity of the right sign.
+ * @return The parse status.
+ */
+ParseStatus parse_float32(const char *start, size_t length, float *value);
+
+/**
+ * Describes a parse status for error messages.
+ *
+ * @param status The status.
+ * @return A static string such as "invalid number".
+ */
+const char *parse_status_message(ParseStatus status);
+
+#endif // NUMPARSE_H
@@ -0,0 +1,81 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include "compress.h"
+
+/**
+ * Produces input for a read-ahead ring: fills buffer with up to size bytes.
+ *
+ * @return The number of bytes written, 0 at the end of the input, or -1 on failure.
+ */
+typedef ssize_t (*ReadAheadSource)(void *context, char *buffer, size_t size);
+
+// Tuning of a read-ahead ring; zeroed fields take the defaults
+typedef struct {
+    size_t block_size; // Bytes per block, rounded up to a multiple of 4 KiB; 0 for 1 MiB
+    size_t num_blocks; // Blocks in the ring, at least 2; 0 for 4
+    int direct_io;     // Non-zero to read files with O_DIRECT, bypassing the page cache, where supported
+    Compression compression; // Compression of files; COMPRESSION_AUTO picks it from the file name
+} ReadAheadOptions;
+
+/**
+ * Reads input on a background thread into a ring of aligned blocks so that
+ * I/O overlaps with parsing. The reader thread fills blocks in order and
+ * publishes them to the consumer; the consumer hands each block back once it
+ * is done with it, and the thread refills it. Both sides move through the
+ * ring with atomic indices and only sleep when the ring is empty or full.
+ * Exactly one thread may consume a ring.
+ */
+typedef struct ReadAhead ReadAhead;
+
+/**
+ * Opens a file and starts reading it ahead. Compressed files are decompressed
+ * on the reader thread, so the blocks hold the decompressed bytes and
+ * decompression overlaps with parsing; direct_io is ignored for them.
+ *
+ * @param filename The path to the file.
+ * @param options Ring tuning, or NULL for the defaults.
+ * @return A pointer to the ring, or NULL on failure.
+ */
+ReadAhead *readahead_open(const char *filename, const ReadAheadOptions *options);
+
+/**
+ * Starts reading ahead from a custom source, such as a decompressor. The
+ * source is only called from the reader thread. direct_io is ignored.
+ *
+ * @param source Produces the input.
+ * @param context Passed to every call of source; must outlive the ring.
+ * @param options Ring tuning, or NULL for the defaults.
+ * @return A pointer to the ring, or NULL on failure.
+ */
+ReadAhead *readahead_start(ReadAheadSource source, void *context, const ReadAheadOptions *options);
+
+/**
+ * Waits for the next block of input. The block stays valid until
+ * readahead_release; calling this again before releasing returns the same block.
+ *
+ * @param ra Pointer to the ring.
+ * @param data Receives the start of the block.
+ * @param length Receives the number of bytes in the block, never 0.
+ * @return 1 if a block is available, 0 at the end of the input, -1 on failure.
+ */
+int readahead_next(ReadAhead *ra, const char **data, size_t *length);
+
+/**
+ * Hands the block returned by readahead_next back to the reader thread.
+ *
+ * @param ra Pointer to the ring.
+ */
+void readahead_release(ReadAhead *ra);
+
+/**
+ * Stops the reader thread, closes the file opened by readahead_open and frees
+ * the ring. Input that was not consumed is discarded.
+ *
+ * @param ra Pointer to the ring.
+ */
+void readahead_close(ReadAhead *ra);
+
+#endif // READAHEAD_H
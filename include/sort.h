@@ -0,0 +1,47 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stdlib.h>
+#include "dataframe.h"
+
+// One column of a sort order
+typedef struct {
+    size_t column;  // Column index
+    int descending; // Non-zero to sort from largest to smallest
+} SortKey;
+
+/**
+ * Computes the permutation that sorts a DataFrame by one or more columns.
+ *
+ * The sort is stable and works from the last key to the first. INT, FLOAT and
+ * CATEGORICAL keys are mapped to unsigned 32-bit keys that order the same way
+ * (floats through their sign-adjusted bit pattern, categories through the rank
+ * of their value) and sorted with an LSD radix sort, skipping byte passes in
+ * which every key agrees. With several threads each pass histograms and
+ * scatters the rows in parallel. STRING keys use a multi-key quicksort.
+ *
+ * NULL strings and NaNs sort last in both directions.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param keys The sort keys, most significant first.
+ * @param num_keys The number of keys, at least one.
+ * @param num_threads The number of threads for radix passes, 0 for one per
+ *                    online CPU. Small inputs always use one thread.
+ * @return A malloc'd array of df->num_rows row indices in sorted order that
+ *         the caller frees, or NULL on failure.
+ */
+size_t *argsort(const DataFrame *df, const SortKey *keys, size_t num_keys, size_t num_threads);
+
+/**
+ * Creates a sorted copy of a DataFrame. The permutation from argsort is
+ * applied to every column with a single gather each.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param keys The sort keys, most significant first.
+ * @param num_keys The number of keys, at least one.
+ * @param num_threads The number of threads, as for argsort.
+ * @return A new sorted DataFrame, or NULL on failure.
+ */
+DataFrame *sort_by(const DataFrame *df, const SortKey *keys, size_t num_keys, size_t num_threads);
+
+#endif // SORT_H
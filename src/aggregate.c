@@ -0,0 +1,529 @@
+#include "aggregate.h"
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AGGREGATE_X86 1
+#endif
+
+// Values summed directly before pairwise summation takes over
+#define PAIRWISE_BLOCK 256
+
+// Rows of an encoded column decoded at a time
+#define DECODE_BLOCK_ROWS 1024
+
+// Rows below which another thread does not pay for itself
+#define MIN_ROWS_PER_THREAD (256 * 1024)
+
+// Running sum, min and max of a range of ints
+typedef struct {
+    int64_t sum;
+    int min;
+    int max;
+} IntTotals;
+
+// Kernels over contiguous values, one set per instruction set
+typedef struct {
+    const char *name;
+    void (*int_totals)(const int *data, size_t n, IntTotals *totals);
+    double (*int_deviations)(const int *data, size_t n, double mean);
+    double (*float_totals)(const float *data, size_t n, float *min, float *max);
+    double (*float_deviations)(const float *data, size_t n, double mean);
+} AggregateKernels;
+
+// Adds a range of ints into totals
+static void int_totals_scalar(const int *data, size_t n, IntTotals *totals) {
+    int64_t sum = 0;
+    int min = totals->min, max = totals->max;
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+        if (data[i] < min) min = data[i];
+        if (data[i] > max) max = data[i];
+    }
+    totals->sum += sum;
+    totals->min = min;
+    totals->max = max;
+}
+
+// Sums the squared deviations of a block of ints from mean
+static double int_deviations_scalar(const int *data, size_t n, double mean) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double deviation = (double)data[i] - mean;
+        sum += deviation * deviation;
+    }
+    return sum;
+}
+
+// Sums a block of floats in double precision and folds it into min and max, skipping NaNs
+static double float_totals_scalar(const float *data, size_t n, float *min, float *max) {
+    double sum = 0.0;
+    float lo = *min, hi = *max;
+    for (size_t i = 0; i < n; i++) {
+        sum += data[i];
+        if (data[i] < lo) lo = data[i];
+        if (data[i] > hi) hi = data[i];
+    }
+    *min = lo;
+    *max = hi;
+    return sum;
+}
+
+// Sums the squared deviations of a block of floats from mean
+static double float_deviations_scalar(const float *data, size_t n, double mean) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double deviation = (double)data[i] - mean;
+        sum += deviation * deviation;
+    }
+    return sum;
+}
+
+static const AggregateKernels scalar_kernels = {
+    "scalar", int_totals_scalar, int_deviations_scalar, float_totals_scalar, float_deviations_scalar
+};
+
+#ifdef AGGREGATE_X86
+// AVX2 int totals: eight 32-bit lanes for min and max, widened into 64-bit lanes for the sum
+__attribute__((target("avx2")))
+static void int_totals_avx2(const int *data, size_t n, IntTotals *totals) {
+    __m256i sum_lo = _mm256_setzero_si256();
+    __m256i sum_hi = _mm256_setzero_si256();
+    __m256i lo = _mm256_set1_epi32(totals->min);
+    __m256i hi = _mm256_set1_epi32(totals->max);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i values = _mm256_loadu_si256((const __m256i *)(data + i));
+        lo = _mm256_min_epi32(lo, values);
+        hi = _mm256_max_epi32(hi, values);
+        sum_lo = _mm256_add_epi64(sum_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+        sum_hi = _mm256_add_epi64(sum_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+    }
+
+    int64_t sums[4];
+    int mins[8], maxs[8];
+    _mm256_storeu_si256((__m256i *)sums, _mm256_add_epi64(sum_lo, sum_hi));
+    _mm256_storeu_si256((__m256i *)mins, lo);
+    _mm256_storeu_si256((__m256i *)maxs, hi);
+    totals->sum += sums[0] + sums[1] + sums[2] + sums[3];
+    for (int lane = 0; lane < 8; lane++) {
+        if (mins[lane] < totals->min) totals->min = mins[lane];
+        if (maxs[lane] > totals->max) totals->max = maxs[lane];
+    }
+    int_totals_scalar(data + i, n - i, totals);
+}
+
+// AVX2 squared deviations of ints, converted to double four at a time
+__attribute__((target("avx2")))
+static double int_deviations_avx2(const int *data, size_t n, double mean) {
+    const __m256d center = _mm256_set1_pd(mean);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i values = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(values)), center);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(values, 1)), center);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + int_deviations_scalar(data + i, n - i, mean);
+}
+
+// AVX2 float totals, summed in double lanes; MINPS/MAXPS return the accumulator when the value is NaN
+__attribute__((target("avx2")))
+static double float_totals_avx2(const float *data, size_t n, float *min, float *max) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256 lo = _mm256_set1_ps(*min);
+    __m256 hi = _mm256_set1_ps(*max);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 values = _mm256_loadu_ps(data + i);
+        lo = _mm256_min_ps(values, lo);
+        hi = _mm256_max_ps(values, hi);
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(values)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(values, 1)));
+    }
+
+    double lanes[4];
+    float mins[8], maxs[8];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    _mm256_storeu_ps(mins, lo);
+    _mm256_storeu_ps(maxs, hi);
+    for (int lane = 0; lane < 8; lane++) {
+        if (mins[lane] < *min) *min = mins[lane];
+        if (maxs[lane] > *max) *max = maxs[lane];
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + float_totals_scalar(data + i, n - i, min, max);
+}
+
+// AVX2 squared deviations of floats
+__attribute__((target("avx2")))
+static double float_deviations_avx2(const float *data, size_t n, double mean) {
+    const __m256d center = _mm256_set1_pd(mean);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 values = _mm256_loadu_ps(data + i);
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(values)), center);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(values, 1)), center);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + float_deviations_scalar(data + i, n - i, mean);
+}
+
+static const AggregateKernels avx2_kernels = {
+    "avx2", int_totals_avx2, int_deviations_avx2, float_totals_avx2, float_deviations_avx2
+};
+#endif
+
+static const AggregateKernels *kernels = &scalar_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+// Picks the widest kernels supported by the running CPU
+static void select_kernels(void) {
+#ifdef AGGREGATE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels = &avx2_kernels;
+    }
+#endif
+}
+
+const char *aggregate_implementation(void) {
+    pthread_once(&kernels_once, select_kernels);
+    return kernels->name;
+}
+
+// Splits n values so that both halves start on a block boundary
+static inline size_t pairwise_split(size_t n) {
+    return (n / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK * PAIRWISE_BLOCK;
+}
+
+// Pairwise summation: blocks are summed by the kernels and the block sums are added as a balanced tree
+static double pairwise_float_totals(const float *data, size_t n, float *min, float *max) {
+    if (n <= PAIRWISE_BLOCK) {
+        return kernels->float_totals(data, n, min, max);
+    }
+    size_t half = pairwise_split(n);
+    return pairwise_float_totals(data, half, min, max) + pairwise_float_totals(data + half, n - half, min, max);
+}
+
+static double pairwise_float_deviations(const float *data, size_t n, double mean) {
+    if (n <= PAIRWISE_BLOCK) {
+        return kernels->float_deviations(data, n, mean);
+    }
+    size_t half = pairwise_split(n);
+    return pairwise_float_deviations(data, half, mean) + pairwise_float_deviations(data + half, n - half, mean);
+}
+
+static double pairwise_int_deviations(const int *data, size_t n, double mean) {
+    if (n <= PAIRWISE_BLOCK) {
+        return kernels->int_deviations(data, n, mean);
+    }
+    size_t half = pairwise_split(n);
+    return pairwise_int_deviations(data, half, mean) + pairwise_int_deviations(data + half, n - half, mean);
+}
+
+// Statistics of one slice of a column, computed by one thread
+typedef struct {
+    const Column *column;
+    size_t start;      // First row of the slice
+    size_t end;        // One past the last row of the slice
+    int want_variance; // Whether to make the second pass for m2
+    int64_t int_sum;   // Exact sum of an INT slice
+    double sum;        // Sum of the slice
+    double min;        // Smallest value, NaN if there is none
+    double max;        // Largest value, NaN if there is none
+    double m2;         // Sum of squared deviations from the slice's mean
+} StatsTask;
+
+// Computes the statistics of a slice of an encoded INT column. RLE runs are
+// folded in whole; other encodings are decoded a block at a time for the kernels.
+static void encoded_stats(StatsTask *task) {
+    const EncodedInts *encoded = &task->column->data.encoded_ints;
+    size_t n = task->end - task->start;
+    IntTotals totals = {0, INT_MAX, INT_MIN};
+    if (encoded->encoding == INT_ENCODING_RLE) {
+        size_t first = encoded_run_at(encoded, task->start);
+        for (size_t run = first, row = task->start; row < task->end; run++) {
+            size_t run_end = encoded->run_ends[run] < task->end ? encoded->run_ends[run] : task->end;
+            int value = encoded->run_values[run];
+            totals.sum += (int64_t)value * (int64_t)(run_end - row);
+            if (value < totals.min) totals.min = value;
+            if (value > totals.max) totals.max = value;
+            row = run_end;
+        }
+        task->int_sum = totals.sum;
+        task->sum = (double)totals.sum;
+        task->min = totals.min;
+        task->max = totals.max;
+        if (task->want_variance) {
+            double mean = task->sum / (double)n;
+            for (size_t run = first, row = task->start; row < task->end; run++) {
+                size_t run_end = encoded->run_ends[run] < task->end ? encoded->run_ends[run] : task->end;
+                double deviation = encoded->run_values[run] - mean;
+                task->m2 += deviation * deviation * (double)(run_end - row);
+                row = run_end;
+            }
+        }
+        return;
+    }
+
+    int block[DECODE_BLOCK_ROWS];
+    for (size_t row = task->start; row < task->end; row += DECODE_BLOCK_ROWS) {
+        size_t count = task->end - row < DECODE_BLOCK_ROWS ? task->end - row : DECODE_BLOCK_ROWS;
+        decode_ints(encoded, row, count, block);
+        kernels->int_totals(block, count, &totals);
+    }
+    task->int_sum = totals.sum;
+    task->sum = (double)totals.sum;
+    task->min = totals.min;
+    task->max = totals.max;
+    if (task->want_variance) {
+        double mean = task->sum / (double)n;
+        for (size_t row = task->start; row < task->end; row += DECODE_BLOCK_ROWS) {
+            size_t count = task->end - row < DECODE_BLOCK_ROWS ? task->end - row : DECODE_BLOCK_ROWS;
+            decode_ints(encoded, row, count, block);
+            task->m2 += pairwise_int_deviations(block, count, mean);
+        }
+    }
+}
+
+// Computes the statistics of one slice
+static void *run_stats_task(void *arg) {
+    StatsTask *task = arg;
+    size_t n = task->end - task->start;
+    task->int_sum = 0;
+    task->sum = 0.0;
+    task->min = NAN;
+    task->max = NAN;
+    task->m2 = 0.0;
+    if (n == 0) {
+        return NULL;
+    }
+
+    if (task->column->type == DATA_TYPE_INT && task->column->encoding != INT_ENCODING_PLAIN) {
+        encoded_stats(task);
+    } else if (task->column->type == DATA_TYPE_INT) {
+        const int *data = task->column->data.int_data + task->start;
+        IntTotals totals = {0, INT_MAX, INT_MIN};
+        kernels->int_totals(data, n, &totals);
+        task->int_sum = totals.sum;
+        task->sum = (double)totals.sum;
+        task->min = totals.min;
+        task->max = totals.max;
+        if (task->want_variance) {
+            task->m2 = pairwise_int_deviations(data, n, task->sum / (double)n);
+        }
+    } else {
+        const float *data = task->column->data.float_data + task->start;
+        float min = INFINITY, max = -INFINITY;
+        task->sum = pairwise_float_totals(data, n, &min, &max);
+        // Only NaNs leave the bounds crossed
+        if (min <= max) {
+            task->min = min;
+            task->max = max;
+        }
+        if (task->want_variance) {
+            task->m2 = pairwise_float_deviations(data, n, task->sum / (double)n);
+        }
+    }
+    return NULL;
+}
+
+// Validates the column, runs the slices and merges their statistics
+static int compute_stats(const DataFrame *df, size_t column, size_t num_threads, int want_variance, ColumnStats *stats) {
+    if (df == NULL || stats == NULL) {
+        fprintf(stderr, "DataFrame or output is NULL\n");
+        return -1;
+    }
+    if (column >= df->num_columns) {
+        fprintf(stderr, "Column index %zu out of bounds\n", column);
+        return -1;
+    }
+    const Column *col = &df->columns[column];
+    if (col->type != DATA_TYPE_INT && col->type != DATA_TYPE_FLOAT) {
+        fprintf(stderr, "Column '%s' is not numeric\n", col->name);
+        return -1;
+    }
+    pthread_once(&kernels_once, select_kernels);
+
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    size_t max_threads = df->num_rows / MIN_ROWS_PER_THREAD;
+    if (num_threads > max_threads) num_threads = max_threads;
+    if (num_threads == 0) num_threads = 1;
+
+    StatsTask local;
+    StatsTask *tasks = num_threads == 1 ? &local : malloc(num_threads * sizeof(StatsTask));
+    pthread_t *threads = num_threads == 1 ? NULL : malloc(num_threads * sizeof(pthread_t));
+    if (tasks == NULL || (num_threads > 1 && threads == NULL)) {
+        fprintf(stderr, "Memory allocation failed for aggregation tasks\n");
+        if (tasks != &local) free(tasks);
+        free(threads);
+        return -1;
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        tasks[i].column = col;
+        tasks[i].start = df->num_rows * i / num_threads;
+        tasks[i].end = df->num_rows * (i + 1) / num_threads;
+        tasks[i].want_variance = want_variance;
+    }
+
+    // The calling thread takes the first slice; slices whose thread fails to start run inline
+    size_t started = 0;
+    for (size_t i = 1; i < num_threads; i++, started++) {
+        if (pthread_create(&threads[i], NULL, run_stats_task, &tasks[i]) != 0) break;
+    }
+    run_stats_task(&tasks[0]);
+    for (size_t i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = started + 1; i < num_threads; i++) {
+        run_stats_task(&tasks[i]);
+    }
+
+    // Merge the slices, combining squared deviations with Chan's formula
+    size_t count = 0;
+    int64_t int_sum = 0;
+    double sum = 0.0, mean = 0.0, m2 = 0.0, min = INFINITY, max = -INFINITY;
+    for (size_t i = 0; i < num_threads; i++) {
+        const StatsTask *task = &tasks[i];
+        size_t n = task->end - task->start;
+        if (n == 0) continue;
+        double task_mean = task->sum / (double)n;
+        if (count == 0) {
+            mean = task_mean;
+            m2 = task->m2;
+        } else {
+            double delta = task_mean - mean;
+            double total = (double)(count + n);
+            m2 += task->m2 + delta * delta * (double)count * (double)n / total;
+            mean += delta * (double)n / total;
+        }
+        count += n;
+        int_sum += task->int_sum;
+        sum += task->sum;
+        if (task->min < min) min = task->min;
+        if (task->max > max) max = task->max;
+    }
+
+    stats->count = count;
+    stats->sum = col->type == DATA_TYPE_INT ? (double)int_sum : sum;
+    stats->mean = count > 0 ? stats->sum / (double)count : NAN;
+    stats->min = min <= max ? min : NAN;
+    stats->max = min <= max ? max : NAN;
+    stats->variance = want_variance && count > 1 ? m2 / (double)(count - 1) : NAN;
+
+    if (tasks != &local) free(tasks);
+    free(threads);
+    return 0;
+}
+
+// Function to compute every statistic of a numeric column
+int column_stats(const DataFrame *df, size_t column, size_t num_threads, ColumnStats *stats) {
+    return compute_stats(df, column, num_threads, 1, stats);
+}
+
+// Function to compute the sum of a numeric column
+int column_sum(const DataFrame *df, size_t column, double *sum) {
+    ColumnStats stats;
+    if (sum == NULL || compute_stats(df, column, 1, 0, &stats) != 0) {
+        return -1;
+    }
+    *sum = stats.sum;
+    return 0;
+}
+
+// Function to compute the mean of a numeric column
+int column_mean(const DataFrame *df, size_t column, double *mean) {
+    ColumnStats stats;
+    if (mean == NULL || compute_stats(df, column, 1, 0, &stats) != 0) {
+        return -1;
+    }
+    *mean = stats.mean;
+    return 0;
+}
+
+// Function to compute the minimum of a numeric column
+int column_min(const DataFrame *df, size_t column, double *min) {
+    ColumnStats stats;
+    if (min == NULL || compute_stats(df, column, 1, 0, &stats) != 0) {
+        return -1;
+    }
+    *min = stats.min;
+    return 0;
+}
+
+// Function to compute the maximum of a numeric column
+int column_max(const DataFrame *df, size_t column, double *max) {
+    ColumnStats stats;
+    if (max == NULL || compute_stats(df, column, 1, 0, &stats) != 0) {
+        return -1;
+    }
+    *max = stats.max;
+    return 0;
+}
+
+// Function to compute the sample variance of a numeric column
+int column_variance(const DataFrame *df, size_t column, double *variance) {
+    ColumnStats stats;
+    if (variance == NULL || compute_stats(df, column, 1, 1, &stats) != 0) {
+        return -1;
+    }
+    *variance = stats.variance;
+    return 0;
+}
+
+// Function to count the non-NULL values of a column
+int column_count(const DataFrame *df, size_t column, size_t *count) {
+    if (df == NULL || count == NULL) {
+        fprintf(stderr, "DataFrame or output is NULL\n");
+        return -1;
+    }
+    if (column >= df->num_columns) {
+        fprintf(stderr, "Column index %zu out of bounds\n", column);
+        return -1;
+    }
+
+    const Column *col = &df->columns[column];
+    size_t n = 0;
+    switch (col->type) {
+        case DATA_TYPE_INT:
+        case DATA_TYPE_FLOAT:
+            n = df->num_rows;
+            break;
+        case DATA_TYPE_STRING:
+            for (size_t row = 0; row < df->num_rows; row++) {
+                n += col->data.string_data.offsets[row] != STRING_NULL_OFFSET;
+            }
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            for (size_t row = 0; row < df->num_rows; row++) {
+                n += col->data.categorical_data.codes[row] >= 0;
+            }
+            break;
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    *count = n;
+    return 0;
+}
@@ -0,0 +1,383 @@
+#include "compress.h"
+#include "dfstats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef DF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Size of the compressed-side buffer of every codec
+#define CODEC_BUFFER_SIZE (256 * 1024)
+
+// Largest chunk handed to zlib at once, whose counters are unsigned int
+#define ZLIB_MAX_CHUNK (1u << 30)
+
+struct Decompressor {
+    Compression compression;
+    int fd;
+    unsigned char *input;   // Compressed bytes read from the file
+    size_t input_size;      // Bytes in input
+    size_t input_pos;       // Bytes of input already decompressed
+    int frame_done;         // Whether the last gzip member or zstd frame ended cleanly
+    z_stream gzip;
+#ifdef DF_HAVE_ZSTD
+    ZSTD_DStream *zstd;
+#endif
+};
+
+struct Compressor {
+    Compression compression;
+    int fd;
+    unsigned char *output;  // Compressed bytes waiting to be written
+    z_stream gzip;
+#ifdef DF_HAVE_ZSTD
+    ZSTD_CCtx *zstd;
+#endif
+};
+
+// Whether name ends with suffix
+static int ends_with(const char *name, const char *suffix) {
+    size_t length = strlen(name), suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(name + length - suffix_length, suffix) == 0;
+}
+
+// Function to resolve COMPRESSION_AUTO from a file name
+Compression compression_for_file(const char *filename, Compression compression) {
+    if (compression != COMPRESSION_AUTO || filename == NULL) {
+        return compression;
+    }
+    if (ends_with(filename, ".gz")) return COMPRESSION_GZIP;
+    if (ends_with(filename, ".zst")) return COMPRESSION_ZSTD;
+    return COMPRESSION_NONE;
+}
+
+// Rejects compressions this build cannot handle
+static int check_codec(Compression compression) {
+    if (compression == COMPRESSION_GZIP) {
+        return 0;
+    }
+    if (compression == COMPRESSION_ZSTD) {
+#ifdef DF_HAVE_ZSTD
+        return 0;
+#else
+        fprintf(stderr, "zstd support is not compiled in; rebuild with ZSTD=1\n");
+        return -1;
+#endif
+    }
+    fprintf(stderr, "Unsupported compression %d\n", (int)compression);
+    return -1;
+}
+
+// Reads the next compressed bytes into input; returns 0 at the end of the file
+static ssize_t fill_input(Decompressor *decompressor) {
+    for (;;) {
+        ssize_t bytes = read(decompressor->fd, decompressor->input, CODEC_BUFFER_SIZE);
+        if (bytes >= 0) {
+            STATS_ADD(STATS_BYTES_READ, bytes);
+            decompressor->input_size = (size_t)bytes;
+            decompressor->input_pos = 0;
+            return bytes;
+        }
+        if (errno != EINTR) {
+            perror("Could not read compressed input");
+            return -1;
+        }
+    }
+}
+
+// Decompresses gzip or zlib data, moving on to the next member when one ends
+static ssize_t gzip_read(Decompressor *decompressor, char *buffer, size_t size) {
+    z_stream *z = &decompressor->gzip;
+    if (size > ZLIB_MAX_CHUNK) size = ZLIB_MAX_CHUNK;
+    z->next_out = (Bytef *)buffer;
+    z->avail_out = (uInt)size;
+    while (z->avail_out == size) {
+        if (z->avail_in == 0) {
+            ssize_t bytes = fill_input(decompressor);
+            if (bytes < 0) return -1;
+            if (bytes == 0) {
+                if (decompressor->frame_done) return 0;
+                fprintf(stderr, "Compressed input is truncated\n");
+                return -1;
+            }
+            z->next_in = decompressor->input;
+            z->avail_in = (uInt)bytes;
+        }
+        if (decompressor->frame_done) {
+            // Another member follows the one that ended
+            inflateReset(z);
+            decompressor->frame_done = 0;
+        }
+        int status = inflate(z, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            decompressor->frame_done = 1;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            fprintf(stderr, "Could not decompress gzip input: %s\n", z->msg ? z->msg : "corrupt data");
+            return -1;
+        }
+    }
+    return (ssize_t)(size - z->avail_out);
+}
+
+#ifdef DF_HAVE_ZSTD
+// Decompresses a sequence of zstd frames
+static ssize_t zstd_read(Decompressor *decompressor, char *buffer, size_t size) {
+    ZSTD_outBuffer out = {buffer, size, 0};
+    while (out.pos == 0) {
+        if (decompressor->input_pos == decompressor->input_size) {
+            ssize_t bytes = fill_input(decompressor);
+            if (bytes < 0) return -1;
+            if (bytes == 0) {
+                if (decompressor->frame_done) return 0;
+                fprintf(stderr, "Compressed input is truncated\n");
+                return -1;
+            }
+        }
+        ZSTD_inBuffer in = {decompressor->input, decompressor->input_size, decompressor->input_pos};
+        size_t status = ZSTD_decompressStream(decompressor->zstd, &out, &in);
+        decompressor->input_pos = in.pos;
+        if (ZSTD_isError(status)) {
+            fprintf(stderr, "Could not decompress zstd input: %s\n", ZSTD_getErrorName(status));
+            return -1;
+        }
+        decompressor->frame_done = status == 0;
+    }
+    return (ssize_t)out.pos;
+}
+#endif
+
+// Function to open a compressed file for reading
+Decompressor *decompressor_open(const char *filename, Compression compression) {
+    if (filename == NULL) {
+        fprintf(stderr, "Filename is NULL\n");
+        return NULL;
+    }
+    if (check_codec(compression) != 0) {
+        return NULL;
+    }
+    Decompressor *decompressor = calloc(1, sizeof(Decompressor));
+    unsigned char *input = malloc(CODEC_BUFFER_SIZE);
+    if (decompressor == NULL || input == NULL) {
+        fprintf(stderr, "Memory allocation failed for decompressor\n");
+        free(decompressor);
+        free(input);
+        return NULL;
+    }
+    decompressor->compression = compression;
+    decompressor->input = input;
+    decompressor->fd = open(filename, O_RDONLY);
+    if (decompressor->fd < 0) {
+        fprintf(stderr, "Could not open file '%s'\n", filename);
+        free(input);
+        free(decompressor);
+        return NULL;
+    }
+    posix_fadvise(decompressor->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int failed;
+    if (compression == COMPRESSION_GZIP) {
+        // 32 added to the window bits accepts both gzip and zlib headers
+        failed = inflateInit2(&decompressor->gzip, 15 + 32) != Z_OK;
+    } else {
+#ifdef DF_HAVE_ZSTD
+        decompressor->zstd = ZSTD_createDStream();
+        failed = decompressor->zstd == NULL;
+#else
+        failed = 1;
+#endif
+    }
+    if (failed) {
+        fprintf(stderr, "Could not initialise the decompressor for '%s'\n", filename);
+        close(decompressor->fd);
+        free(input);
+        free(decompressor);
+        return NULL;
+    }
+    return decompressor;
+}
+
+// Function to decompress the next bytes of the file
+ssize_t decompressor_read(void *context, char *buffer, size_t size) {
+    Decompressor *decompressor = context;
+    if (size == 0) return 0;
+#ifdef DF_HAVE_ZSTD
+    if (decompressor->compression == COMPRESSION_ZSTD) {
+        return zstd_read(decompressor, buffer, size);
+    }
+#endif
+    return gzip_read(decompressor, buffer, size);
+}
+
+// Function to close a decompressor
+void decompressor_close(Decompressor *decompressor) {
+    if (decompressor == NULL) return;
+    if (decompressor->compression == COMPRESSION_GZIP) {
+        inflateEnd(&decompressor->gzip);
+    }
+#ifdef DF_HAVE_ZSTD
+    ZSTD_freeDStream(decompressor->zstd);
+#endif
+    close(decompressor->fd);
+    free(decompressor->input);
+    free(decompressor);
+}
+
+// Writes the first length bytes of the output buffer to the file
+static int write_output(Compressor *compressor, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t bytes = write(compressor->fd, compressor->output + written, length - written);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            perror("Could not write compressed output");
+            return -1;
+        }
+        written += (size_t)bytes;
+    }
+    STATS_ADD(STATS_BYTES_WRITTEN, written);
+    return 0;
+}
+
+// Deflates size bytes, writing out every full output buffer; finish ends the gzip member
+static int gzip_compress(Compressor *compressor, const char *data, size_t size, int finish) {
+    z_stream *z = &compressor->gzip;
+    z->next_in = (Bytef *)data;
+    z->avail_in = (uInt)size;
+    for (;;) {
+        z->next_out = compressor->output;
+        z->avail_out = CODEC_BUFFER_SIZE;
+        int status = deflate(z, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (status == Z_STREAM_ERROR) {
+            fprintf(stderr, "Could not compress gzip output\n");
+            return -1;
+        }
+        if (write_output(compressor, CODEC_BUFFER_SIZE - z->avail_out) != 0) {
+            return -1;
+        }
+        if (finish ? status == Z_STREAM_END : z->avail_out != 0) {
+            return 0;
+        }
+    }
+}
+
+#ifdef DF_HAVE_ZSTD
+// Compresses size bytes, writing out every full output buffer; finish ends the frame
+static int zstd_compress(Compressor *compressor, const char *data, size_t size, int finish) {
+    ZSTD_inBuffer in = {data, size, 0};
+    for (;;) {
+        ZSTD_outBuffer out = {compressor->output, CODEC_BUFFER_SIZE, 0};
+        size_t remaining = ZSTD_compressStream2(compressor->zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining)) {
+            fprintf(stderr, "Could not compress zstd output: %s\n", ZSTD_getErrorName(remaining));
+            return -1;
+        }
+        if (write_output(compressor, out.pos) != 0) {
+            return -1;
+        }
+        if (finish ? remaining == 0 : in.pos == in.size) {
+            return 0;
+        }
+    }
+}
+#endif
+
+// Compresses with the codec of the compressor
+static int compress_chunk(Compressor *compressor, const char *data, size_t size, int finish) {
+#ifdef DF_HAVE_ZSTD
+    if (compressor->compression == COMPRESSION_ZSTD) {
+        return zstd_compress(compressor, data, size, finish);
+    }
+#endif
+    return gzip_compress(compressor, data, size, finish);
+}
+
+// Function to open a file for compressed writing
+Compressor *compressor_open(const char *filename, Compression compression, int level) {
+    if (filename == NULL) {
+        fprintf(stderr, "Filename is NULL\n");
+        return NULL;
+    }
+    if (check_codec(compression) != 0) {
+        return NULL;
+    }
+    Compressor *compressor = calloc(1, sizeof(Compressor));
+    unsigned char *output = malloc(CODEC_BUFFER_SIZE);
+    if (compressor == NULL || output == NULL) {
+        fprintf(stderr, "Memory allocation failed for compressor\n");
+        free(compressor);
+        free(output);
+        return NULL;
+    }
+    compressor->compression = compression;
+    compressor->output = output;
+
+    int failed;
+    if (compression == COMPRESSION_GZIP) {
+        // 16 added to the window bits writes a gzip header and trailer
+        failed = deflateInit2(&compressor->gzip, level != 0 ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                              Z_DEFAULT_STRATEGY) != Z_OK;
+    } else {
+#ifdef DF_HAVE_ZSTD
+        compressor->zstd = ZSTD_createCCtx();
+        failed = compressor->zstd == NULL ||
+                 ZSTD_isError(ZSTD_CCtx_setParameter(compressor->zstd, ZSTD_c_compressionLevel,
+                                                     level != 0 ? level : ZSTD_CLEVEL_DEFAULT));
+        if (failed) ZSTD_freeCCtx(compressor->zstd);
+#else
+        failed = 1;
+#endif
+    }
+    if (failed) {
+        fprintf(stderr, "Invalid compression level %d\n", level);
+        free(output);
+        free(compressor);
+        return NULL;
+    }
+
+    compressor->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (compressor->fd < 0) {
+        perror("Could not open file");
+        if (compression == COMPRESSION_GZIP) deflateEnd(&compressor->gzip);
+#ifdef DF_HAVE_ZSTD
+        ZSTD_freeCCtx(compressor->zstd);
+#endif
+        free(output);
+        free(compressor);
+        return NULL;
+    }
+    return compressor;
+}
+
+// Function to compress bytes into the file
+int compressor_write(Compressor *compressor, const char *data, size_t size) {
+    while (size > 0) {
+        size_t chunk = size > ZLIB_MAX_CHUNK ? ZLIB_MAX_CHUNK : size;
+        if (compress_chunk(compressor, data, chunk, 0) != 0) return -1;
+        data += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+// Function to finish the compressed stream and close the file
+int compressor_close(Compressor *compressor) {
+    if (compressor == NULL) return 0;
+    int status = compress_chunk(compressor, NULL, 0, 1);
+    if (compressor->compression == COMPRESSION_GZIP) {
+        deflateEnd(&compressor->gzip);
+    }
+#ifdef DF_HAVE_ZSTD
+    ZSTD_freeCCtx(compressor->zstd);
+#endif
+    if (close(compressor->fd) != 0) {
+        perror("Could not close file");
+        status = -1;
+    }
+    free(compressor->output);
+    free(compressor);
+    return status;
+}
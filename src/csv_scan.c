@@ -0,0 +1,257 @@
+#include "csv_scan.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCAN_X86 1
+#endif
+
+// Bytes classified per block, one bit per byte in each mask
+#define BLOCK_SIZE 64
+
+// Bytes indexed per window; offsets into a window fit in 32 bits
+#define WINDOW_SIZE (64 * 1024)
+
+// Bitmasks describing one block of input
+typedef struct {
+    uint64_t delimiters; // Bytes equal to ','
+    uint64_t quotes;     // Bytes equal to '"'
+    uint64_t newlines;   // Bytes equal to '\n'
+} BlockMasks;
+
+typedef void (*ClassifyFn)(const char *block, BlockMasks *masks);
+
+// Portable classifier, builds each mask with shifts instead of branches
+static void classify_scalar(const char *block, BlockMasks *masks) {
+    uint64_t delimiters = 0, quotes = 0, newlines = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        char c = block[i];
+        delimiters |= (uint64_t)(c == ',') << i;
+        quotes |= (uint64_t)(c == '"') << i;
+        newlines |= (uint64_t)(c == '\n') << i;
+    }
+    masks->delimiters = delimiters;
+    masks->quotes = quotes;
+    masks->newlines = newlines;
+}
+
+#ifdef CSV_SCAN_X86
+// SSE2 classifier, four 16-byte compares per mask
+static void classify_sse2(const char *block, BlockMasks *masks) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t delimiters = 0, quotes = 0, newlines = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        delimiters |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)) << (16 * i);
+        quotes |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << (16 * i);
+        newlines |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (16 * i);
+    }
+    masks->delimiters = delimiters;
+    masks->quotes = quotes;
+    masks->newlines = newlines;
+}
+
+// AVX2 classifier, two 32-byte compares per mask
+__attribute__((target("avx2")))
+static void classify_avx2(const char *block, BlockMasks *masks) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    __m256i lo = _mm256_loadu_si256((const __m256i *)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+    masks->delimiters = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma)) |
+                        (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma)) << 32;
+    masks->quotes = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote)) |
+                    (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32;
+    masks->newlines = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)) |
+                      (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)) << 32;
+}
+#endif
+
+static ClassifyFn classify_block = classify_scalar;
+static const char *classify_name = "scalar";
+static pthread_once_t classify_once = PTHREAD_ONCE_INIT;
+
+// Picks the widest classifier supported by the running CPU
+static void select_classifier(void) {
+#ifdef CSV_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        classify_block = classify_avx2;
+        classify_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        classify_block = classify_sse2;
+        classify_name = "sse2";
+    }
+#endif
+}
+
+const char *csv_scan_implementation(void) {
+    pthread_once(&classify_once, select_classifier);
+    return classify_name;
+}
+
+// Sets every bit from each quote up to (excluding) the matching closing quote
+static inline uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Indexes the separators of the next window of the buffer
+static void index_window(CsvScanner *scanner) {
+    const char *window = scanner->scanned;
+    size_t length = (size_t)(scanner->end - window);
+    if (length > WINDOW_SIZE) length = WINDOW_SIZE;
+
+    size_t count = 0;
+    uint64_t in_quotes = scanner->in_quotes;
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+        BlockMasks masks;
+        size_t remaining = length - offset;
+        if (remaining >= BLOCK_SIZE) {
+            classify_block(window + offset, &masks);
+        } else {
+            char tail[BLOCK_SIZE];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, window + offset, remaining);
+            classify_block(tail, &masks);
+        }
+
+        uint64_t quoted = prefix_xor(masks.quotes) ^ in_quotes;
+        in_quotes = (uint64_t)((int64_t)quoted >> 63);
+
+        uint64_t separators = (masks.delimiters | masks.newlines) & ~quoted;
+        while (separators) {
+            scanner->index[count++] = (uint32_t)offset + (uint32_t)__builtin_ctzll(separators);
+            separators &= separators - 1;
+        }
+    }
+
+    scanner->window = window;
+    scanner->scanned = window + length;
+    scanner->index_count = count;
+    scanner->index_pos = 0;
+    scanner->in_quotes = in_quotes;
+}
+
+// Trims a raw field and strips its quotes
+static void finish_field(const char *start, const char *end, CsvField *field) {
+    while (start < end && isspace((unsigned char)*start)) start++;
+    while (end > start && isspace((unsigned char)end[-1])) end--;
+
+    if (start < end && *start == '"') {
+        // Anything between the closing quote and the separator is ignored
+        const char *close = end - 1;
+        if (close == start || *close != '"') {
+            close = end;
+            for (const char *c = end - 1; c > start; c--) {
+                if (*c == '"') {
+                    close = c;
+                    break;
+                }
+            }
+        }
+        field->start = start + 1;
+        field->length = (size_t)(close - field->start);
+        field->quoted = 1;
+        field->escaped = memchr(field->start, '"', field->length) != NULL;
+    } else {
+        field->start = start;
+        field->length = (size_t)(end - start);
+        field->quoted = 0;
+        field->escaped = 0;
+    }
+}
+
+int csv_scanner_init(CsvScanner *scanner, const char *start, const char *end) {
+    pthread_once(&classify_once, select_classifier);
+
+    scanner->index = malloc(WINDOW_SIZE * sizeof(uint32_t));
+    if (!scanner->index) {
+        fprintf(stderr, "Memory allocation failed for CSV scanner\n");
+        return -1;
+    }
+    csv_scanner_reset(scanner, start, end);
+    return 0;
+}
+
+void csv_scanner_reset(CsvScanner *scanner, const char *start, const char *end) {
+    scanner->end = end;
+    scanner->window = start;
+    scanner->scanned = start;
+    scanner->position = start;
+    scanner->index_count = 0;
+    scanner->index_pos = 0;
+    scanner->in_quotes = 0;
+    scanner->terminated = 0;
+}
+
+void csv_scanner_free(CsvScanner *scanner) {
+    free(scanner->index);
+    scanner->index = NULL;
+}
+
+int csv_scanner_next_record(CsvScanner *scanner, CsvField *fields, size_t max_fields, size_t *num_fields) {
+    const char *field_start = scanner->position;
+    size_t count = 0;
+
+    if (field_start >= scanner->end) {
+        *num_fields = 0;
+        return 0;
+    }
+
+    for (;;) {
+        if (scanner->index_pos == scanner->index_count) {
+            if (scanner->scanned < scanner->end) {
+                index_window(scanner);
+                continue;
+            }
+            // The last record has no trailing newline
+            if (count < max_fields) finish_field(field_start, scanner->end, &fields[count]);
+            count++;
+            scanner->position = scanner->end;
+            scanner->terminated = 0;
+            break;
+        }
+
+        const char *separator = scanner->window + scanner->index[scanner->index_pos++];
+        if (count < max_fields) finish_field(field_start, separator, &fields[count]);
+        count++;
+        field_start = separator + 1;
+        if (*separator == '\n') {
+            scanner->position = field_start;
+            scanner->terminated = 1;
+            break;
+        }
+    }
+
+    *num_fields = count;
+    return 1;
+}
+
+size_t csv_copy_field(const CsvField *field, char *dst) {
+    if (!field->escaped) {
+        memcpy(dst, field->start, field->length);
+        dst[field->length] = '\0';
+        return field->length;
+    }
+    const char *src = field->start;
+    const char *src_end = field->start + field->length;
+    char *out = dst;
+    while (src < src_end) {
+        *out++ = *src;
+        src += (*src == '"' && src + 1 < src_end && src[1] == '"') ? 2 : 1;
+    }
+    *out = '\0';
+    return (size_t)(out - dst);
+}
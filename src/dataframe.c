@@ -1,35 +1,144 @@
 #include "dataframe.h"
+#include "dfhash.h"
+#include "dfstats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 
 // Function to create a new dataframe
 DataFrame *create_dataframe(size_t num_rows, size_t num_columns) {
-    DataFrame *df = malloc(sizeof(DataFrame));
+    return create_dataframe_with_allocator(num_rows, num_columns, NULL);
+}
+
+// Function to create a new dataframe whose memory comes from the given allocator
+DataFrame *create_dataframe_with_allocator(size_t num_rows, size_t num_columns, const DataFrameAllocator *allocator) {
+    if (allocator == NULL) {
+        allocator = default_allocator();
+    }
+    DataFrame *df = allocator->allocate(allocator->context, sizeof(DataFrame));
     if (df == NULL) {
         fprintf(stderr, "Memory allocation failed for DataFrame\n");
         return NULL;
     }
 
-    df->columns = malloc(num_columns * sizeof(Column));
+    df->columns = allocator->allocate(allocator->context, num_columns * sizeof(Column));
     if (df->columns == NULL) {
         fprintf(stderr, "Memory allocation failed for Columns\n");
-        free(df);
+        allocator->release(allocator->context, df);
+        return NULL;
+    }
+
+    // Keep the name index at most half full
+    df->num_name_slots = 8;
+    while (df->num_name_slots < 2 * num_columns) {
+        df->num_name_slots *= 2;
+    }
+    df->name_slots = allocator->allocate(allocator->context, df->num_name_slots * sizeof(size_t));
+    if (df->name_slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for column name index\n");
+        allocator->release(allocator->context, df->columns);
+        allocator->release(allocator->context, df);
         return NULL;
     }
+    memset(df->name_slots, 0, df->num_name_slots * sizeof(size_t));
 
     df->num_columns = num_columns;
     df->num_rows = num_rows;
+    df->capacity = num_rows;
+    df->mapping = NULL;
+    df->mapping_size = 0;
+    df->allocator = *allocator;
+    df->parent = NULL;
+    df->refcount = 1;
 
     // Initialize columns
     for (size_t i = 0; i < num_columns; i++) {
-        df->columns[i].data.int_data = NULL;
+        memset(&df->columns[i].data, 0, sizeof(ColumnData));
+        df->columns[i].type = DATA_TYPE_INT;
+        df->columns[i].borrowed = 0;
+        df->columns[i].encoding = INT_ENCODING_PLAIN;
+        df->columns[i].allocator = &df->allocator;
         df->columns[i].name[0] = '\0'; // Initialize name to empty string
     }
     return df;
 }
 
+// Allocates memory for a column from its DataFrame's allocator
+static inline void *_column_alloc(const Column *col, size_t size) {
+    return col->allocator->allocate(col->allocator->context, size);
+}
+
+// Resizes memory of a column with its DataFrame's allocator
+static inline void *_column_realloc(const Column *col, void *ptr, size_t size) {
+    return col->allocator->reallocate(col->allocator->context, ptr, size);
+}
+
+// Releases memory of a column to its DataFrame's allocator
+static inline void _column_free(const Column *col, void *ptr) {
+    col->allocator->release(col->allocator->context, ptr);
+}
+
+// Probes the name index, returning the slot holding the name or the empty slot where it belongs
+static size_t _probe_column_name(const DataFrame *df, const char *name) {
+    size_t mask = df->num_name_slots - 1;
+    size_t slot = hash_bytes(name, strlen(name)) & mask;
+    while (df->name_slots[slot] != 0 && strcmp(df->columns[df->name_slots[slot] - 1].name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Function to find a column by name
+int find_column(const DataFrame *df, const char *name) {
+    if (df == NULL || name == NULL) {
+        return -1;
+    }
+    size_t slot = _probe_column_name(df, name);
+    return df->name_slots[slot] == 0 ? -1 : (int)(df->name_slots[slot] - 1);
+}
+
+// Adds a column to the name index, failing if another column has the same name
+static int _index_column_name(DataFrame *df, size_t column_index) {
+    const char *name = df->columns[column_index].name;
+    size_t slot = _probe_column_name(df, name);
+    if (df->name_slots[slot] != 0 && df->name_slots[slot] - 1 != column_index) {
+        fprintf(stderr, "Duplicate column name '%s'\n", name);
+        return -1;
+    }
+    df->name_slots[slot] = column_index + 1;
+    return 0;
+}
+
+// Names a column and updates the name index; the caller has checked the name is not taken
+static void _set_column_name(DataFrame *df, size_t column_index, const char *name) {
+    Column *col = &df->columns[column_index];
+    int renamed = col->name[0] != '\0' && strcmp(col->name, name) != 0;
+    strncpy(col->name, name, MAX_COLUMN_NAME_LENGTH - 1);
+    col->name[MAX_COLUMN_NAME_LENGTH - 1] = '\0'; // Ensure null termination
+    if (!renamed) {
+        _index_column_name(df, column_index);
+        return;
+    }
+
+    // Open addressing cannot drop the old name in place, rebuild the index
+    memset(df->name_slots, 0, df->num_name_slots * sizeof(size_t));
+    for (size_t i = 0; i < df->num_columns; i++) {
+        if (df->columns[i].name[0] != '\0') _index_column_name(df, i);
+    }
+}
+
+// Fails when views borrow the buffers of a DataFrame, which makes it read-only
+static int _check_no_views(const DataFrame *df) {
+    size_t views = __atomic_load_n(&df->refcount, __ATOMIC_ACQUIRE) - 1;
+    if (views > 0) {
+        fprintf(stderr, "DataFrame has %zu live views and cannot be modified\n", views);
+        return -1;
+    }
+    return 0;
+}
+
 // Validations performed when adding a column not relating to type
 int _validate_add_column(DataFrame *df, size_t column_index, const char *name){
     if (df == NULL || name == NULL) {
@@ -54,7 +163,14 @@ int _validate_add_column(DataFrame *df, size_t column_index, const char *name){
         fprintf(stderr, "Column name cannot be greater than %d\n", MAX_COLUMN_NAME_LENGTH);
         return -1;
     }
-    
+
+    // Ensure no other column has the name
+    int existing = find_column(df, name);
+    if (existing >= 0 && (size_t)existing != column_index) {
+        fprintf(stderr, "Duplicate column name '%s'\n", name);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -69,35 +185,48 @@ int add_column(DataFrame *df, DataType type, size_t column_index, const char *na
 
     Column *col = &df->columns[column_index];
 
-    strncpy(col->name, name, MAX_COLUMN_NAME_LENGTH - 1);
-    col->name[MAX_COLUMN_NAME_LENGTH - 1] = '\0'; // Ensure null termination
+    _set_column_name(df, column_index, name);
     col->type = type;
+    col->borrowed = 0;
+    col->encoding = INT_ENCODING_PLAIN;
 
     // Allocate memory for the column data with error checking
+    STATS_ADD(STATS_ALLOCATIONS, 1);
     switch (type) {
         case DATA_TYPE_INT:
-            col->data.int_data = malloc(df->num_rows * sizeof(int));
+            col->data.int_data = _column_alloc(col, df->capacity * sizeof(int));
             if (col->data.int_data == NULL) {
                 fprintf(stderr, "Memory allocation failed for INT column '%s'\n", name);
                 return -1;
             }
-            memset(col->data.int_data, 0, df->num_rows * sizeof(int)); // Initialize to 0
+            memset(col->data.int_data, 0, df->capacity * sizeof(int)); // Initialize to 0
             break;
         case DATA_TYPE_FLOAT:
-            col->data.float_data = malloc(df->num_rows * sizeof(float));
+            col->data.float_data = _column_alloc(col, df->capacity * sizeof(float));
             if (col->data.float_data == NULL) {
                 fprintf(stderr, "Memory allocation failed for FLOAT column '%s'\n", name);
                 return -1;
             }
-            memset(col->data.float_data, 0, df->num_rows * sizeof(float)); // Initialize to 0.0
+            memset(col->data.float_data, 0, df->capacity * sizeof(float)); // Initialize to 0.0
             break;
         case DATA_TYPE_STRING:
-            col->data.string_data = malloc(df->num_rows * sizeof(char *));
-            if (col->data.string_data == NULL) {
+            col->data.string_data.offsets = _column_alloc(col, df->capacity * sizeof(size_t));
+            if (col->data.string_data.offsets == NULL) {
                 fprintf(stderr, "Memory allocation failed for STRING column '%s'\n", name);
                 return -1;
             }
-            memset(col->data.string_data, 0, df->num_rows * sizeof(char *)); // Initialize to NULL
+            memset(col->data.string_data.offsets, 0xFF, df->capacity * sizeof(size_t)); // Initialize to STRING_NULL_OFFSET
+            col->data.string_data.bytes = NULL;
+            col->data.string_data.size = 0;
+            col->data.string_data.capacity = 0;
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            col->data.categorical_data.codes = _column_alloc(col, df->capacity * sizeof(int));
+            if (col->data.categorical_data.codes == NULL) {
+                fprintf(stderr, "Memory allocation failed for CATEGORICAL column '%s'\n", name);
+                return -1;
+            }
+            memset(col->data.categorical_data.codes, 0xFF, df->capacity * sizeof(int)); // Initialize to -1 (NULL)
             break;
         default:
             fprintf(stderr, "Unsupported DataType %d\n", type);
@@ -107,6 +236,101 @@ int add_column(DataFrame *df, DataType type, size_t column_index, const char *na
     return 0;
 }
 
+// Copies size bytes into a new allocation
+static void *_copy_block(const Column *col, const void *src, size_t size) {
+    STATS_ADD(STATS_ALLOCATIONS, 1);
+    void *copy = _column_alloc(col, size ? size : 1);
+    if (copy == NULL) {
+        fprintf(stderr, "Memory allocation failed for column copy of %zu bytes\n", size);
+        return NULL;
+    }
+    if (size) memcpy(copy, src, size);
+    return copy;
+}
+
+// Decodes an encoded INT column into plain ints
+static int _decode_column(Column *col, size_t num_rows) {
+    STATS_ADD(STATS_ALLOCATIONS, 1);
+    int *data = _column_alloc(col, (num_rows ? num_rows : 1) * sizeof(int));
+    if (data == NULL) {
+        fprintf(stderr, "Memory allocation failed decoding column '%s'\n", col->name);
+        return -1;
+    }
+    decode_ints(&col->data.encoded_ints, 0, num_rows, data);
+    if (!col->borrowed) {
+        free_encoded_ints(&col->data.encoded_ints, col->allocator);
+    }
+    col->data.int_data = data;
+    col->encoding = INT_ENCODING_PLAIN;
+    col->borrowed = 0;
+    return 0;
+}
+
+// Copies the data of a borrowed column into memory owned by the column, or
+// decodes an encoded column, before it is modified
+static int _own_column(Column *col, size_t num_rows) {
+    if (col->encoding != INT_ENCODING_PLAIN) {
+        return _decode_column(col, num_rows);
+    }
+    if (!col->borrowed) {
+        return 0;
+    }
+
+    switch (col->type) {
+        case DATA_TYPE_INT: {
+            int *data = _copy_block(col, col->data.int_data, num_rows * sizeof(int));
+            if (data == NULL) return -1;
+            col->data.int_data = data;
+            break;
+        }
+        case DATA_TYPE_FLOAT: {
+            float *data = _copy_block(col, col->data.float_data, num_rows * sizeof(float));
+            if (data == NULL) return -1;
+            col->data.float_data = data;
+            break;
+        }
+        case DATA_TYPE_STRING: {
+            StringData *strings = &col->data.string_data;
+            size_t *offsets = _copy_block(col, strings->offsets, num_rows * sizeof(size_t));
+            char *bytes = _copy_block(col, strings->bytes, strings->size);
+            if (offsets == NULL || bytes == NULL) {
+                _column_free(col, offsets);
+                _column_free(col, bytes);
+                return -1;
+            }
+            strings->offsets = offsets;
+            strings->bytes = bytes;
+            strings->capacity = strings->size ? strings->size : 1;
+            break;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            // The hash table is always owned, only the codes and dictionary are copied
+            CategoricalData *categorical = &col->data.categorical_data;
+            int *codes = _copy_block(col, categorical->codes, num_rows * sizeof(int));
+            size_t *offsets = _copy_block(col, categorical->dictionary.offsets, categorical->num_categories * sizeof(size_t));
+            char *bytes = _copy_block(col, categorical->dictionary.bytes, categorical->dictionary.size);
+            if (codes == NULL || offsets == NULL || bytes == NULL) {
+                _column_free(col, codes);
+                _column_free(col, offsets);
+                _column_free(col, bytes);
+                return -1;
+            }
+            categorical->codes = codes;
+            categorical->dictionary.offsets = offsets;
+            categorical->dictionary.bytes = bytes;
+            categorical->dictionary.capacity = categorical->dictionary.size ? categorical->dictionary.size : 1;
+            // Offsets and hashes were copied for exactly num_categories entries
+            categorical->offsets_capacity = categorical->num_categories;
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    col->borrowed = 0;
+    return 0;
+}
+
 // Function to set a value in the dataframe
 int set_value(DataFrame *df, size_t row, size_t column, const void *value) {
     if (df == NULL || value == NULL) {
@@ -118,8 +342,14 @@ int set_value(DataFrame *df, size_t row, size_t column, const void *value) {
         fprintf(stderr, "Index out of bounds (row: %zu, column: %zu)\n", row, column);
         return -1;
     }
+    if (_check_no_views(df) != 0) {
+        return -1;
+    }
 
     Column *col = &df->columns[column];
+    if (_own_column(col, df->num_rows) != 0) {
+        return -1;
+    }
     switch (col->type) {
         case DATA_TYPE_INT:
             col->data.int_data[row] = *(int *)value;
@@ -127,18 +357,9 @@ int set_value(DataFrame *df, size_t row, size_t column, const void *value) {
         case DATA_TYPE_FLOAT:
             col->data.float_data[row] = *(float *)value;
             break;
-        case DATA_TYPE_STRING: {
-            char **str_ptr = &col->data.string_data[row];
-            if (*str_ptr != NULL) {
-                free(*str_ptr);
-            }
-            *str_ptr = strdup((char *)value);
-            if (*str_ptr == NULL) {
-                fprintf(stderr, "strdup failed for row %zu, column %zu\n", row, column);
-                return -1;
-            }
-            break;
-        }
+        case DATA_TYPE_STRING:
+        case DATA_TYPE_CATEGORICAL:
+            return set_string_value(df, row, column, (const char *)value, strlen((const char *)value));
         default:
             fprintf(stderr, "Unsupported DataType %d\n", col->type);
             return -1;
@@ -146,10 +367,32 @@ int set_value(DataFrame *df, size_t row, size_t column, const void *value) {
     return 0;
 }
 
-// Function to get a value from the dataframe
-int get_value(const DataFrame *df, size_t row, size_t column, void *output) {
-    if (df == NULL || output == NULL) {
-        fprintf(stderr, "DataFrame or output is NULL\n");
+// Grows a string buffer of a column so that at least extra more bytes fit
+int _reserve_string_bytes(const Column *col, StringData *strings, size_t extra) {
+    if (strings->size + extra <= strings->capacity) {
+        return 0;
+    }
+
+    size_t capacity = strings->capacity ? strings->capacity : 64;
+    while (capacity < strings->size + extra) {
+        capacity *= 2;
+    }
+
+    STATS_ADD(STATS_ALLOCATIONS, 1);
+    char *bytes = _column_realloc(col, strings->bytes, capacity);
+    if (bytes == NULL) {
+        fprintf(stderr, "Memory allocation failed for string buffer of %zu bytes\n", capacity);
+        return -1;
+    }
+    strings->bytes = bytes;
+    strings->capacity = capacity;
+    return 0;
+}
+
+// Function to set a string value from a buffer of known length
+int set_string_value(DataFrame *df, size_t row, size_t column, const char *value, size_t length) {
+    if (df == NULL || value == NULL) {
+        fprintf(stderr, "DataFrame or value is NULL\n");
         return -1;
     }
 
@@ -157,68 +400,1099 @@ int get_value(const DataFrame *df, size_t row, size_t column, void *output) {
         fprintf(stderr, "Index out of bounds (row: %zu, column: %zu)\n", row, column);
         return -1;
     }
+    if (_check_no_views(df) != 0) {
+        return -1;
+    }
 
-    const Column *col = &df->columns[column];
+    Column *col = &df->columns[column];
+    if (_own_column(col, df->num_rows) != 0) {
+        return -1;
+    }
+    if (col->type == DATA_TYPE_CATEGORICAL) {
+        int code = intern_category(col, value, length);
+        if (code < 0) {
+            return -1;
+        }
+        col->data.categorical_data.codes[row] = code;
+        return 0;
+    }
+    if (col->type != DATA_TYPE_STRING) {
+        fprintf(stderr, "Column %zu is not a STRING column\n", column);
+        return -1;
+    }
+
+    // The value may point into this column's buffer, which can move when it grows
+    StringData *strings = &col->data.string_data;
+    int aliased = strings->bytes != NULL && value >= strings->bytes && value < strings->bytes + strings->size;
+    size_t aliased_offset = aliased ? (size_t)(value - strings->bytes) : 0;
+
+    if (_reserve_string_bytes(col, strings, length + 1) != 0) {
+        return -1;
+    }
+    if (aliased) {
+        value = strings->bytes + aliased_offset;
+    }
+
+    // Overwritten strings stay in the buffer until the column is destroyed
+    char *dst = strings->bytes + strings->size;
+    memcpy(dst, value, length);
+    dst[length] = '\0';
+    strings->offsets[row] = strings->size;
+    strings->size += length + 1;
+    return 0;
+}
+
+// Returns the length of a dictionary entry
+static size_t _category_length(const CategoricalData *categorical, size_t code) {
+    size_t end = code + 1 < categorical->num_categories ? categorical->dictionary.offsets[code + 1] : categorical->dictionary.size;
+    return end - categorical->dictionary.offsets[code] - 1;
+}
+
+// Probes the dictionary hash table, returning the slot holding the value or the empty slot where it belongs
+static size_t _probe_category(const CategoricalData *categorical, const char *value, size_t length, uint64_t hash) {
+    size_t mask = categorical->num_slots - 1;
+    size_t slot = hash & mask;
+    while (categorical->slots[slot] != 0) {
+        size_t code = (size_t)categorical->slots[slot] - 1;
+        if (categorical->hashes[code] == hash && _category_length(categorical, code) == length &&
+            memcmp(categorical->dictionary.bytes + categorical->dictionary.offsets[code], value, length) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Doubles the dictionary hash table and reinserts every entry from its stored hash
+static int _grow_category_slots(Column *column) {
+    CategoricalData *categorical = &column->data.categorical_data;
+    size_t num_slots = categorical->num_slots ? categorical->num_slots * 2 : 16;
+    int *slots = _column_alloc(column, num_slots * sizeof(int));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for category table of %zu slots\n", num_slots);
+        return -1;
+    }
+    memset(slots, 0, num_slots * sizeof(int));
+    for (size_t code = 0; code < categorical->num_categories; code++) {
+        size_t slot = categorical->hashes[code] & (num_slots - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+        slots[slot] = (int)code + 1;
+    }
+    _column_free(column, categorical->slots);
+    categorical->slots = slots;
+    categorical->num_slots = num_slots;
+    return 0;
+}
+
+// Function to find the dictionary code of a categorical value
+int find_category(const Column *column, const char *value, size_t length) {
+    const CategoricalData *categorical = &column->data.categorical_data;
+    if (categorical->num_slots == 0) {
+        return -1;
+    }
+    size_t slot = _probe_category(categorical, value, length, hash_bytes(value, length));
+    return categorical->slots[slot] - 1;
+}
+
+// Function to find or add the dictionary code of a categorical value
+int intern_category(Column *column, const char *value, size_t length) {
+    CategoricalData *categorical = &column->data.categorical_data;
+    if (column->borrowed) {
+        fprintf(stderr, "Cannot add categories to borrowed column '%s'\n", column->name);
+        return -1;
+    }
+    uint64_t hash = hash_bytes(value, length);
+
+    // Keep the table at most half full
+    if ((categorical->num_categories + 1) * 2 > categorical->num_slots && _grow_category_slots(column) != 0) {
+        return -1;
+    }
+
+    size_t slot = _probe_category(categorical, value, length, hash);
+    if (categorical->slots[slot] != 0) {
+        return categorical->slots[slot] - 1;
+    }
+
+    if (categorical->num_categories == categorical->offsets_capacity) {
+        size_t capacity = categorical->offsets_capacity ? categorical->offsets_capacity * 2 : 16;
+        size_t *offsets = _column_realloc(column, categorical->dictionary.offsets, capacity * sizeof(size_t));
+        if (offsets == NULL) {
+            fprintf(stderr, "Memory allocation failed for category dictionary\n");
+            return -1;
+        }
+        categorical->dictionary.offsets = offsets;
+        uint64_t *hashes = _column_realloc(column, categorical->hashes, capacity * sizeof(uint64_t));
+        if (hashes == NULL) {
+            fprintf(stderr, "Memory allocation failed for category dictionary\n");
+            return -1;
+        }
+        categorical->hashes = hashes;
+        categorical->offsets_capacity = capacity;
+    }
+
+    // The value may point into the dictionary, which can move when it grows
+    StringData *dictionary = &categorical->dictionary;
+    int aliased = dictionary->bytes != NULL && value >= dictionary->bytes && value < dictionary->bytes + dictionary->size;
+    size_t aliased_offset = aliased ? (size_t)(value - dictionary->bytes) : 0;
+    if (_reserve_string_bytes(column, dictionary, length + 1) != 0) {
+        return -1;
+    }
+    if (aliased) {
+        value = dictionary->bytes + aliased_offset;
+    }
+    memcpy(dictionary->bytes + dictionary->size, value, length);
+    dictionary->bytes[dictionary->size + length] = '\0';
+
+    int code = (int)categorical->num_categories++;
+    dictionary->offsets[code] = dictionary->size;
+    dictionary->size += length + 1;
+    categorical->hashes[code] = hash;
+    categorical->slots[slot] = code + 1;
+    return code;
+}
+
+// Function to add a column that borrows its data from the caller
+int attach_column(DataFrame *df, DataType type, size_t column_index, const char *name, const ColumnData *data) {
+    if (_validate_add_column(df, column_index, name) != 0) {
+        return -1;
+    }
+    if (data == NULL) {
+        fprintf(stderr, "Column data is NULL\n");
+        return -1;
+    }
+    if (type != DATA_TYPE_INT && type != DATA_TYPE_FLOAT && type != DATA_TYPE_STRING && type != DATA_TYPE_CATEGORICAL) {
+        fprintf(stderr, "Unsupported DataType %d\n", type);
+        return -1;
+    }
+
+    Column *col = &df->columns[column_index];
+    _set_column_name(df, column_index, name);
+    col->type = type;
+    col->data = *data;
+    col->borrowed = 1;
+    col->encoding = INT_ENCODING_PLAIN;
+
+    if (type == DATA_TYPE_STRING) {
+        col->data.string_data.capacity = col->data.string_data.size;
+    } else if (type == DATA_TYPE_CATEGORICAL) {
+        // Rebuild the lookup table, sized so that the first grow leaves it at most half full
+        CategoricalData *categorical = &col->data.categorical_data;
+        categorical->dictionary.capacity = categorical->dictionary.size;
+        categorical->offsets_capacity = categorical->num_categories;
+        categorical->slots = NULL;
+        categorical->num_slots = 8;
+        while (categorical->num_slots < categorical->num_categories) {
+            categorical->num_slots *= 2;
+        }
+        categorical->hashes = _column_alloc(col, (categorical->num_categories ? categorical->num_categories : 1) * sizeof(uint64_t));
+        if (categorical->hashes == NULL) {
+            fprintf(stderr, "Memory allocation failed for category dictionary\n");
+            categorical->num_slots = 0;
+            return -1;
+        }
+        for (size_t code = 0; code < categorical->num_categories; code++) {
+            const char *value = categorical->dictionary.bytes + categorical->dictionary.offsets[code];
+            categorical->hashes[code] = hash_bytes(value, _category_length(categorical, code));
+        }
+        if (_grow_category_slots(col) != 0) {
+            categorical->num_slots = 0;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Resizes the row arrays of a column from old_capacity to capacity rows; new rows are 0 or NULL
+static int _resize_column(Column *col, size_t num_rows, size_t old_capacity, size_t capacity) {
+    if (col->borrowed || col->encoding != INT_ENCODING_PLAIN) {
+        if (_own_column(col, num_rows) != 0) return -1;
+        old_capacity = num_rows;
+    }
+
+    size_t element_size;
+    void **data_ptr;
+    int fill;
     switch (col->type) {
         case DATA_TYPE_INT:
-            *(int *)output = col->data.int_data[row];
+            element_size = sizeof(int);
+            data_ptr = (void **)&col->data.int_data;
+            fill = 0;
             break;
         case DATA_TYPE_FLOAT:
-            *(float *)output = col->data.float_data[row];
+            element_size = sizeof(float);
+            data_ptr = (void **)&col->data.float_data;
+            fill = 0;
             break;
         case DATA_TYPE_STRING:
-            *(char **)output = col->data.string_data[row];
+            element_size = sizeof(size_t);
+            data_ptr = (void **)&col->data.string_data.offsets;
+            fill = 0xFF; // STRING_NULL_OFFSET
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            element_size = sizeof(int);
+            data_ptr = (void **)&col->data.categorical_data.codes;
+            fill = 0xFF; // -1, NULL
             break;
         default:
             fprintf(stderr, "Unsupported DataType %d\n", col->type);
             return -1;
     }
+
+    STATS_ADD(STATS_ALLOCATIONS, 1);
+    void *data = _column_realloc(col, *data_ptr, (capacity ? capacity : 1) * element_size);
+    if (data == NULL) {
+        fprintf(stderr, "Memory reallocation failed for column '%s'\n", col->name);
+        return -1;
+    }
+    *data_ptr = data;
+    if (capacity > old_capacity) {
+        memset((char *)data + old_capacity * element_size, fill, (capacity - old_capacity) * element_size);
+    }
+    return 0;
+}
+
+// Function to add an INT column, optionally compressed
+int add_int_column(DataFrame *df, size_t column_index, const char *name, const int *values, IntEncoding encoding) {
+    if (_validate_add_column(df, column_index, name) != 0) {
+        return -1;
+    }
+    if (values == NULL && df->num_rows > 0) {
+        fprintf(stderr, "Column values are NULL\n");
+        return -1;
+    }
+    if (encoding == INT_ENCODING_PLAIN) {
+        if (add_column(df, DATA_TYPE_INT, column_index, name) != 0) {
+            return -1;
+        }
+        if (df->num_rows > 0) memcpy(df->columns[column_index].data.int_data, values, df->num_rows * sizeof(int));
+        return 0;
+    }
+
+    EncodedInts encoded;
+    if (encode_ints(values, df->num_rows, encoding, &df->allocator, &encoded) != 0) {
+        return -1;
+    }
+    Column *col = &df->columns[column_index];
+    _set_column_name(df, column_index, name);
+    col->type = DATA_TYPE_INT;
+    col->borrowed = 0;
+    col->data.encoded_ints = encoded;
+    col->encoding = encoded.encoding;
     return 0;
 }
 
+// Function to compress or decode an INT column
+int encode_int_column(DataFrame *df, size_t column, IntEncoding encoding) {
+    if (df == NULL || column >= df->num_columns) {
+        fprintf(stderr, "DataFrame is NULL or column %zu out of bounds\n", column);
+        return -1;
+    }
+    Column *col = &df->columns[column];
+    if (col->type != DATA_TYPE_INT || col->name[0] == '\0') {
+        fprintf(stderr, "Column %zu is not an INT column\n", column);
+        return -1;
+    }
+    if (encoding < INT_ENCODING_PLAIN || encoding > INT_ENCODING_AUTO) {
+        fprintf(stderr, "Unsupported encoding %d\n", encoding);
+        return -1;
+    }
+    if (_check_no_views(df) != 0) {
+        return -1;
+    }
+    if (encoding == INT_ENCODING_PLAIN) {
+        // Decode into the full capacity so appends can use it
+        if (col->encoding == INT_ENCODING_PLAIN) return 0;
+        return _resize_column(col, df->num_rows, df->num_rows, df->capacity);
+    }
 
-// Function to free all allocated memory in the dataframe
-void destroy_dataframe(DataFrame *df) {
-    if (df == NULL) return;
+    // Re-encoding starts from plain ints
+    if (col->encoding != INT_ENCODING_PLAIN && _decode_column(col, df->num_rows) != 0) {
+        return -1;
+    }
+    EncodedInts encoded;
+    if (encode_ints(col->data.int_data, df->num_rows, encoding, col->allocator, &encoded) != 0) {
+        return -1;
+    }
+    if (!col->borrowed) {
+        _column_free(col, col->data.int_data);
+    }
+    col->borrowed = 0;
+    col->data.encoded_ints = encoded;
+    col->encoding = encoded.encoding;
+    return 0;
+}
 
-    // Free each column's data
+// Resizes every added column to capacity rows
+static int _resize_rows(DataFrame *df, size_t capacity) {
     for (size_t i = 0; i < df->num_columns; i++) {
-        Column *col = &df->columns[i];
-        if (col->data.int_data != NULL || col->data.float_data != NULL || col->data.string_data != NULL) {
-            if (col->type == DATA_TYPE_STRING) {
-                // Free each string in the column
-                for (size_t row = 0; row < df->num_rows; row++) {
-                    if (col->data.string_data[row] != NULL) {
-                        free(col->data.string_data[row]);
-                        col->data.string_data[row] = NULL;
-                    }
-                }
+        // Columns that were never added have no data yet, add_column allocates them
+        if (df->columns[i].name[0] == '\0') continue;
+        // Encoded columns already hold exactly num_rows rows
+        if (df->columns[i].encoding != INT_ENCODING_PLAIN && capacity <= df->num_rows) continue;
+        if (_resize_column(&df->columns[i], df->num_rows, df->capacity, capacity) != 0) {
+            return -1;
+        }
+    }
+    df->capacity = capacity;
+    return 0;
+}
+
+// Grows the capacity geometrically until count more rows fit
+static int _grow_rows(DataFrame *df, size_t count) {
+    if (count > SIZE_MAX - df->num_rows) {
+        fprintf(stderr, "Row count overflow appending %zu rows\n", count);
+        return -1;
+    }
+    size_t needed = df->num_rows + count;
+    if (needed <= df->capacity) {
+        // Borrowed and encoded columns only hold num_rows rows, give them the full capacity
+        for (size_t i = 0; i < df->num_columns; i++) {
+            Column *col = &df->columns[i];
+            if ((col->borrowed || col->encoding != INT_ENCODING_PLAIN) && _resize_column(col, df->num_rows, df->num_rows, df->capacity) != 0) {
+                return -1;
             }
-            // Free the data array
-            switch (col->type) {
-                case DATA_TYPE_INT:
-                    free(col->data.int_data);
-                    break;
-                case DATA_TYPE_FLOAT:
-                    free(col->data.float_data);
-                    break;
-                case DATA_TYPE_STRING:
-                    free(col->data.string_data);
-                    break;
-                default:
-                    // Do nothing for unsupported types
-                    break;
-            }
-            col->data.int_data = NULL;
-            col->data.float_data = NULL;
-            col->data.string_data = NULL;
-        }
-    }
-
-    // Free columns array
-    free(df->columns);
+        }
+        return 0;
+    }
+    size_t capacity = df->capacity > 8 ? df->capacity : 8;
+    while (capacity < needed) {
+        capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+    }
+    return _resize_rows(df, capacity);
+}
+
+// Stores 0 or NULL in a range of rows of an owned column
+static void _clear_rows(Column *col, size_t start_row, size_t count) {
+    switch (col->type) {
+        case DATA_TYPE_INT:
+            memset(col->data.int_data + start_row, 0, count * sizeof(int));
+            break;
+        case DATA_TYPE_FLOAT:
+            memset(col->data.float_data + start_row, 0, count * sizeof(float));
+            break;
+        case DATA_TYPE_STRING:
+            memset(col->data.string_data.offsets + start_row, 0xFF, count * sizeof(size_t));
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            memset(col->data.categorical_data.codes + start_row, 0xFF, count * sizeof(int));
+            break;
+    }
+}
+
+// Function to allocate room for at least capacity rows
+int reserve_rows(DataFrame *df, size_t capacity) {
+    if (df == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return -1;
+    }
+    if (capacity <= df->capacity) {
+        return 0;
+    }
+    if (_check_no_views(df) != 0) {
+        return -1;
+    }
+    return _resize_rows(df, capacity);
+}
+
+// Function to release the rows allocated beyond num_rows
+int shrink_to_fit(DataFrame *df) {
+    if (df == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return -1;
+    }
+    if (df->capacity == df->num_rows) {
+        return 0;
+    }
+    if (_check_no_views(df) != 0) {
+        return -1;
+    }
+    return _resize_rows(df, df->num_rows);
+}
+
+// Function to append one row to the dataframe
+int append_row(DataFrame *df, const void *const *values) {
+    if (df == NULL || values == NULL) {
+        fprintf(stderr, "DataFrame or values are NULL\n");
+        return -1;
+    }
+    if (_check_no_views(df) != 0 || _grow_rows(df, 1) != 0) {
+        return -1;
+    }
+
+    size_t row = df->num_rows++;
+    for (size_t i = 0; i < df->num_columns; i++) {
+        if (values[i] == NULL) {
+            _clear_rows(&df->columns[i], row, 1);
+        } else if (set_value(df, row, i, values[i]) != 0) {
+            df->num_rows--;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to append a batch of rows to the dataframe
+int append_rows(DataFrame *df, const void *const *values, size_t count) {
+    if (df == NULL || values == NULL) {
+        fprintf(stderr, "DataFrame or values are NULL\n");
+        return -1;
+    }
+    if (_check_no_views(df) != 0 || _grow_rows(df, count) != 0) {
+        return -1;
+    }
+
+    size_t start_row = df->num_rows;
+    df->num_rows += count;
+    for (size_t i = 0; i < df->num_columns; i++) {
+        if (values[i] == NULL) {
+            _clear_rows(&df->columns[i], start_row, count);
+        } else if (set_values(df, i, start_row, count, values[i]) != 0) {
+            df->num_rows = start_row;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to get a value from the dataframe
+int get_value(const DataFrame *df, size_t row, size_t column, void *output) {
+    if (df == NULL || output == NULL) {
+        fprintf(stderr, "DataFrame or output is NULL\n");
+        return -1;
+    }
+
+    if (column >= df->num_columns || row >= df->num_rows) {
+        fprintf(stderr, "Index out of bounds (row: %zu, column: %zu)\n", row, column);
+        return -1;
+    }
+
+    const Column *col = &df->columns[column];
+    switch (col->type) {
+        case DATA_TYPE_INT:
+            *(int *)output = column_int(col, row);
+            break;
+        case DATA_TYPE_FLOAT:
+            *(float *)output = col->data.float_data[row];
+            break;
+        case DATA_TYPE_STRING:
+            *(const char **)output = column_string(col, row);
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            *(const char **)output = category_string(col, col->data.categorical_data.codes[row]);
+            break;
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    return 0;
+}
+
+
+// Validates a column range and returns the column, or NULL on failure
+static Column *_column_range(const DataFrame *df, size_t column, size_t start_row, size_t count) {
+    if (df == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return NULL;
+    }
+
+    if (column >= df->num_columns || start_row > df->num_rows || count > df->num_rows - start_row) {
+        fprintf(stderr, "Range out of bounds (rows: %zu-%zu, column: %zu)\n", start_row, start_row + count, column);
+        return NULL;
+    }
+    return &df->columns[column];
+}
+
+// Validates a span request for a column of the expected type
+static const Column *_span_column(const DataFrame *df, size_t column, DataType type, const void *data, size_t *length) {
+    if (data == NULL || length == NULL) {
+        fprintf(stderr, "Span output is NULL\n");
+        return NULL;
+    }
+    const Column *col = _column_range(df, column, 0, 0);
+    if (col == NULL) {
+        return NULL;
+    }
+    if (col->type != type) {
+        fprintf(stderr, "Column %zu has type %d, expected %d\n", column, col->type, type);
+        return NULL;
+    }
+    *length = df->num_rows;
+    return col;
+}
+
+// Function to get the values of an INT column
+int get_int_span(const DataFrame *df, size_t column, const int **data, size_t *length) {
+    const Column *col = _span_column(df, column, DATA_TYPE_INT, data, length);
+    if (col == NULL) {
+        return -1;
+    }
+    if (col->encoding != INT_ENCODING_PLAIN) {
+        fprintf(stderr, "Column '%s' is encoded and has no contiguous values\n", col->name);
+        return -1;
+    }
+    *data = col->data.int_data;
+    return 0;
+}
+
+// Function to get the values of a FLOAT column
+int get_float_span(const DataFrame *df, size_t column, const float **data, size_t *length) {
+    const Column *col = _span_column(df, column, DATA_TYPE_FLOAT, data, length);
+    if (col == NULL) {
+        return -1;
+    }
+    *data = col->data.float_data;
+    return 0;
+}
+
+// Function to get the codes of a CATEGORICAL column
+int get_category_codes(const DataFrame *df, size_t column, const int **codes, size_t *length) {
+    const Column *col = _span_column(df, column, DATA_TYPE_CATEGORICAL, codes, length);
+    if (col == NULL) {
+        return -1;
+    }
+    *codes = col->data.categorical_data.codes;
+    return 0;
+}
+
+// Function to set a range of rows from an array
+int set_values(DataFrame *df, size_t column, size_t start_row, size_t count, const void *values) {
+    Column *col = _column_range(df, column, start_row, count);
+    if (col == NULL || values == NULL) {
+        if (values == NULL) fprintf(stderr, "Values are NULL\n");
+        return -1;
+    }
+    if (_check_no_views(df) != 0 || _own_column(col, df->num_rows) != 0) {
+        return -1;
+    }
+
+    switch (col->type) {
+        case DATA_TYPE_INT:
+            memcpy(col->data.int_data + start_row, values, count * sizeof(int));
+            break;
+        case DATA_TYPE_FLOAT:
+            memcpy(col->data.float_data + start_row, values, count * sizeof(float));
+            break;
+        case DATA_TYPE_STRING: {
+            const char *const *strings = values;
+            StringData *data = &col->data.string_data;
+
+            // Reserve the whole range at once
+            size_t total = 0;
+            int aliased = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (strings[i] == NULL) continue;
+                total += strlen(strings[i]) + 1;
+                aliased |= data->bytes != NULL && strings[i] >= data->bytes && strings[i] < data->bytes + data->size;
+            }
+            if (aliased) {
+                // Values from this column's own buffer move when it grows, copy them one by one
+                for (size_t i = 0; i < count; i++) {
+                    if (strings[i] == NULL) {
+                        data->offsets[start_row + i] = STRING_NULL_OFFSET;
+                    } else if (set_value(df, start_row + i, column, strings[i]) != 0) {
+                        return -1;
+                    }
+                }
+                break;
+            }
+            if (_reserve_string_bytes(col, data, total) != 0) {
+                return -1;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (strings[i] == NULL) {
+                    data->offsets[start_row + i] = STRING_NULL_OFFSET;
+                    continue;
+                }
+                size_t length = strlen(strings[i]) + 1;
+                memcpy(data->bytes + data->size, strings[i], length);
+                data->offsets[start_row + i] = data->size;
+                data->size += length;
+            }
+            break;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            const char *const *strings = values;
+            int *codes = col->data.categorical_data.codes + start_row;
+            for (size_t i = 0; i < count; i++) {
+                codes[i] = strings[i] == NULL ? -1 : intern_category(col, strings[i], strlen(strings[i]));
+                if (strings[i] != NULL && codes[i] < 0) {
+                    return -1;
+                }
+            }
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    return 0;
+}
+
+// Function to set a range of rows to one value
+int fill_values(DataFrame *df, size_t column, size_t start_row, size_t count, const void *value) {
+    Column *col = _column_range(df, column, start_row, count);
+    if (col == NULL || value == NULL) {
+        if (value == NULL) fprintf(stderr, "Value is NULL\n");
+        return -1;
+    }
+    if (_check_no_views(df) != 0 || _own_column(col, df->num_rows) != 0) {
+        return -1;
+    }
+
+    switch (col->type) {
+        case DATA_TYPE_INT: {
+            int fill = *(const int *)value;
+            int *data = col->data.int_data + start_row;
+            for (size_t i = 0; i < count; i++) data[i] = fill;
+            break;
+        }
+        case DATA_TYPE_FLOAT: {
+            float fill = *(const float *)value;
+            float *data = col->data.float_data + start_row;
+            for (size_t i = 0; i < count; i++) data[i] = fill;
+            break;
+        }
+        case DATA_TYPE_STRING: {
+            if (count == 0) break;
+            // Store the string once and point every row at it
+            if (set_string_value(df, start_row, column, value, strlen(value)) != 0) {
+                return -1;
+            }
+            size_t *offsets = col->data.string_data.offsets + start_row;
+            for (size_t i = 1; i < count; i++) offsets[i] = offsets[0];
+            break;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            int code = intern_category(col, value, strlen(value));
+            if (code < 0) {
+                return -1;
+            }
+            int *codes = col->data.categorical_data.codes + start_row;
+            for (size_t i = 0; i < count; i++) codes[i] = code;
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    return 0;
+}
+
+// Function to copy a range of rows between columns of the same type
+int copy_values(DataFrame *dst, size_t dst_column, size_t dst_row,
+                const DataFrame *src, size_t src_column, size_t src_row, size_t count) {
+    Column *to = _column_range(dst, dst_column, dst_row, count);
+    const Column *from = _column_range(src, src_column, src_row, count);
+    if (to == NULL || from == NULL) {
+        return -1;
+    }
+    if (to->type != from->type) {
+        fprintf(stderr, "Cannot copy column of type %d into column of type %d\n", from->type, to->type);
+        return -1;
+    }
+    if (_check_no_views(dst) != 0 || _own_column(to, dst->num_rows) != 0) {
+        return -1;
+    }
+
+    switch (to->type) {
+        case DATA_TYPE_INT:
+            if (from->encoding != INT_ENCODING_PLAIN) {
+                decode_ints(&from->data.encoded_ints, src_row, count, to->data.int_data + dst_row);
+                break;
+            }
+            memmove(to->data.int_data + dst_row, from->data.int_data + src_row, count * sizeof(int));
+            break;
+        case DATA_TYPE_FLOAT:
+            memmove(to->data.float_data + dst_row, from->data.float_data + src_row, count * sizeof(float));
+            break;
+        case DATA_TYPE_STRING: {
+            // Reserve first; the source may be the destination and move when it grows
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                const char *value = column_string(from, src_row + i);
+                if (value != NULL) total += strlen(value) + 1;
+            }
+            StringData *data = &to->data.string_data;
+            if (_reserve_string_bytes(to, data, total) != 0) {
+                return -1;
+            }
+            // Resolve every source row before any destination offset is overwritten
+            size_t *offsets = malloc((count ? count : 1) * sizeof(size_t));
+            if (offsets == NULL) {
+                fprintf(stderr, "Memory allocation failed while copying strings\n");
+                return -1;
+            }
+            for (size_t i = 0; i < count; i++) {
+                const char *value = column_string(from, src_row + i);
+                if (value == NULL) {
+                    offsets[i] = STRING_NULL_OFFSET;
+                    continue;
+                }
+                size_t length = strlen(value) + 1;
+                memcpy(data->bytes + data->size, value, length);
+                offsets[i] = data->size;
+                data->size += length;
+            }
+            memcpy(data->offsets + dst_row, offsets, count * sizeof(size_t));
+            free(offsets);
+            break;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            if (to == from) {
+                memmove(to->data.categorical_data.codes + dst_row, from->data.categorical_data.codes + src_row, count * sizeof(int));
+                break;
+            }
+            // Translate each source code once
+            size_t num_categories = from->data.categorical_data.num_categories;
+            int *map = malloc((num_categories ? num_categories : 1) * sizeof(int));
+            if (map == NULL) {
+                fprintf(stderr, "Memory allocation failed while copying categories\n");
+                return -1;
+            }
+            for (size_t code = 0; code < num_categories; code++) map[code] = -2;
+            const int *codes = from->data.categorical_data.codes + src_row;
+            int *out = to->data.categorical_data.codes + dst_row;
+            for (size_t i = 0; i < count; i++) {
+                int code = codes[i];
+                if (code >= 0 && map[code] == -2) {
+                    const char *value = category_string(from, code);
+                    map[code] = intern_category(to, value, strlen(value));
+                    if (map[code] < 0) {
+                        free(map);
+                        return -1;
+                    }
+                }
+                out[i] = code < 0 ? -1 : map[code];
+            }
+            free(map);
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", to->type);
+            return -1;
+    }
+    return 0;
+}
+
+// Function to gather rows of one column into another
+int gather_values(DataFrame *dst, size_t dst_column, const DataFrame *src, size_t src_column,
+                  const size_t *rows, size_t count) {
+    Column *to = _column_range(dst, dst_column, 0, count);
+    const Column *from = _column_range(src, src_column, 0, 0);
+    if (to == NULL || from == NULL) {
+        return -1;
+    }
+    if (rows == NULL && count > 0) {
+        fprintf(stderr, "Rows are NULL\n");
+        return -1;
+    }
+    if (to == from) {
+        fprintf(stderr, "Cannot gather column '%s' into itself\n", to->name);
+        return -1;
+    }
+    if (to->type != from->type) {
+        fprintf(stderr, "Cannot gather column of type %d into column of type %d\n", from->type, to->type);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (rows[i] != GATHER_NULL_ROW && rows[i] >= src->num_rows) {
+            fprintf(stderr, "Row %zu out of bounds (rows: %zu)\n", rows[i], src->num_rows);
+            return -1;
+        }
+    }
+    if (_check_no_views(dst) != 0 || _own_column(to, dst->num_rows) != 0) {
+        return -1;
+    }
+
+    switch (to->type) {
+        case DATA_TYPE_INT: {
+            int *out = to->data.int_data;
+            if (from->encoding != INT_ENCODING_PLAIN) {
+                for (size_t i = 0; i < count; i++) out[i] = rows[i] == GATHER_NULL_ROW ? 0 : column_int(from, rows[i]);
+                break;
+            }
+            const int *in = from->data.int_data;
+            for (size_t i = 0; i < count; i++) out[i] = rows[i] == GATHER_NULL_ROW ? 0 : in[rows[i]];
+            break;
+        }
+        case DATA_TYPE_FLOAT: {
+            const float *in = from->data.float_data;
+            float *out = to->data.float_data;
+            for (size_t i = 0; i < count; i++) out[i] = rows[i] == GATHER_NULL_ROW ? 0.0f : in[rows[i]];
+            break;
+        }
+        case DATA_TYPE_STRING: {
+            size_t total = 0;
+            for (size_t i = 0; i < count; i++) {
+                const char *value = rows[i] == GATHER_NULL_ROW ? NULL : column_string(from, rows[i]);
+                if (value != NULL) total += strlen(value) + 1;
+            }
+            StringData *data = &to->data.string_data;
+            if (_reserve_string_bytes(to, data, total) != 0) {
+                return -1;
+            }
+            for (size_t i = 0; i < count; i++) {
+                const char *value = rows[i] == GATHER_NULL_ROW ? NULL : column_string(from, rows[i]);
+                if (value == NULL) {
+                    data->offsets[i] = STRING_NULL_OFFSET;
+                    continue;
+                }
+                size_t length = strlen(value) + 1;
+                memcpy(data->bytes + data->size, value, length);
+                data->offsets[i] = data->size;
+                data->size += length;
+            }
+            break;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            // Translate each source code once
+            size_t num_categories = from->data.categorical_data.num_categories;
+            int *map = malloc((num_categories ? num_categories : 1) * sizeof(int));
+            if (map == NULL) {
+                fprintf(stderr, "Memory allocation failed while gathering categories\n");
+                return -1;
+            }
+            for (size_t code = 0; code < num_categories; code++) map[code] = -2;
+            const int *codes = from->data.categorical_data.codes;
+            int *out = to->data.categorical_data.codes;
+            for (size_t i = 0; i < count; i++) {
+                int code = rows[i] == GATHER_NULL_ROW ? -1 : codes[rows[i]];
+                if (code >= 0 && map[code] == -2) {
+                    const char *value = category_string(from, code);
+                    map[code] = intern_category(to, value, strlen(value));
+                    if (map[code] < 0) {
+                        free(map);
+                        return -1;
+                    }
+                }
+                out[i] = code < 0 ? -1 : map[code];
+            }
+            free(map);
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", to->type);
+            return -1;
+    }
+    return 0;
+}
+
+// Function to create a new dataframe from a list of rows
+DataFrame *take_rows(const DataFrame *df, const size_t *rows, size_t count) {
+    if (df == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return NULL;
+    }
+
+    DataFrame *out = create_dataframe(count, df->num_columns);
+    if (out == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < df->num_columns; i++) {
+        const Column *col = &df->columns[i];
+        if (add_column(out, col->type, i, col->name) != 0 || gather_values(out, i, df, i, rows, count) != 0) {
+            destroy_dataframe(out);
+            return NULL;
+        }
+    }
+    return out;
+}
+
+// Points a view column at count rows of a source column from start_row
+static int _attach_view_column(Column *col, const Column *src, size_t src_rows, size_t start_row, size_t count) {
+    memcpy(col->name, src->name, MAX_COLUMN_NAME_LENGTH);
+    col->type = src->type;
+    col->data = src->data;
+    col->borrowed = 1;
+    col->encoding = INT_ENCODING_PLAIN;
+    if (src->name[0] == '\0') {
+        // Never added, there is nothing to borrow
+        memset(&col->data, 0, sizeof(ColumnData));
+        col->borrowed = 0;
+        return 0;
+    }
+
+    switch (src->type) {
+        case DATA_TYPE_INT: {
+            if (src->encoding == INT_ENCODING_PLAIN) {
+                col->data.int_data += start_row;
+                break;
+            }
+            if (start_row == 0 && count == src_rows) {
+                col->encoding = src->encoding;
+                break;
+            }
+            // Encoded rows cannot be addressed at an offset, decode the range instead
+            memset(&col->data, 0, sizeof(ColumnData));
+            col->borrowed = 0;
+            STATS_ADD(STATS_ALLOCATIONS, 1);
+            int *data = _column_alloc(col, (count ? count : 1) * sizeof(int));
+            if (data == NULL) {
+                fprintf(stderr, "Memory allocation failed decoding column '%s'\n", col->name);
+                return -1;
+            }
+            decode_ints(&src->data.encoded_ints, start_row, count, data);
+            col->data.int_data = data;
+            break;
+        }
+        case DATA_TYPE_FLOAT:
+            col->data.float_data += start_row;
+            break;
+        case DATA_TYPE_STRING:
+            col->data.string_data.offsets += start_row;
+            col->data.string_data.capacity = col->data.string_data.size;
+            break;
+        case DATA_TYPE_CATEGORICAL: {
+            // Codes and dictionary are borrowed, the lookup table is always owned by the column
+            CategoricalData *categorical = &col->data.categorical_data;
+            categorical->codes += start_row;
+            categorical->dictionary.capacity = categorical->dictionary.size;
+            categorical->offsets_capacity = categorical->num_categories;
+            categorical->hashes = _copy_block(col, src->data.categorical_data.hashes, categorical->num_categories * sizeof(uint64_t));
+            categorical->slots = _copy_block(col, src->data.categorical_data.slots, categorical->num_slots * sizeof(int));
+            if (categorical->hashes == NULL || categorical->slots == NULL) {
+                _column_free(col, categorical->hashes);
+                _column_free(col, categorical->slots);
+                categorical->hashes = NULL;
+                categorical->slots = NULL;
+                categorical->num_slots = 0;
+                return -1;
+            }
+            break;
+        }
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", src->type);
+            memset(&col->data, 0, sizeof(ColumnData));
+            col->borrowed = 0;
+            return -1;
+    }
+    return 0;
+}
+
+// Creates a view of num_rows rows from start_row of the given columns, or of every column when columns is NULL
+static DataFrame *_create_view(const DataFrame *df, size_t start_row, size_t num_rows, const size_t *columns, size_t num_columns) {
+    DataFrame *view = create_dataframe(num_rows, num_columns);
+    if (view == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < num_columns; i++) {
+        const Column *src = &df->columns[columns ? columns[i] : i];
+        if (_attach_view_column(&view->columns[i], src, df->num_rows, start_row, num_rows) != 0 ||
+            (src->name[0] != '\0' && _index_column_name(view, i) != 0)) {
+            destroy_dataframe(view);
+            return NULL;
+        }
+    }
+
+    // The reference keeps df's buffers alive; it is bookkeeping, df's contents are untouched
+    DataFrame *parent = (DataFrame *)df;
+    __atomic_add_fetch(&parent->refcount, 1, __ATOMIC_RELAXED);
+    view->parent = parent;
+    return view;
+}
+
+// Function to create a view of a range of rows
+DataFrame *slice_rows(const DataFrame *df, size_t start_row, size_t count) {
+    if (df == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return NULL;
+    }
+    if (start_row > df->num_rows || count > df->num_rows - start_row) {
+        fprintf(stderr, "Range out of bounds (rows: %zu-%zu of %zu)\n", start_row, start_row + count, df->num_rows);
+        return NULL;
+    }
+    return _create_view(df, start_row, count, NULL, df->num_columns);
+}
+
+// Function to create a view of a subset of columns
+DataFrame *select_columns(const DataFrame *df, const size_t *columns, size_t count) {
+    if (df == NULL || (columns == NULL && count > 0)) {
+        fprintf(stderr, "DataFrame or columns are NULL\n");
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (columns[i] >= df->num_columns) {
+            fprintf(stderr, "Column index %zu out of bounds\n", columns[i]);
+            return NULL;
+        }
+    }
+    return _create_view(df, 0, df->num_rows, columns, count);
+}
+
+// Function to free all allocated memory in the dataframe
+void destroy_dataframe(DataFrame *df) {
+    if (df == NULL) return;
+
+    // Views still borrow from this DataFrame, the last of them releases it
+    if (__atomic_sub_fetch(&df->refcount, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    DataFrame *parent = df->parent;
+
+    if (df->mapping != NULL) {
+        munmap(df->mapping, df->mapping_size);
+        df->mapping = NULL;
+    }
+
+    // An allocator that owns all of the memory releases it in one call
+    if (df->allocator.destroy != NULL) {
+        DataFrameAllocator allocator = df->allocator;
+        allocator.destroy(allocator.context);
+        destroy_dataframe(parent);
+        return;
+    }
+
+    // Free each column's data
+    for (size_t i = 0; i < df->num_columns; i++) {
+        Column *col = &df->columns[i];
+        if (col->borrowed) {
+            // Borrowed data belongs to the caller or the mapping, only the category table is ours
+            if (col->type == DATA_TYPE_CATEGORICAL) {
+                _column_free(col, col->data.categorical_data.hashes);
+                _column_free(col, col->data.categorical_data.slots);
+            }
+            memset(&col->data, 0, sizeof(ColumnData));
+            continue;
+        }
+        switch (col->type) {
+            case DATA_TYPE_INT:
+                if (col->encoding != INT_ENCODING_PLAIN) {
+                    free_encoded_ints(&col->data.encoded_ints, col->allocator);
+                } else {
+                    _column_free(col, col->data.int_data);
+                }
+                break;
+            case DATA_TYPE_FLOAT:
+                _column_free(col, col->data.float_data);
+                break;
+            case DATA_TYPE_STRING:
+                // A string column is released with two frees regardless of its row count
+                _column_free(col, col->data.string_data.bytes);
+                _column_free(col, col->data.string_data.offsets);
+                break;
+            case DATA_TYPE_CATEGORICAL:
+                _column_free(col, col->data.categorical_data.codes);
+                _column_free(col, col->data.categorical_data.dictionary.bytes);
+                _column_free(col, col->data.categorical_data.dictionary.offsets);
+                _column_free(col, col->data.categorical_data.hashes);
+                _column_free(col, col->data.categorical_data.slots);
+                break;
+            default:
+                // Do nothing for unsupported types
+                break;
+        }
+        memset(&col->data, 0, sizeof(ColumnData));
+    }
+
+    // Free columns array, name index and DataFrame
+    df->allocator.release(df->allocator.context, df->name_slots);
+    df->name_slots = NULL;
+    df->allocator.release(df->allocator.context, df->columns);
     df->columns = NULL;
+    df->allocator.release(df->allocator.context, df);
 
-    // Free DataFrame
-    free(df);
+    // Drop this view's reference to the DataFrame it borrowed from
+    destroy_dataframe(parent);
 }
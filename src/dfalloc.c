@@ -0,0 +1,201 @@
+#include "dfalloc.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Block size used when arena_create is passed 0
+#define DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+// Alignment of every arena allocation
+#define ARENA_ALIGNMENT 16
+
+// Precedes every arena allocation so that it can be copied when it grows
+typedef struct {
+    size_t size;    // Bytes requested
+    size_t padding; // Keeps the allocation aligned
+} ArenaHeader;
+
+// Memory requested from malloc, handed out front to back
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;    // Usable bytes in data
+    size_t used;    // Bytes handed out
+    size_t padding; // Keeps data aligned
+    unsigned char data[];
+} ArenaBlock;
+
+struct DataFrameArena {
+    ArenaBlock *head;    // First block
+    ArenaBlock *current; // Block being filled; the blocks after it are empty
+    void *last;          // Most recent allocation, which can be resized in place
+    size_t block_size;   // Size of regular blocks
+};
+
+static void *malloc_allocate(void *context, size_t size) {
+    (void)context;
+    return malloc(size);
+}
+
+static void *malloc_reallocate(void *context, void *ptr, size_t size) {
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void malloc_release(void *context, void *ptr) {
+    (void)context;
+    free(ptr);
+}
+
+static const DataFrameAllocator malloc_allocator = {malloc_allocate, malloc_reallocate, malloc_release, NULL, NULL};
+
+// Function to get the allocator backed by malloc
+const DataFrameAllocator *default_allocator(void) {
+    return &malloc_allocator;
+}
+
+static inline size_t align_size(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+// Function to create an arena
+DataFrameArena *arena_create(size_t block_size) {
+    DataFrameArena *arena = calloc(1, sizeof(DataFrameArena));
+    if (arena == NULL) {
+        fprintf(stderr, "Memory allocation failed for arena\n");
+        return NULL;
+    }
+    arena->block_size = block_size ? align_size(block_size) : DEFAULT_BLOCK_SIZE;
+    return arena;
+}
+
+// Function to allocate from an arena
+void *arena_alloc(DataFrameArena *arena, size_t size) {
+    if (arena == NULL || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    size_t needed = sizeof(ArenaHeader) + align_size(size);
+
+    // Move on to the emptied blocks kept by arena_reset before adding one
+    ArenaBlock *block = arena->current;
+    while (block != NULL && block->used + needed > block->size) {
+        block = block->next;
+        if (block != NULL) block->used = 0;
+    }
+    if (block == NULL) {
+        size_t block_size = needed > arena->block_size ? needed : arena->block_size;
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if (block == NULL) {
+            fprintf(stderr, "Memory allocation failed for arena block of %zu bytes\n", block_size);
+            return NULL;
+        }
+        block->size = block_size;
+        block->used = 0;
+        if (arena->current == NULL) {
+            block->next = arena->head;
+            arena->head = block;
+        } else {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+    }
+
+    ArenaHeader *header = (ArenaHeader *)(block->data + block->used);
+    header->size = size;
+    block->used += needed;
+    arena->current = block;
+    arena->last = header + 1;
+    return header + 1;
+}
+
+// Function to resize an arena allocation
+void *arena_realloc(DataFrameArena *arena, void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return arena_alloc(arena, size);
+    }
+    if (arena == NULL || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    ArenaHeader *header = (ArenaHeader *)ptr - 1;
+    if (ptr == arena->last) {
+        ArenaBlock *block = arena->current;
+        size_t start = (size_t)((unsigned char *)header - block->data);
+        size_t needed = sizeof(ArenaHeader) + align_size(size);
+        if (start + needed <= block->size) {
+            block->used = start + needed;
+            header->size = size;
+            return ptr;
+        }
+    } else if (size <= header->size) {
+        header->size = size;
+        return ptr;
+    }
+
+    void *moved = arena_alloc(arena, size);
+    if (moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, ptr, header->size < size ? header->size : size);
+    return moved;
+}
+
+// Function to free an arena allocation
+void arena_free(DataFrameArena *arena, void *ptr) {
+    if (arena == NULL || ptr == NULL || ptr != arena->last) {
+        return;
+    }
+    ArenaHeader *header = (ArenaHeader *)ptr - 1;
+    arena->current->used = (size_t)((unsigned char *)header - arena->current->data);
+    arena->last = NULL;
+}
+
+// Function to discard every allocation of an arena
+void arena_reset(DataFrameArena *arena) {
+    if (arena == NULL) return;
+    arena->current = arena->head;
+    if (arena->head != NULL) arena->head->used = 0;
+    arena->last = NULL;
+}
+
+// Function to count the bytes held by an arena
+size_t arena_capacity(const DataFrameArena *arena) {
+    size_t total = 0;
+    for (const ArenaBlock *block = arena ? arena->head : NULL; block != NULL; block = block->next) {
+        total += block->size;
+    }
+    return total;
+}
+
+// Function to free an arena
+void arena_destroy(DataFrameArena *arena) {
+    if (arena == NULL) return;
+    ArenaBlock *block = arena->head;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+static void *arena_hook_allocate(void *context, size_t size) {
+    return arena_alloc(context, size);
+}
+
+static void *arena_hook_reallocate(void *context, void *ptr, size_t size) {
+    return arena_realloc(context, ptr, size);
+}
+
+static void arena_hook_release(void *context, void *ptr) {
+    arena_free(context, ptr);
+}
+
+static void arena_hook_destroy(void *context) {
+    arena_destroy(context);
+}
+
+// Function to get allocator hooks backed by an arena
+DataFrameAllocator arena_allocator(DataFrameArena *arena, int owned) {
+    DataFrameAllocator allocator = {arena_hook_allocate, arena_hook_reallocate, arena_hook_release,
+                                    owned ? arena_hook_destroy : NULL, arena};
+    return allocator;
+}
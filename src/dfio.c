@@ -1,70 +1,315 @@
 #include "dataframe.h"
+#include "dfio.h"
+#include "csv_scan.h"
+#include "numparse.h"
+#include "dfstats.h"
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-// Function to save the dataframe to a CSV file
-void save_to_csv(const DataFrame *df, const char *filename) {
+// Size of the CSV writer's output buffer
+#define WRITER_BUFFER_SIZE (1024 * 1024)
+
+// Read-ahead tuning used when the caller passes none
+static const ReadAheadOptions DEFAULT_READAHEAD = {0, 0, 0, COMPRESSION_AUTO};
+
+// Precision used by save_to_csv for FLOAT columns
+#define DEFAULT_FLOAT_PRECISION 2
+
+// Block size of the scratch arena holding the fields of a line in read_csv
+#define SCRATCH_BLOCK_SIZE (64 * 1024)
+
+// Records read, tokenized and converted together, so that the stage timers run
+// once per window rather than once per record
+#define RECORD_WINDOW 256
+
+// Longest line read_csv accepts
+#define MAX_LINE_LENGTH 1024
+
+/**
+ * Buffered output for the CSV writer. Rows are formatted into buffer and
+ * handed to the kernel with large write calls.
+ */
+typedef struct {
+    int fd;         // Output file, or -1 when writing through compressor
+    Compressor *compressor; // Compresses the output into its own file, or NULL
+    char *buffer;   // Output buffer
+    size_t used;    // Bytes waiting in buffer
+    int failed;     // Set once a write fails
+#ifdef DF_ENABLE_STATS
+    uint64_t write_ns; // Time spent in write calls, kept out of the formatting time
+#endif
+} CsvWriter;
+
+/**
+ * Helper function to write the whole buffer to the file.
+ */
+static void writer_flush(CsvWriter *writer) {
+#ifdef DF_ENABLE_STATS
+    uint64_t start = stats_now();
+#endif
+    if (writer->compressor != NULL) {
+        // The compressor counts the compressed bytes it writes
+        if (!writer->failed && compressor_write(writer->compressor, writer->buffer, writer->used) != 0) {
+            writer->failed = 1;
+        }
+        writer->used = 0;
+    } else {
+        size_t written = 0;
+        while (!writer->failed && written < writer->used) {
+            ssize_t bytes = write(writer->fd, writer->buffer + written, writer->used - written);
+            if (bytes < 0) {
+                perror("Could not write CSV output");
+                writer->failed = 1;
+                break;
+            }
+            written += (size_t)bytes;
+        }
+        writer->used = 0;
+        STATS_ADD(STATS_BYTES_WRITTEN, written);
+    }
+#ifdef DF_ENABLE_STATS
+    uint64_t elapsed = stats_now() - start;
+    stats_record(STAGE_WRITE, elapsed);
+    writer->write_ns += elapsed;
+#endif
+}
+
+/**
+ * Helper function to make room for length more bytes, which must not exceed
+ * the buffer size. Returns the position to write them at.
+ */
+static inline char *writer_reserve(CsvWriter *writer, size_t length) {
+    if (writer->used + length > WRITER_BUFFER_SIZE) writer_flush(writer);
+    return writer->buffer + writer->used;
+}
+
+/**
+ * Helper function to append bytes of any length.
+ */
+static void writer_append(CsvWriter *writer, const char *data, size_t length) {
+    while (length > 0) {
+        if (writer->used == WRITER_BUFFER_SIZE) writer_flush(writer);
+        size_t chunk = WRITER_BUFFER_SIZE - writer->used;
+        if (chunk > length) chunk = length;
+        memcpy(writer->buffer + writer->used, data, chunk);
+        writer->used += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+static inline void writer_put(CsvWriter *writer, char c) {
+    *writer_reserve(writer, 1) = c;
+    writer->used++;
+}
+
+/**
+ * Helper function to format an unsigned integer, padded with zeros to at least
+ * min_digits digits. Returns the number of characters written to out.
+ */
+static inline size_t format_digits(uint64_t value, int min_digits, char *out) {
+    char digits[24];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count < min_digits) digits[count++] = '0';
+    for (int i = 0; i < count; i++) out[i] = digits[count - 1 - i];
+    return (size_t)count;
+}
+
+/**
+ * Helper function to write an int in decimal.
+ */
+static inline void write_int(CsvWriter *writer, int value) {
+    char *out = writer_reserve(writer, 12);
+    size_t length = 0;
+    uint64_t magnitude = (uint64_t)(value < 0 ? -(int64_t)value : (int64_t)value);
+    if (value < 0) out[length++] = '-';
+    length += format_digits(magnitude, 1, out + length);
+    writer->used += length;
+}
+
+/**
+ * Helper function to write a float with a fixed number of decimals, producing
+ * the same text as printf("%.*f"). Values whose scaled magnitude fits in 32
+ * bits and is not close to a rounding tie are formatted with integer
+ * arithmetic; everything else falls back to snprintf.
+ */
+static void write_float(CsvWriter *writer, float value, int precision) {
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+    if (precision < (int)(sizeof(powers) / sizeof(powers[0])) && isfinite(value)) {
+        double scaled = fabs((double)value) * powers[precision];
+        double fraction = scaled - floor(scaled);
+        if (scaled < 4294967296.0 && fabs(fraction - 0.5) > 1e-4) {
+            uint64_t digits = (uint64_t)(scaled + 0.5);
+            uint64_t unit = (uint64_t)powers[precision];
+            char *out = writer_reserve(writer, 24);
+            size_t length = 0;
+            if (signbit(value)) out[length++] = '-';
+            length += format_digits(digits / unit, 1, out + length);
+            if (precision > 0) {
+                out[length++] = '.';
+                length += format_digits(digits % unit, precision, out + length);
+            }
+            writer->used += length;
+            return;
+        }
+    }
+
+    char text[512];
+    int length = snprintf(text, sizeof(text), "%.*f", precision, value);
+    if (length < 0) return;
+    if ((size_t)length < sizeof(text)) {
+        writer_append(writer, text, (size_t)length);
+        return;
+    }
+    char *large = malloc((size_t)length + 1);
+    if (!large) {
+        fprintf(stderr, "Memory allocation failed while formatting a float\n");
+        writer->failed = 1;
+        return;
+    }
+    snprintf(large, (size_t)length + 1, "%.*f", precision, value);
+    writer_append(writer, large, (size_t)length);
+    free(large);
+}
+
+/**
+ * Helper function to write a quoted string, doubling embedded quotes. Runs of
+ * bytes between quotes are located with memchr and copied in one piece.
+ */
+static void write_quoted(CsvWriter *writer, const char *value) {
+    size_t length = strlen(value);
+    writer_put(writer, '"');
+    for (;;) {
+        const char *quote = memchr(value, '"', length);
+        if (quote == NULL) {
+            writer_append(writer, value, length);
+            break;
+        }
+        size_t run = (size_t)(quote - value) + 1;
+        writer_append(writer, value, run);
+        writer_put(writer, '"');
+        value += run;
+        length -= run;
+    }
+    writer_put(writer, '"');
+}
+
+/**
+ * Function to save the dataframe to a CSV file with the given options.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param filename The name of the CSV file.
+ * @param options Output options, or NULL for the defaults.
+ * @return 0 on success, -1 on failure.
+ */
+int save_to_csv_with_options(const DataFrame *df, const char *filename, const CsvWriteOptions *options) {
     if (df == NULL || filename == NULL) {
         fprintf(stderr, "DataFrame or filename is NULL\n");
-        return;
+        return -1;
     }
 
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        perror("Could not open file");
-        return;
+    int precision = options ? options->float_precision : DEFAULT_FLOAT_PRECISION;
+    if (precision < 0) {
+        fprintf(stderr, "Float precision cannot be negative\n");
+        return -1;
     }
 
-    // Write column names
+    // Check that every column name is not empty
     for (size_t i = 0; i < df->num_columns; i++) {
-        // Check if column name is not empty
         if (df->columns[i].name[0] == '\0') {
             fprintf(stderr, "Error: Column %zu name is empty\n", i);
-            fclose(file);
-            return;
+            return -1;
+        }
+    }
+
+    CsvWriter writer = {.fd = -1};
+    writer.buffer = malloc(WRITER_BUFFER_SIZE);
+    if (!writer.buffer) {
+        fprintf(stderr, "Memory allocation failed for CSV writer\n");
+        return -1;
+    }
+    Compression compression = compression_for_file(filename, options ? options->compression : COMPRESSION_AUTO);
+    if (compression != COMPRESSION_NONE) {
+        writer.compressor = compressor_open(filename, compression, options ? options->compression_level : 0);
+        if (!writer.compressor) {
+            free(writer.buffer);
+            return -1;
         }
+    } else {
+        writer.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (writer.fd < 0) {
+            perror("Could not open file");
+            free(writer.buffer);
+            return -1;
+        }
+    }
 
-        fprintf(file, "\"%s\"%s", df->columns[i].name, (i == df->num_columns - 1) ? "\n" : ",");
+    // Write column names
+    for (size_t i = 0; i < df->num_columns; i++) {
+        write_quoted(&writer, df->columns[i].name);
+        writer_put(&writer, (i == df->num_columns - 1) ? '\n' : ',');
     }
 
     // Write data rows
-    for (size_t row = 0; row < df->num_rows; row++) {
+#ifdef DF_ENABLE_STATS
+    uint64_t format_start = stats_now();
+#endif
+    for (size_t row = 0; row < df->num_rows && !writer.failed; row++) {
         for (size_t col = 0; col < df->num_columns; col++) {
             const Column *column = &df->columns[col];
             switch (column->type) {
                 case DATA_TYPE_INT:
-                    fprintf(file, "%d", column->data.int_data[row]);
+                    write_int(&writer, column_int(column, row));
                     break;
                 case DATA_TYPE_FLOAT:
-                    fprintf(file, "%.2f", column->data.float_data[row]);
+                    write_float(&writer, column->data.float_data[row], precision);
                     break;
                 case DATA_TYPE_STRING:
-                    if (column->data.string_data[row] != NULL) {
-                        // Escape double quotes by replacing " with ""
-                        fprintf(file, "\"");
-                        for (char *c = column->data.string_data[row]; *c != '\0'; c++) {
-                            if (*c == '\"') {
-                                fprintf(file, "\"\"");
-                            } else {
-                                fprintf(file, "%c", *c);
-                            }
-                        }
-                        fprintf(file, "\"");
-                    } else {
-                        fprintf(file, "\"NULL\"");
-                    }
+                case DATA_TYPE_CATEGORICAL: {
+                    const char *value = column_text(column, row);
+                    write_quoted(&writer, value != NULL ? value : "NULL");
                     break;
+                }
                 default:
-                    fprintf(file, "\"UNKNOWN\"");
+                    writer_append(&writer, "\"UNKNOWN\"", 9);
                     break;
             }
-            fprintf(file, "%s", (col == df->num_columns - 1) ? "\n" : ",");
+            writer_put(&writer, (col == df->num_columns - 1) ? '\n' : ',');
         }
     }
+    STATS_ADD(STATS_ROWS_WRITTEN, df->num_rows);
+#ifdef DF_ENABLE_STATS
+    stats_record(STAGE_FORMAT, stats_now() - format_start - writer.write_ns);
+#endif
 
-    fclose(file);
+    writer_flush(&writer);
+    int status = writer.failed ? -1 : 0;
+    if (writer.compressor) {
+        if (compressor_close(writer.compressor) != 0) status = -1;
+    } else if (close(writer.fd) != 0) {
+        perror("Could not close file");
+        status = -1;
+    }
+    free(writer.buffer);
+    return status;
+}
+
+// Function to save the dataframe to a CSV file
+void save_to_csv(const DataFrame *df, const char *filename) {
+    save_to_csv_with_options(df, filename, NULL);
 }
 
 // Function to print the dataframe to the console (for debugging)
@@ -85,14 +330,15 @@ void print_dataframe(const DataFrame *df) {
             const Column *column = &df->columns[col];
             switch (column->type) {
                 case DATA_TYPE_INT:
-                    printf("%d\t", column->data.int_data[row]);
+                    printf("%d\t", column_int(column, row));
                     break;
                 case DATA_TYPE_FLOAT:
                     printf("%.2f\t", column->data.float_data[row]);
                     break;
                 case DATA_TYPE_STRING:
-                    if (column->data.string_data[row] != NULL) {
-                        printf("%s\t", column->data.string_data[row]);
+                case DATA_TYPE_CATEGORICAL:
+                    if (column_text(column, row) != NULL) {
+                        printf("%s\t", column_text(column, row));
                     } else {
                         printf("NULL\t");
                     }
@@ -106,103 +352,48 @@ void print_dataframe(const DataFrame *df) {
     }
 }
 
-/**
- * Helper function to trim whitespace from both ends of a string.
- */
-static char *trim_whitespace(char *str) {
-    char *end;
-    // Trim leading space
-    while(isspace((unsigned char)*str)) str++;
-    if(*str == 0)  // All spaces?
-        return str;
-    // Trim trailing space
-    end = str + strlen(str) - 1;
-    while(end > str && isspace((unsigned char)*end)) end--;
-    // Write new null terminator
-    end[1] = '\0';
-    return str;
-}
-
 /**
  * Helper function to split a CSV line into fields.
- * Handles basic quoted fields.
+ * Handles quoted fields; separators are located by the vectorized scanner.
+ * The fields and the array holding them come from the scratch arena, which the
+ * caller resets once they are no longer needed.
  */
-static int split_csv_line(char *line, char ***fields, size_t *num_fields) {
-    size_t capacity = 10; // Initial capacity
+static int split_csv_line(CsvScanner *scanner, DataFrameArena *scratch, char *line, char ***fields, size_t *num_fields) {
+    size_t capacity = 16; // Initial capacity
     size_t count = 0;
-    char **result = malloc(capacity * sizeof(char *));
-    if (!result) {
+    const char *end = line + strlen(line);
+    CsvField *spans = arena_alloc(scratch, capacity * sizeof(CsvField));
+    if (!spans) {
         fprintf(stderr, "Memory allocation failed in split_csv_line\n");
         return -1;
     }
 
-    char *ptr = line;
-    while (*ptr) {
-        // Allocate space for a new field
-        if (count >= capacity) {
-            capacity *= 2;
-            char **temp = realloc(result, capacity * sizeof(char *));
-            if (!temp) {
-                fprintf(stderr, "Memory reallocation failed in split_csv_line\n");
-                free(result);
-                return -1;
-            }
-            result = temp;
+    csv_scanner_reset(scanner, line, end);
+    if (csv_scanner_next_record(scanner, spans, capacity, &count) && count > capacity) {
+        // Too many fields for the first guess, rescan with the exact count
+        spans = arena_realloc(scratch, spans, count * sizeof(CsvField));
+        if (!spans) {
+            fprintf(stderr, "Memory reallocation failed in split_csv_line\n");
+            return -1;
         }
+        capacity = count;
+        csv_scanner_reset(scanner, line, end);
+        csv_scanner_next_record(scanner, spans, capacity, &count);
+    }
 
-        // Check if field is quoted
-        if (*ptr == '"') {
-            ptr++; // Skip opening quote
-            char *start = ptr;
-            while (*ptr && !(*ptr == '"' && (*(ptr + 1) == ',' || *(ptr + 1) == '\0'))) {
-                if (*ptr == '"' && *(ptr + 1) == '"') {
-                    ptr += 2; // Skip escaped quote
-                } else {
-                    ptr++;
-                }
-            }
-            size_t len = ptr - start;
-            char *field = malloc(len + 1);
-            if (!field) {
-                fprintf(stderr, "Memory allocation failed for field in split_csv_line\n");
-                // Free previously allocated fields
-                for (size_t i = 0; i < count; i++) free(result[i]);
-                free(result);
-                return -1;
-            }
-            strncpy(field, start, len);
-            field[len] = '\0';
-            // Replace double quotes with single quotes
-            char *src = field, *dst = field;
-            while (*src) {
-                if (*src == '"' && *(src + 1) == '"') {
-                    *dst++ = '"';
-                    src += 2;
-                } else {
-                    *dst++ = *src++;
-                }
-            }
-            *dst = '\0';
-            result[count++] = field;
-            if (*ptr == '"') ptr++; // Skip closing quote
-            if (*ptr == ',') ptr++; // Skip comma
-        } else {
-            // Unquoted field
-            char *start = ptr;
-            while (*ptr && *ptr != ',') ptr++;
-            size_t len = ptr - start;
-            char *field = malloc(len + 1);
-            if (!field) {
-                fprintf(stderr, "Memory allocation failed for field in split_csv_line\n");
-                for (size_t i = 0; i < count; i++) free(result[i]);
-                free(result);
-                return -1;
-            }
-            strncpy(field, start, len);
-            field[len] = '\0';
-            result[count++] = trim_whitespace(field);
-            if (*ptr == ',') ptr++; // Skip comma
+    char **result = arena_alloc(scratch, (count ? count : 1) * sizeof(char *));
+    if (!result) {
+        fprintf(stderr, "Memory allocation failed in split_csv_line\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        result[i] = arena_alloc(scratch, spans[i].length + 1);
+        if (!result[i]) {
+            fprintf(stderr, "Memory allocation failed for field in split_csv_line\n");
+            return -1;
         }
+        csv_copy_field(&spans[i], result[i]);
     }
 
     *fields = result;
@@ -211,16 +402,14 @@ static int split_csv_line(char *line, char ***fields, size_t *num_fields) {
 }
 
 /**
- * Function to count the number of lines in a file.
+ * Helper function to report a field that could not be converted to a number.
+ * Long fields are cut short in the message.
  */
-static size_t count_lines(FILE *fp) {
-    size_t lines = 0;
-    int c;
-    while ((c = fgetc(fp)) != EOF) {
-        if (c == '\n') lines++;
-    }
-    rewind(fp);
-    return lines;
+static void report_parse_error(ParseStatus status, const char *start, size_t length,
+                               const char *column, size_t row) {
+    int shown = length > 40 ? 40 : (int)length;
+    fprintf(stderr, "Failed to parse '%.*s%s' in column '%s' at row %zu: %s\n",
+            shown, start, (size_t)shown < length ? "..." : "", column, row, parse_status_message(status));
 }
 
 /**
@@ -232,16 +421,32 @@ static size_t count_lines(FILE *fp) {
  * @return Pointer to the created DataFrame, or NULL on failure.
  */
 DataFrame *read_csv(const char *filename, DataType *types, size_t num_columns) {
+    // Compressed files are decompressed on a reader thread ahead of parsing
+    if (compression_for_file(filename, COMPRESSION_AUTO) != COMPRESSION_NONE) {
+        return read_csv_pipelined(filename, types, num_columns, NULL);
+    }
+
     FILE *fp = fopen(filename, "r");
     if (!fp) {
         fprintf(stderr, "Could not open file '%s'\n", filename);
         return NULL;
     }
 
+    // Fields of one window of lines live in scratch, which is reset per window
+    CsvScanner scanner;
+    DataFrameArena *scratch = arena_create(SCRATCH_BLOCK_SIZE);
+    if (!scratch || csv_scanner_init(&scanner, NULL, NULL) != 0) {
+        arena_destroy(scratch);
+        fclose(fp);
+        return NULL;
+    }
+
     // Read the header line
-    char line[1024];
+    char line[MAX_LINE_LENGTH];
     if (!fgets(line, sizeof(line), fp)) {
         fprintf(stderr, "Failed to read header from '%s'\n", filename);
+        csv_scanner_free(&scanner);
+        arena_destroy(scratch);
         fclose(fp);
         return NULL;
     }
@@ -249,7 +454,9 @@ DataFrame *read_csv(const char *filename, DataType *types, size_t num_columns) {
     // Split header into fields
     char **header_fields = NULL;
     size_t header_count = 0;
-    if (split_csv_line(line, &header_fields, &header_count) != 0) {
+    if (split_csv_line(&scanner, scratch, line, &header_fields, &header_count) != 0) {
+        csv_scanner_free(&scanner);
+        arena_destroy(scratch);
         fclose(fp);
         return NULL;
     }
@@ -257,96 +464,1656 @@ DataFrame *read_csv(const char *filename, DataType *types, size_t num_columns) {
     // Validate column count
     if (header_count != num_columns) {
         fprintf(stderr, "Header column count (%zu) does not match expected (%zu)\n", header_count, num_columns);
-        for (size_t i = 0; i < header_count; i++) free(header_fields[i]);
-        free(header_fields);
+        csv_scanner_free(&scanner);
+        arena_destroy(scratch);
         fclose(fp);
         return NULL;
     }
 
-    // Create the DataFrame with an estimated number of rows
-    size_t estimated_rows = count_lines(fp) - 1; // Subtract header
-    DataFrame *df = create_dataframe(estimated_rows, num_columns);
-    if (!df) {
-        for (size_t i = 0; i < header_count; i++) free(header_fields[i]);
-        free(header_fields);
-        fclose(fp);
-        return NULL;
+    // Start empty and grow the DataFrame as rows are appended
+    DataFrame *df = create_dataframe(0, num_columns);
+    int *ints = malloc(num_columns * sizeof(int));
+    float *floats = malloc(num_columns * sizeof(float));
+    const void **values = malloc(num_columns * sizeof(void *));
+    char (*lines)[MAX_LINE_LENGTH] = malloc(RECORD_WINDOW * sizeof(*lines));
+    char **window_fields[RECORD_WINDOW];
+    if (!df || !ints || !floats || !values || !lines) {
+        if (df) fprintf(stderr, "Memory allocation failed while reading '%s'\n", filename);
+        goto fail;
     }
 
     // Add columns with specified types
     for (size_t i = 0; i < num_columns; i++) {
         if (add_column(df, types[i], i, header_fields[i]) != 0) {
             fprintf(stderr, "Failed to add column '%s'\n", header_fields[i]);
-            // Cleanup
-            for (size_t j = 0; j < header_count; j++) free(header_fields[j]);
-            free(header_fields);
-            destroy_dataframe(df);
-            fclose(fp);
-            return NULL;
+            goto fail;
         }
     }
 
-    // Cleanup header fields
-    for (size_t i = 0; i < header_count; i++) free(header_fields[i]);
-    free(header_fields);
-
-    // Read and parse each data line
-    size_t current_row = 0;
-    while (fgets(line, sizeof(line), fp)) {
-        // Remove potential newline characters
-        line[strcspn(line, "\r\n")] = 0;
+    // Read, split and convert the data lines a window at a time
+    for (;;) {
+        arena_reset(scratch);
+        size_t count = 0;
+        STATS_TIMER_START(read_timer);
+        while (count < RECORD_WINDOW && fgets(lines[count], sizeof(lines[count]), fp)) {
+            STATS_ADD(STATS_BYTES_READ, strlen(lines[count]));
+            count++;
+        }
+        STATS_TIMER_STOP(read_timer, STAGE_READ);
+        if (count == 0) break;
 
-        // Split the line into fields
-        char **fields = NULL;
-        size_t field_count = 0;
-        if (split_csv_line(line, &fields, &field_count) != 0) {
-            fprintf(stderr, "Failed to parse line %zu\n", current_row + 2); // +2 for header and 0-index
-            destroy_dataframe(df);
-            fclose(fp);
-            return NULL;
+        // Split the lines into fields
+        STATS_TIMER_START(tokenize_timer);
+        for (size_t k = 0; k < count; k++) {
+            size_t field_count = 0;
+            lines[k][strcspn(lines[k], "\r\n")] = 0; // Remove potential newline characters
+            if (split_csv_line(&scanner, scratch, lines[k], &window_fields[k], &field_count) != 0) {
+                fprintf(stderr, "Failed to parse line %zu\n", df->num_rows + k + 2); // +2 for header and 0-index
+                goto fail;
+            }
+            if (field_count != num_columns) {
+                fprintf(stderr, "Field count (%zu) does not match number of columns (%zu) at line %zu\n", field_count, num_columns, df->num_rows + k + 2);
+                goto fail;
+            }
         }
+        STATS_TIMER_STOP(tokenize_timer, STAGE_TOKENIZE);
 
-        // Validate field count
-        if (field_count != num_columns) {
-            fprintf(stderr, "Field count (%zu) does not match number of columns (%zu) at line %zu\n", field_count, num_columns, current_row + 2);
-            for (size_t i = 0; i < field_count; i++) free(fields[i]);
-            free(fields);
-            destroy_dataframe(df);
-            fclose(fp);
-            return NULL;
+        // Convert the fields and append them as new rows
+        STATS_TIMER_START(convert_timer);
+        for (size_t k = 0; k < count; k++) {
+            char **fields = window_fields[k];
+            for (size_t i = 0; i < num_columns; i++) {
+                ParseStatus status = PARSE_OK;
+                if (types[i] == DATA_TYPE_INT) {
+                    status = parse_int32(fields[i], strlen(fields[i]), &ints[i]);
+                    values[i] = &ints[i];
+                } else if (types[i] == DATA_TYPE_FLOAT) {
+                    status = parse_float32(fields[i], strlen(fields[i]), &floats[i]);
+                    values[i] = &floats[i];
+                } else {
+                    values[i] = fields[i];
+                }
+                if (status > PARSE_EMPTY) {
+                    report_parse_error(status, fields[i], strlen(fields[i]), df->columns[i].name, df->num_rows);
+                    goto fail;
+                }
+            }
+            if (append_row(df, values) != 0) {
+                fprintf(stderr, "Failed to append row %zu\n", df->num_rows);
+                goto fail;
+            }
         }
+        STATS_TIMER_STOP(convert_timer, STAGE_CONVERT);
+        STATS_ADD(STATS_ROWS_PARSED, count);
+    }
 
-        // Set values in the DataFrame
-        for (size_t i = 0; i < num_columns; i++) {
-            if (types[i] == DATA_TYPE_INT) {
-                int value = atoi(fields[i]);
-                if (set_value(df, current_row, i, &value) != 0) {
-                    fprintf(stderr, "Failed to set INT value at row %zu, column %zu\n", current_row, i);
+    // Release the rows reserved beyond the last one read
+    shrink_to_fit(df);
+
+    free(ints);
+    free(floats);
+    free(values);
+    free(lines);
+    csv_scanner_free(&scanner);
+    arena_destroy(scratch);
+    fclose(fp);
+    return df;
+
+fail:
+    free(ints);
+    free(floats);
+    free(values);
+    free(lines);
+    destroy_dataframe(df);
+    csv_scanner_free(&scanner);
+    arena_destroy(scratch);
+    fclose(fp);
+    return NULL;
+}
+
+/**
+ * Helper function to store one parsed record in the given row of the DataFrame.
+ * String cells are copied straight from the field bytes. Column i is read from
+ * fields[projection[i]], or from fields[i] when projection is NULL; the other
+ * fields are never looked at.
+ */
+static int store_csv_record(DataFrame *df, size_t row, const CsvField *fields, const size_t *projection) {
+    for (size_t i = 0; i < df->num_columns; i++) {
+        Column *column = &df->columns[i];
+        const CsvField *field = &fields[projection ? projection[i] : i];
+        switch (column->type) {
+            case DATA_TYPE_INT: {
+                // Empty fields store 0
+                ParseStatus status = parse_int32(field->start, field->length, &column->data.int_data[row]);
+                if (status > PARSE_EMPTY) {
+                    report_parse_error(status, field->start, field->length, column->name, row);
+                    return -1;
+                }
+                break;
+            }
+            case DATA_TYPE_FLOAT: {
+                ParseStatus status = parse_float32(field->start, field->length, &column->data.float_data[row]);
+                if (status > PARSE_EMPTY) {
+                    report_parse_error(status, field->start, field->length, column->name, row);
+                    return -1;
+                }
+                break;
+            }
+            case DATA_TYPE_STRING: {
+                if (set_string_value(df, row, i, field->start, field->length) != 0) {
+                    fprintf(stderr, "Failed to set STRING value at row %zu, column %zu\n", row, i);
+                    return -1;
+                }
+                if (field->escaped) {
+                    // Collapse escaped quotes in place and give back the saved bytes
+                    StringData *strings = &column->data.string_data;
+                    size_t length = csv_copy_field(field, strings->bytes + strings->offsets[row]);
+                    strings->size -= field->length - length;
                 }
-            } else if (types[i] == DATA_TYPE_FLOAT) {
-                float value = atof(fields[i]);
-                if (set_value(df, current_row, i, &value) != 0) {
-                    fprintf(stderr, "Failed to set FLOAT value at row %zu, column %zu\n", current_row, i);
+                break;
+            }
+            case DATA_TYPE_CATEGORICAL: {
+                const char *value = field->start;
+                size_t length = field->length;
+                char buffer[256];
+                char *unescaped = NULL;
+                if (field->escaped) {
+                    // Dictionary lookups need the collapsed value
+                    unescaped = length < sizeof(buffer) ? buffer : malloc(length + 1);
+                    if (!unescaped) {
+                        fprintf(stderr, "Memory allocation failed for CATEGORICAL value at row %zu, column %zu\n", row, i);
+                        return -1;
+                    }
+                    length = csv_copy_field(field, unescaped);
+                    value = unescaped;
                 }
-            } else if (types[i] == DATA_TYPE_STRING) {
-                if (set_value(df, current_row, i, fields[i]) != 0) {
-                    fprintf(stderr, "Failed to set STRING value at row %zu, column %zu\n", current_row, i);
+                int code = intern_category(column, value, length);
+                if (unescaped && unescaped != buffer) free(unescaped);
+                if (code < 0) {
+                    fprintf(stderr, "Failed to set CATEGORICAL value at row %zu, column %zu\n", row, i);
+                    return -1;
                 }
+                column->data.categorical_data.codes[row] = code;
+                break;
             }
+            default:
+                fprintf(stderr, "Unsupported DataType %d\n", column->type);
+                return -1;
         }
+    }
+    return 0;
+}
+
+/**
+ * Helper function to estimate the number of rows in [ptr, end) from the
+ * newline density of a leading sample.
+ */
+static size_t estimate_rows(const char *ptr, const char *end) {
+    const size_t sample_size = 64 * 1024;
+    size_t remaining = (size_t)(end - ptr);
+    size_t sample = remaining < sample_size ? remaining : sample_size;
+    size_t lines = 0;
+    const char *c = ptr;
+    const char *sample_end = ptr + sample;
+    while ((c = memchr(c, '\n', (size_t)(sample_end - c))) != NULL) {
+        lines++;
+        c++;
+    }
+    if (sample == remaining) return lines + 1;
+    return (size_t)((double)remaining * lines / sample) + 1;
+}
+
+/**
+ * Helper function to compute the 1-based line number of pos within data.
+ * Only used to report errors, so it rescans from the start of the buffer.
+ */
+static size_t line_number(const char *data, const char *pos) {
+    size_t line = 1;
+    const char *c = data;
+    while (c < pos && (c = memchr(c, '\n', (size_t)(pos - c))) != NULL) {
+        line++;
+        c++;
+    }
+    return line;
+}
+
+/**
+ * A CSV file mapped into memory, with its header already parsed.
+ */
+typedef struct {
+    const char *data;   // Start of the mapping
+    size_t size;        // Size of the mapping in bytes
+    const char *body;   // First byte after the header record
+    char **names;       // Column names from the header
+    size_t num_columns; // Number of columns in the header
+} MappedCsv;
+
+/**
+ * Helper function to release a MappedCsv.
+ */
+static void unmap_csv(MappedCsv *csv) {
+    if (csv->names) {
+        for (size_t i = 0; i < csv->num_columns; i++) free(csv->names[i]);
+        free(csv->names);
+        csv->names = NULL;
+    }
+    if (csv->data) {
+        munmap((void *)csv->data, csv->size);
+        csv->data = NULL;
+    }
+}
+
+/**
+ * Helper function to map a CSV file and parse its header, checking that it
+ * has num_columns columns. A num_columns of 0 accepts any number of columns.
+ */
+static int map_csv(const char *filename, size_t num_columns, MappedCsv *csv) {
+    memset(csv, 0, sizeof(*csv));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file '%s'\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Failed to read header from '%s'\n", filename);
+        close(fd);
+        return -1;
+    }
+    csv->size = (size_t)st.st_size;
+
+    void *data = mmap(NULL, csv->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map file '%s'\n", filename);
+        return -1;
+    }
+    madvise(data, csv->size, MADV_SEQUENTIAL);
+    csv->data = data;
+    STATS_ADD(STATS_BYTES_READ, csv->size);
+
+    CsvScanner scanner;
+    if (csv_scanner_init(&scanner, csv->data, csv->data + csv->size) != 0) {
+        unmap_csv(csv);
+        return -1;
+    }
+    size_t field_count = 0;
+    if (num_columns == 0) {
+        // Count the header fields first, then scan it again to store them
+        csv_scanner_next_record(&scanner, NULL, 0, &field_count);
+        csv_scanner_reset(&scanner, csv->data, csv->data + csv->size);
+        num_columns = field_count;
+    }
 
-        // Cleanup fields
-        for (size_t i = 0; i < field_count; i++) free(fields[i]);
+    CsvField *fields = malloc((num_columns ? num_columns : 1) * sizeof(CsvField));
+    csv->names = calloc(num_columns ? num_columns : 1, sizeof(char *));
+    if (!fields || !csv->names) {
+        fprintf(stderr, "Memory allocation failed while reading header\n");
+        free(fields);
+        csv_scanner_free(&scanner);
+        unmap_csv(csv);
+        return -1;
+    }
+    csv_scanner_next_record(&scanner, fields, num_columns, &field_count);
+    csv->body = scanner.position;
+    csv_scanner_free(&scanner);
+    if (field_count != num_columns) {
+        fprintf(stderr, "Header column count (%zu) does not match expected (%zu)\n", field_count, num_columns);
         free(fields);
+        unmap_csv(csv);
+        return -1;
+    }
 
-        current_row++;
+    csv->num_columns = num_columns;
+    for (size_t i = 0; i < num_columns; i++) {
+        csv->names[i] = malloc(fields[i].length + 1);
+        if (!csv->names[i]) {
+            fprintf(stderr, "Memory allocation failed while reading header\n");
+            free(fields);
+            unmap_csv(csv);
+            return -1;
+        }
+        csv_copy_field(&fields[i], csv->names[i]);
     }
 
-    // Optionally, resize the dataframe if estimated rows were inaccurate
-    if (current_row < df->num_rows) {
-        df->num_rows = current_row;
+    free(fields);
+    return 0;
+}
+
+/**
+ * Helper function to free a DataFrame whose read failed. The destroy hook is
+ * skipped, so an arena handed over with arena_allocator(arena, 1) stays with
+ * the caller whenever a read returns NULL, however far the read got.
+ */
+static void discard_frame(DataFrame *df) {
+    if (df) df->allocator.destroy = NULL;
+    destroy_dataframe(df);
+}
+
+/**
+ * Helper function to create a DataFrame with the given schema. A NULL
+ * allocator uses malloc.
+ */
+static DataFrame *create_csv_frame(size_t num_rows, const DataType *types, char *const *names, size_t num_columns,
+                                   const DataFrameAllocator *allocator) {
+    DataFrame *df = create_dataframe_with_allocator(num_rows, num_columns, allocator);
+    if (!df) return NULL;
+
+    for (size_t i = 0; i < num_columns; i++) {
+        if (add_column(df, types[i], i, names[i]) != 0) {
+            fprintf(stderr, "Failed to add column '%s'\n", names[i]);
+            discard_frame(df);
+            return NULL;
+        }
     }
+    return df;
+}
 
-    fclose(fp);
+/**
+ * Helper function to make room for count more rows, at least doubling the
+ * capacity so that appending stays amortized constant time.
+ */
+static int reserve_more_rows(DataFrame *df, size_t count) {
+    if (df->num_rows + count <= df->capacity) return 0;
+    size_t capacity = df->capacity * 2;
+    if (capacity < df->num_rows + count) capacity = df->num_rows + count;
+    return reserve_rows(df, capacity);
+}
+
+/**
+ * Helper function to parse the records in [ptr, end) into a new DataFrame.
+ * The columns are sized from a sample of the input, grown geometrically and
+ * trimmed to the final row count. data is the start of the whole buffer and is
+ * only used to report line numbers. Records must have num_fields fields; with
+ * a projection, column i is loaded from field projection[i] and only the
+ * fields up to the last projected one are located. The DataFrame is served by
+ * allocator, or by malloc when it is NULL.
+ */
+static DataFrame *parse_csv_rows(const char *data, const char *ptr, const char *end,
+                                 const DataType *types, char *const *names, size_t num_columns,
+                                 const size_t *projection, size_t num_fields, const DataFrameAllocator *allocator) {
+    DataFrame *df = create_csv_frame(0, types, names, num_columns, allocator);
+    if (!df) return NULL;
+    if (reserve_rows(df, estimate_rows(ptr, end)) != 0) {
+        discard_frame(df);
+        return NULL;
+    }
+
+    size_t max_fields = num_fields;
+    if (projection) {
+        max_fields = 1;
+        for (size_t i = 0; i < num_columns; i++) {
+            if (projection[i] + 1 > max_fields) max_fields = projection[i] + 1;
+        }
+    }
+    CsvField *fields = malloc(RECORD_WINDOW * max_fields * sizeof(CsvField));
+    if (!fields) {
+        fprintf(stderr, "Memory allocation failed while parsing rows\n");
+        discard_frame(df);
+        return NULL;
+    }
+
+    CsvScanner scanner;
+    if (csv_scanner_init(&scanner, ptr, end) != 0) {
+        free(fields);
+        discard_frame(df);
+        return NULL;
+    }
+
+    // Tokenize a window of records, then convert it
+    size_t field_counts[RECORD_WINDOW];
+    const char *line_starts[RECORD_WINDOW];
+    for (;;) {
+        size_t count = 0;
+        STATS_TIMER_START(tokenize_timer);
+        while (count < RECORD_WINDOW) {
+            line_starts[count] = scanner.position;
+            if (!csv_scanner_next_record(&scanner, fields + count * max_fields, max_fields, &field_counts[count])) break;
+            count++;
+        }
+        STATS_TIMER_STOP(tokenize_timer, STAGE_TOKENIZE);
+        if (count == 0) break;
+
+        if (reserve_more_rows(df, count) != 0) goto fail;
+
+        size_t stored = 0;
+        STATS_TIMER_START(convert_timer);
+        for (size_t i = 0; i < count; i++) {
+            const CsvField *record = fields + i * max_fields;
+
+            // Skip blank lines
+            if (field_counts[i] == 1 && record[0].length == 0 && !record[0].quoted) continue;
+
+            if (field_counts[i] != num_fields) {
+                fprintf(stderr, "Field count (%zu) does not match number of columns (%zu) at line %zu\n",
+                        field_counts[i], num_fields, line_number(data, line_starts[i]));
+                goto fail;
+            }
+
+            df->num_rows++;
+            if (store_csv_record(df, df->num_rows - 1, record, projection) != 0) {
+                fprintf(stderr, "Failed to store the record at line %zu\n", line_number(data, line_starts[i]));
+                goto fail;
+            }
+            stored++;
+        }
+        STATS_TIMER_STOP(convert_timer, STAGE_CONVERT);
+        STATS_ADD(STATS_ROWS_PARSED, stored);
+    }
+
+    // Release the unused tail of the columns
+    shrink_to_fit(df);
+
+    csv_scanner_free(&scanner);
+    free(fields);
     return df;
-}
\ No newline at end of file
+
+fail:
+    csv_scanner_free(&scanner);
+    free(fields);
+    discard_frame(df);
+    return NULL;
+}
+
+/**
+ * Function to read a CSV file through a memory mapping and create a DataFrame.
+ * Row boundaries are found and fields are parsed in a single pass over the
+ * mapped bytes, with no per-line copy and no limit on line length.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @return Pointer to the created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_mmap(const char *filename, DataType *types, size_t num_columns) {
+    if (filename == NULL || types == NULL || num_columns == 0) {
+        fprintf(stderr, "Invalid arguments to read_csv_mmap\n");
+        return NULL;
+    }
+    if (compression_for_file(filename, COMPRESSION_AUTO) != COMPRESSION_NONE) {
+        return read_csv_pipelined(filename, types, num_columns, NULL);
+    }
+
+    MappedCsv csv;
+    if (map_csv(filename, num_columns, &csv) != 0) return NULL;
+
+    DataFrame *df = parse_csv_rows(csv.data, csv.body, csv.data + csv.size, types, csv.names, num_columns,
+                                   NULL, num_columns, NULL);
+
+    unmap_csv(&csv);
+    return df;
+}
+
+static DataFrame *read_csv_stream(const char *filename, const DataType *types, size_t num_columns,
+                                  const DataFrameAllocator *allocator, const ReadAheadOptions *options);
+
+/**
+ * Function to read a CSV file through a memory mapping, loading only the
+ * columns named in the options. The header is matched against the names once;
+ * the fields of other columns are skipped by the tokenizer without being
+ * copied or converted. The DataFrame is served by the allocator in the options.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each loaded column.
+ * @param num_columns The number of loaded columns.
+ * @param options Read options, or NULL to load every column.
+ * @return Pointer to the created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_with_options(const char *filename, DataType *types, size_t num_columns,
+                                 const CsvReadOptions *options) {
+    if (options == NULL) {
+        return read_csv_mmap(filename, types, num_columns);
+    }
+    if (filename == NULL || types == NULL || num_columns == 0) {
+        fprintf(stderr, "Invalid arguments to read_csv_with_options\n");
+        return NULL;
+    }
+    if (compression_for_file(filename, COMPRESSION_AUTO) != COMPRESSION_NONE) {
+        // Compressed input is streamed, and the streaming tokenizer needs every column
+        if (options->columns != NULL) {
+            fprintf(stderr, "Column selection is not supported for compressed file '%s'\n", filename);
+            return NULL;
+        }
+        return read_csv_stream(filename, types, num_columns, options->allocator, &DEFAULT_READAHEAD);
+    }
+
+    MappedCsv csv;
+    if (map_csv(filename, options->columns ? 0 : num_columns, &csv) != 0) return NULL;
+
+    DataFrame *df = NULL;
+    if (options->columns == NULL) {
+        df = parse_csv_rows(csv.data, csv.body, csv.data + csv.size, types, csv.names, num_columns,
+                            NULL, num_columns, options->allocator);
+        unmap_csv(&csv);
+        return df;
+    }
+
+    size_t *projection = malloc(num_columns * sizeof(size_t));
+    char **names = malloc(num_columns * sizeof(char *));
+    if (!projection || !names) {
+        fprintf(stderr, "Memory allocation failed in read_csv_with_options\n");
+        goto cleanup;
+    }
+    for (size_t i = 0; i < num_columns; i++) {
+        size_t field = 0;
+        while (field < csv.num_columns && strcmp(csv.names[field], options->columns[i]) != 0) field++;
+        if (field == csv.num_columns) {
+            fprintf(stderr, "Column '%s' not found in '%s'\n", options->columns[i], filename);
+            goto cleanup;
+        }
+        projection[i] = field;
+        names[i] = csv.names[field];
+    }
+
+    df = parse_csv_rows(csv.data, csv.body, csv.data + csv.size, types, names, num_columns,
+                        projection, csv.num_columns, options->allocator);
+
+cleanup:
+    free(projection);
+    free(names);
+    unmap_csv(&csv);
+    return df;
+}
+
+// Chunks smaller than this are not worth a thread of their own
+#define MIN_PARALLEL_CHUNK_SIZE (64 * 1024)
+
+/**
+ * State shared with one worker of read_csv_parallel.
+ */
+typedef struct {
+    const MappedCsv *csv;   // The mapped input
+    const DataType *types;  // Column types
+    const char *range_start;// Start of the byte range assigned to this chunk
+    const char *range_end;  // Start of the next chunk's byte range
+    size_t quotes;          // Number of quote characters in the range
+    int start_in_quotes;    // Whether range_start lies inside a quoted field
+    int end_in_quotes;      // Whether range_end lies inside a quoted field
+    DataFrame *chunk;       // Rows parsed from this chunk
+    DataFrame *result;      // Stitched result the chunk is copied into
+    size_t row_offset;      // First row of this chunk within the result
+    size_t *byte_offsets;   // Per column, first string byte of this chunk within the result
+    int **code_maps;        // Per column, result code of each of this chunk's categories
+    int status;             // 0 on success, -1 on failure
+} CsvChunk;
+
+/**
+ * Helper function to count quote characters in [ptr, end).
+ */
+static size_t count_quotes(const char *ptr, const char *end) {
+    size_t quotes = 0;
+    while (ptr < end && (ptr = memchr(ptr, '"', (size_t)(end - ptr))) != NULL) {
+        quotes++;
+        ptr++;
+    }
+    return quotes;
+}
+
+/**
+ * Helper function to find the first record boundary at or after ptr, given
+ * whether ptr lies inside a quoted field. Returns end if there is none.
+ */
+static const char *find_record_boundary(const char *ptr, const char *end, int in_quotes) {
+    for (; ptr < end; ptr++) {
+        if (*ptr == '"') {
+            in_quotes = !in_quotes;
+        } else if (*ptr == '\n' && !in_quotes) {
+            return ptr + 1;
+        }
+    }
+    return end;
+}
+
+static void *count_chunk_quotes(void *arg) {
+    CsvChunk *chunk = arg;
+    chunk->quotes = count_quotes(chunk->range_start, chunk->range_end);
+    return NULL;
+}
+
+static void *parse_chunk(void *arg) {
+    CsvChunk *chunk = arg;
+    const char *file_end = chunk->csv->data + chunk->csv->size;
+
+    // A record belongs to the chunk whose byte range contains its first byte
+    const char *start = chunk->range_start == chunk->csv->body
+        ? chunk->range_start
+        : find_record_boundary(chunk->range_start, file_end, chunk->start_in_quotes);
+    const char *end = chunk->range_end == file_end
+        ? file_end
+        : find_record_boundary(chunk->range_end, file_end, chunk->end_in_quotes);
+    if (start > end) start = end;
+
+    chunk->chunk = parse_csv_rows(chunk->csv->data, start, end, chunk->types,
+                                  chunk->csv->names, chunk->csv->num_columns, NULL, chunk->csv->num_columns, NULL);
+    chunk->status = chunk->chunk ? 0 : -1;
+    return NULL;
+}
+
+static void *copy_chunk(void *arg) {
+    CsvChunk *chunk = arg;
+    DataFrame *src = chunk->chunk;
+    DataFrame *dst = chunk->result;
+    size_t rows = src->num_rows;
+
+    for (size_t i = 0; i < dst->num_columns; i++) {
+        Column *from = &src->columns[i];
+        Column *to = &dst->columns[i];
+        switch (to->type) {
+            case DATA_TYPE_INT:
+                memcpy(to->data.int_data + chunk->row_offset, from->data.int_data, rows * sizeof(int));
+                break;
+            case DATA_TYPE_FLOAT:
+                memcpy(to->data.float_data + chunk->row_offset, from->data.float_data, rows * sizeof(float));
+                break;
+            case DATA_TYPE_STRING: {
+                // Append the chunk's string bytes and rebase its offsets
+                const StringData *strings = &from->data.string_data;
+                size_t base = chunk->byte_offsets[i];
+                size_t *offsets = to->data.string_data.offsets + chunk->row_offset;
+                memcpy(to->data.string_data.bytes + base, strings->bytes, strings->size);
+                for (size_t row = 0; row < rows; row++) {
+                    size_t offset = strings->offsets[row];
+                    offsets[row] = offset == STRING_NULL_OFFSET ? offset : offset + base;
+                }
+                break;
+            }
+            case DATA_TYPE_CATEGORICAL: {
+                // Translate the chunk's codes into the merged dictionary
+                const int *map = chunk->code_maps[i];
+                const int *codes = from->data.categorical_data.codes;
+                int *out = to->data.categorical_data.codes + chunk->row_offset;
+                for (size_t row = 0; row < rows; row++) {
+                    out[row] = codes[row] < 0 ? -1 : map[codes[row]];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Helper function to run fn over every chunk, one thread per chunk. The first
+ * chunk runs on the calling thread, as do chunks whose thread fails to start.
+ */
+static int run_chunks(void *(*fn)(void *), CsvChunk *chunks, size_t num_chunks) {
+    pthread_t *threads = malloc(num_chunks * sizeof(pthread_t));
+    if (!threads) {
+        fprintf(stderr, "Memory allocation failed for worker threads\n");
+        return -1;
+    }
+
+    size_t started = 0;
+    for (size_t i = 1; i < num_chunks; i++, started++) {
+        if (pthread_create(&threads[i], NULL, fn, &chunks[i]) != 0) break;
+    }
+    fn(&chunks[0]);
+    for (size_t i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = started + 1; i < num_chunks; i++) {
+        fn(&chunks[i]);
+    }
+
+    free(threads);
+    return 0;
+}
+
+/**
+ * Function to read a CSV file with several threads and create a DataFrame.
+ * The data is cut into byte ranges, each range is resolved to a record boundary
+ * using the quote parity at its start, and each chunk is parsed on its own
+ * thread before the chunks are stitched together in order.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param num_threads The number of threads to use, or 0 for one per online CPU.
+ * @return Pointer to the created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_parallel(const char *filename, DataType *types, size_t num_columns, size_t num_threads) {
+    if (filename == NULL || types == NULL || num_columns == 0) {
+        fprintf(stderr, "Invalid arguments to read_csv_parallel\n");
+        return NULL;
+    }
+    if (compression_for_file(filename, COMPRESSION_AUTO) != COMPRESSION_NONE) {
+        return read_csv_pipelined(filename, types, num_columns, NULL);
+    }
+
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    MappedCsv csv;
+    if (map_csv(filename, num_columns, &csv) != 0) return NULL;
+
+    const char *end = csv.data + csv.size;
+    size_t body_size = (size_t)(end - csv.body);
+    size_t num_chunks = body_size / MIN_PARALLEL_CHUNK_SIZE;
+    if (num_chunks > num_threads) num_chunks = num_threads;
+    if (num_chunks == 0) num_chunks = 1;
+
+    CsvChunk *chunks = calloc(num_chunks, sizeof(CsvChunk));
+    if (!chunks) {
+        fprintf(stderr, "Memory allocation failed in read_csv_parallel\n");
+        unmap_csv(&csv);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < num_chunks; i++) {
+        chunks[i].csv = &csv;
+        chunks[i].types = types;
+        chunks[i].range_start = csv.body + body_size / num_chunks * i;
+        chunks[i].range_end = i + 1 == num_chunks ? end : csv.body + body_size / num_chunks * (i + 1);
+    }
+
+    DataFrame *df = NULL;
+    size_t *byte_offsets = NULL;
+    int **code_maps = NULL;
+
+    // Pass 1: quote parity at every range boundary, timed as tokenizing
+    if (num_chunks > 1) {
+        STATS_TIMER_START(quote_timer);
+        int status = run_chunks(count_chunk_quotes, chunks, num_chunks);
+        STATS_TIMER_STOP(quote_timer, STAGE_TOKENIZE);
+        if (status != 0) goto cleanup;
+        size_t quotes = 0;
+        for (size_t i = 0; i < num_chunks; i++) {
+            chunks[i].start_in_quotes = quotes % 2;
+            quotes += chunks[i].quotes;
+            chunks[i].end_in_quotes = quotes % 2;
+        }
+    }
+
+    // Pass 2: resolve boundaries and parse each chunk into its own columns; the
+    // workers record their own tokenize and convert time and rows parsed
+    if (run_chunks(parse_chunk, chunks, num_chunks) != 0) goto cleanup;
+    size_t total_rows = 0;
+    for (size_t i = 0; i < num_chunks; i++) {
+        if (chunks[i].status != 0) goto cleanup;
+        chunks[i].row_offset = total_rows;
+        total_rows += chunks[i].chunk->num_rows;
+    }
+
+    // Pass 3: stitch the chunks together in order, timed as converting
+    if (num_chunks == 1) {
+        df = chunks[0].chunk;
+        chunks[0].chunk = NULL;
+        goto cleanup;
+    }
+    STATS_TIMER_START(stitch_timer);
+    df = create_csv_frame(total_rows, types, csv.names, num_columns, NULL);
+    if (!df) goto cleanup;
+
+    // Lay out each chunk's string bytes back to back in the result
+    byte_offsets = malloc(num_chunks * num_columns * sizeof(size_t));
+    if (!byte_offsets) {
+        fprintf(stderr, "Memory allocation failed in read_csv_parallel\n");
+        destroy_dataframe(df);
+        df = NULL;
+        goto cleanup;
+    }
+    for (size_t col = 0; col < num_columns; col++) {
+        if (types[col] != DATA_TYPE_STRING) continue;
+        size_t total_bytes = 0;
+        for (size_t i = 0; i < num_chunks; i++) {
+            byte_offsets[i * num_columns + col] = total_bytes;
+            total_bytes += chunks[i].chunk->columns[col].data.string_data.size;
+        }
+        StringData *strings = &df->columns[col].data.string_data;
+        strings->bytes = df->allocator.allocate(df->allocator.context, total_bytes ? total_bytes : 1);
+        if (!strings->bytes) {
+            fprintf(stderr, "Memory allocation failed for column '%s'\n", df->columns[col].name);
+            destroy_dataframe(df);
+            df = NULL;
+            goto cleanup;
+        }
+        strings->size = total_bytes;
+        strings->capacity = total_bytes ? total_bytes : 1;
+    }
+
+    // Merge the chunk dictionaries in file order so codes match a sequential read
+    code_maps = calloc(num_chunks * num_columns, sizeof(int *));
+    if (!code_maps) {
+        fprintf(stderr, "Memory allocation failed in read_csv_parallel\n");
+        destroy_dataframe(df);
+        df = NULL;
+        goto cleanup;
+    }
+    for (size_t col = 0; col < num_columns; col++) {
+        if (types[col] != DATA_TYPE_CATEGORICAL) continue;
+        for (size_t i = 0; i < num_chunks; i++) {
+            const Column *from = &chunks[i].chunk->columns[col];
+            size_t num_categories = from->data.categorical_data.num_categories;
+            int *map = malloc((num_categories ? num_categories : 1) * sizeof(int));
+            code_maps[i * num_columns + col] = map;
+            for (size_t code = 0; map && code < num_categories; code++) {
+                const char *value = category_string(from, (int)code);
+                map[code] = intern_category(&df->columns[col], value, strlen(value));
+                if (map[code] < 0) {
+                    free(map);
+                    map = code_maps[i * num_columns + col] = NULL;
+                }
+            }
+            if (!map) {
+                fprintf(stderr, "Failed to merge categories of column '%s'\n", df->columns[col].name);
+                destroy_dataframe(df);
+                df = NULL;
+                goto cleanup;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_chunks; i++) {
+        chunks[i].result = df;
+        chunks[i].byte_offsets = byte_offsets + i * num_columns;
+        chunks[i].code_maps = code_maps + i * num_columns;
+    }
+    if (run_chunks(copy_chunk, chunks, num_chunks) != 0) {
+        destroy_dataframe(df);
+        df = NULL;
+    }
+    STATS_TIMER_STOP(stitch_timer, STAGE_CONVERT);
+
+cleanup:
+    for (size_t i = 0; i < num_chunks; i++) destroy_dataframe(chunks[i].chunk);
+    if (code_maps) {
+        for (size_t i = 0; i < num_chunks * num_columns; i++) free(code_maps[i]);
+    }
+    free(code_maps);
+    free(byte_offsets);
+    free(chunks);
+    unmap_csv(&csv);
+    return df;
+}
+
+// Initial size of the streaming reader's input buffer
+#define READER_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * State of a streaming CSV reader. The input buffer and the batch DataFrame
+ * are allocated once and reused, so memory use depends on the batch size and
+ * the longest record, not on the size of the file.
+ */
+struct CsvReader {
+    int fd;               // Input file, or -1 when reading through readahead
+    ReadAhead *readahead; // Background reader of the input file, or NULL
+    const char *block;    // Block of readahead being copied into buffer, or NULL
+    size_t block_length;  // Bytes in block
+    size_t block_offset;  // Bytes of block already copied
+    int eof;              // Whether the whole file has been read into buffer
+    char *buffer;         // Input buffer
+    size_t buffer_size;   // Bytes allocated for buffer
+    size_t start;         // First unparsed byte in buffer
+    size_t filled;        // Bytes of input in buffer
+    size_t record;        // Number of records read, for error messages
+    CsvScanner scanner;   // Scanner over buffer[start, filled)
+    CsvField *fields;     // Fields of the current window of records, num_columns per record
+    size_t *field_counts; // Number of fields in each record of the window
+    size_t num_columns;   // Number of columns
+    size_t batch_size;    // Maximum number of rows per batch
+    DataFrame *batch;     // Reused batch DataFrame
+};
+
+/**
+ * Helper function to read up to size bytes of input, from the file or from the
+ * blocks filled by the background reader. Returns 0 at the end of the input.
+ */
+static ssize_t reader_input(CsvReader *reader, char *out, size_t size) {
+    if (reader->readahead == NULL) {
+        ssize_t bytes = read(reader->fd, out, size);
+        if (bytes < 0) {
+            perror("Could not read CSV input");
+        } else {
+            STATS_ADD(STATS_BYTES_READ, bytes);
+        }
+        return bytes;
+    }
+
+    if (reader->block != NULL && reader->block_offset == reader->block_length) {
+        readahead_release(reader->readahead);
+        reader->block = NULL;
+    }
+    if (reader->block == NULL) {
+        int status = readahead_next(reader->readahead, &reader->block, &reader->block_length);
+        if (status <= 0) {
+            reader->block = NULL;
+            return status;
+        }
+        reader->block_offset = 0;
+    }
+    size_t bytes = reader->block_length - reader->block_offset;
+    if (bytes > size) bytes = size;
+    memcpy(out, reader->block + reader->block_offset, bytes);
+    reader->block_offset += bytes;
+    return (ssize_t)bytes;
+}
+
+/**
+ * Helper function to move the unparsed tail of the buffer to its front and read
+ * more input after it, growing the buffer if a single record fills it.
+ */
+static int reader_refill(CsvReader *reader) {
+    size_t pending = reader->filled - reader->start;
+    memmove(reader->buffer, reader->buffer + reader->start, pending);
+    reader->start = 0;
+    reader->filled = pending;
+
+    if (reader->filled == reader->buffer_size) {
+        char *buffer = realloc(reader->buffer, reader->buffer_size * 2);
+        if (!buffer) {
+            fprintf(stderr, "Memory allocation failed for reader buffer\n");
+            return -1;
+        }
+        reader->buffer = buffer;
+        reader->buffer_size *= 2;
+    }
+
+    STATS_TIMER_START(read_timer);
+    while (reader->filled < reader->buffer_size) {
+        ssize_t bytes = reader_input(reader, reader->buffer + reader->filled, reader->buffer_size - reader->filled);
+        if (bytes < 0) {
+            return -1;
+        }
+        if (bytes == 0) {
+            reader->eof = 1;
+            break;
+        }
+        reader->filled += (size_t)bytes;
+    }
+    STATS_TIMER_STOP(read_timer, STAGE_READ);
+
+    csv_scanner_reset(&reader->scanner, reader->buffer, reader->buffer + reader->filled);
+    return 0;
+}
+
+/**
+ * Helper function to tokenize up to max_records complete records into
+ * reader->fields and reader->field_counts. The window ends early at a record
+ * cut off by the end of the buffer; the buffer is only refilled once no
+ * complete record is left in it.
+ *
+ * @return 1 if *count records were read, 0 at the end of the input, -1 on failure.
+ */
+static int reader_next_records(CsvReader *reader, size_t max_records, size_t *count) {
+    size_t num_columns = reader->num_columns;
+    for (;;) {
+        size_t found_records = 0;
+        STATS_TIMER_START(tokenize_timer);
+        while (found_records < max_records) {
+            const char *record_start = reader->scanner.position;
+            int found = csv_scanner_next_record(&reader->scanner, reader->fields + found_records * num_columns,
+                                                num_columns, &reader->field_counts[found_records]);
+
+            // Records cut off by the end of the buffer are read again after a refill
+            if (!found || !(reader->scanner.terminated || reader->eof)) {
+                if (found) csv_scanner_reset(&reader->scanner, record_start, reader->buffer + reader->filled);
+                break;
+            }
+            reader->start = (size_t)(reader->scanner.position - reader->buffer);
+            found_records++;
+        }
+        STATS_TIMER_STOP(tokenize_timer, STAGE_TOKENIZE);
+
+        if (found_records > 0) {
+            reader->record += found_records;
+            *count = found_records;
+            return 1;
+        }
+        if (reader->eof) {
+            return 0;
+        }
+        if (reader_refill(reader) != 0) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * Helper function to open the input of a reader, through a read-ahead ring
+ * when options is not NULL, and read the header into reader->fields.
+ */
+static CsvReader *reader_create(const char *filename, size_t num_columns, const ReadAheadOptions *options) {
+    CsvReader *reader = calloc(1, sizeof(CsvReader));
+    if (!reader) {
+        fprintf(stderr, "Memory allocation failed for CsvReader\n");
+        return NULL;
+    }
+    reader->fd = -1;
+    reader->num_columns = num_columns;
+    reader->buffer_size = READER_BUFFER_SIZE;
+    reader->buffer = malloc(reader->buffer_size);
+    reader->fields = malloc(RECORD_WINDOW * num_columns * sizeof(CsvField));
+    reader->field_counts = malloc(RECORD_WINDOW * sizeof(size_t));
+    if (!reader->buffer || !reader->fields || !reader->field_counts ||
+        csv_scanner_init(&reader->scanner, NULL, NULL) != 0) {
+        fprintf(stderr, "Memory allocation failed for CsvReader\n");
+        free(reader->buffer);
+        free(reader->fields);
+        free(reader->field_counts);
+        free(reader);
+        return NULL;
+    }
+
+    // Compressed files can only be read through the ring, which decompresses them
+    if (!options && compression_for_file(filename, COMPRESSION_AUTO) != COMPRESSION_NONE) {
+        options = &DEFAULT_READAHEAD;
+    }
+    if (options) {
+        reader->readahead = readahead_open(filename, options);
+        if (reader->readahead == NULL) {
+            csv_reader_close(reader);
+            return NULL;
+        }
+    } else {
+        reader->fd = open(filename, O_RDONLY);
+        if (reader->fd < 0) {
+            fprintf(stderr, "Could not open file '%s'\n", filename);
+            csv_reader_close(reader);
+            return NULL;
+        }
+        posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    size_t count = 0;
+    if (reader_refill(reader) != 0 || reader_next_records(reader, 1, &count) != 1) {
+        fprintf(stderr, "Failed to read header from '%s'\n", filename);
+        csv_reader_close(reader);
+        return NULL;
+    }
+    if (reader->field_counts[0] != num_columns) {
+        fprintf(stderr, "Header column count (%zu) does not match expected (%zu)\n", reader->field_counts[0], num_columns);
+        csv_reader_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/**
+ * Helper function to create a DataFrame of num_rows rows named by the header
+ * fields held in reader->fields. A NULL allocator uses malloc.
+ */
+static DataFrame *reader_header_frame(CsvReader *reader, const DataType *types, size_t num_rows,
+                                      const DataFrameAllocator *allocator) {
+    size_t num_columns = reader->num_columns;
+    char **names = calloc(num_columns, sizeof(char *));
+    int failed = names == NULL;
+    for (size_t i = 0; !failed && i < num_columns; i++) {
+        names[i] = malloc(reader->fields[i].length + 1);
+        failed = names[i] == NULL;
+        if (!failed) csv_copy_field(&reader->fields[i], names[i]);
+    }
+    DataFrame *df = failed ? NULL : create_csv_frame(num_rows, types, names, num_columns, allocator);
+    if (names) {
+        for (size_t i = 0; i < num_columns; i++) free(names[i]);
+        free(names);
+    }
+    return df;
+}
+
+/**
+ * Helper function to open a streaming reader, pipelined when options is not NULL.
+ */
+static CsvReader *reader_open(const char *filename, DataType *types, size_t num_columns, size_t batch_size,
+                              const ReadAheadOptions *options) {
+    if (filename == NULL || types == NULL || num_columns == 0 || batch_size == 0) {
+        fprintf(stderr, "Invalid arguments to csv_reader_open\n");
+        return NULL;
+    }
+    CsvReader *reader = reader_create(filename, num_columns, options);
+    if (!reader) return NULL;
+    reader->batch_size = batch_size;
+    reader->batch = reader_header_frame(reader, types, batch_size, NULL);
+    if (!reader->batch) {
+        csv_reader_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/**
+ * Function to open a streaming CSV reader.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param batch_size The maximum number of rows per batch.
+ * @return Pointer to the reader, or NULL on failure.
+ */
+CsvReader *csv_reader_open(const char *filename, DataType *types, size_t num_columns, size_t batch_size) {
+    return reader_open(filename, types, num_columns, batch_size, NULL);
+}
+
+/**
+ * Function to open a streaming CSV reader whose input is read ahead on a
+ * background thread.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param batch_size The maximum number of rows per batch.
+ * @param options Read-ahead tuning, or NULL for the defaults.
+ * @return Pointer to the reader, or NULL on failure.
+ */
+CsvReader *csv_reader_open_pipelined(const char *filename, DataType *types, size_t num_columns, size_t batch_size,
+                                     const ReadAheadOptions *options) {
+    return reader_open(filename, types, num_columns, batch_size, options ? options : &DEFAULT_READAHEAD);
+}
+
+/**
+ * Helper function to read a whole CSV file through a read-ahead ring into a
+ * DataFrame served by allocator, or by malloc when it is NULL.
+ */
+static DataFrame *read_csv_stream(const char *filename, const DataType *types, size_t num_columns,
+                                  const DataFrameAllocator *allocator, const ReadAheadOptions *options) {
+    CsvReader *reader = reader_create(filename, num_columns, options);
+    if (!reader) return NULL;
+    DataFrame *df = reader_header_frame(reader, types, 0, allocator);
+    if (!df || reserve_rows(df, 1024) != 0) {
+        goto fail;
+    }
+
+    for (;;) {
+        size_t count = 0;
+        int status = reader_next_records(reader, RECORD_WINDOW, &count);
+        if (status < 0) goto fail;
+        if (status == 0) break;
+        if (reserve_more_rows(df, count) != 0) goto fail;
+
+        size_t first_record = reader->record - count;
+        size_t stored = 0;
+        STATS_TIMER_START(convert_timer);
+        for (size_t i = 0; i < count; i++) {
+            const CsvField *record = reader->fields + i * num_columns;
+            size_t field_count = reader->field_counts[i];
+
+            // Skip blank lines
+            if (field_count == 1 && record[0].length == 0 && !record[0].quoted) continue;
+
+            if (field_count != num_columns) {
+                fprintf(stderr, "Field count (%zu) does not match number of columns (%zu) at record %zu\n",
+                        field_count, num_columns, first_record + i + 1);
+                goto fail;
+            }
+            df->num_rows++;
+            if (store_csv_record(df, df->num_rows - 1, record, NULL) != 0) {
+                fprintf(stderr, "Failed to store record %zu\n", first_record + i + 1);
+                goto fail;
+            }
+            stored++;
+        }
+        STATS_TIMER_STOP(convert_timer, STAGE_CONVERT);
+        STATS_ADD(STATS_ROWS_PARSED, stored);
+    }
+
+    // Release the unused tail of the columns
+    shrink_to_fit(df);
+    csv_reader_close(reader);
+    return df;
+
+fail:
+    discard_frame(df);
+    csv_reader_close(reader);
+    return NULL;
+}
+
+/**
+ * Function to read a whole CSV file while a background thread reads ahead.
+ * Compressed files are decompressed on that thread.
+ *
+ * @param filename The path to the CSV file.
+ * @param types An array specifying the DataType for each column.
+ * @param num_columns The number of columns.
+ * @param options Read-ahead tuning, or NULL for the defaults.
+ * @return Pointer to the created DataFrame, or NULL on failure.
+ */
+DataFrame *read_csv_pipelined(const char *filename, DataType *types, size_t num_columns, const ReadAheadOptions *options) {
+    if (filename == NULL || types == NULL || num_columns == 0) {
+        fprintf(stderr, "Invalid arguments to read_csv_pipelined\n");
+        return NULL;
+    }
+    return read_csv_stream(filename, types, num_columns, NULL, options ? options : &DEFAULT_READAHEAD);
+}
+
+/**
+ * Function to read the next batch of rows from a streaming CSV reader.
+ *
+ * @param reader The reader.
+ * @param batch Receives the batch, owned by the reader and valid until the next call.
+ * @return 1 if a batch was read, 0 at the end of the input, -1 on failure.
+ */
+int csv_reader_next_batch(CsvReader *reader, DataFrame **batch) {
+    if (reader == NULL || batch == NULL) {
+        fprintf(stderr, "CsvReader or batch is NULL\n");
+        return -1;
+    }
+
+    // Recycle the batch: string bytes are rewritten from the start
+    DataFrame *df = reader->batch;
+    df->num_rows = reader->batch_size;
+    for (size_t i = 0; i < df->num_columns; i++) {
+        if (df->columns[i].type == DATA_TYPE_STRING) {
+            df->columns[i].data.string_data.size = 0;
+        }
+    }
+
+    // Each window holds at most as many records as there are rows left to fill
+    size_t rows = 0;
+    while (rows < reader->batch_size) {
+        size_t window = reader->batch_size - rows;
+        if (window > RECORD_WINDOW) window = RECORD_WINDOW;
+        size_t count = 0;
+        int status = reader_next_records(reader, window, &count);
+        if (status < 0) return -1;
+        if (status == 0) break;
+
+        size_t first_record = reader->record - count;
+        size_t stored = 0;
+        STATS_TIMER_START(convert_timer);
+        for (size_t i = 0; i < count; i++) {
+            const CsvField *record = reader->fields + i * reader->num_columns;
+            size_t field_count = reader->field_counts[i];
+
+            // Skip blank lines
+            if (field_count == 1 && record[0].length == 0 && !record[0].quoted) continue;
+
+            if (field_count != reader->num_columns) {
+                fprintf(stderr, "Field count (%zu) does not match number of columns (%zu) at record %zu\n",
+                        field_count, reader->num_columns, first_record + i + 1);
+                return -1;
+            }
+            if (store_csv_record(df, rows + stored, record, NULL) != 0) {
+                fprintf(stderr, "Failed to store record %zu\n", first_record + i + 1);
+                return -1;
+            }
+            stored++;
+        }
+        STATS_TIMER_STOP(convert_timer, STAGE_CONVERT);
+        STATS_ADD(STATS_ROWS_PARSED, stored);
+        rows += stored;
+    }
+
+    df->num_rows = rows;
+    *batch = df;
+    return rows > 0 ? 1 : 0;
+}
+
+/**
+ * Function to close a streaming CSV reader and free its batch.
+ *
+ * @param reader The reader.
+ */
+void csv_reader_close(CsvReader *reader) {
+    if (reader == NULL) return;
+    if (reader->fd >= 0) close(reader->fd);
+    readahead_close(reader->readahead);
+    csv_scanner_free(&reader->scanner);
+    destroy_dataframe(reader->batch);
+    free(reader->fields);
+    free(reader->field_counts);
+    free(reader->buffer);
+    free(reader);
+}
+
+// Identifies files written by save_binary
+static const char binary_magic[8] = {'D', 'F', 'B', 'I', 'N', 'A', 'R', 'Y'};
+
+// Layout version of binary files
+#define BINARY_VERSION 1
+
+// Written in native byte order, reads back differently on a machine of the other endianness
+#define BINARY_BYTE_ORDER 0x01020304u
+
+// Alignment of every column block in a binary file
+#define BINARY_ALIGNMENT 64
+
+// Maximum number of blocks per column: codes, dictionary offsets and dictionary bytes
+#define BINARY_MAX_BLOCKS 3
+
+// Rows of an encoded INT column decoded at a time while saving
+#define DECODE_BLOCK_ROWS 1024
+
+/**
+ * Header at the start of a binary file, followed by one BinaryColumn per column.
+ */
+typedef struct {
+    char magic[8];        // binary_magic
+    uint32_t byte_order;  // BINARY_BYTE_ORDER
+    uint32_t version;     // BINARY_VERSION
+    uint32_t offset_size; // sizeof(size_t) of the writer, the width of string offsets
+    uint32_t reserved;
+    uint64_t num_rows;
+    uint64_t num_columns;
+} BinaryHeader;
+
+/**
+ * Describes where the blocks of one column live in a binary file. INT and
+ * FLOAT columns have one block of values, STRING columns a block of offsets
+ * and a block of bytes, and CATEGORICAL columns a block of codes followed by
+ * the dictionary's offsets and bytes.
+ */
+typedef struct {
+    char name[MAX_COLUMN_NAME_LENGTH];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offsets[BINARY_MAX_BLOCKS]; // File offset of each block, a multiple of BINARY_ALIGNMENT
+    uint64_t lengths[BINARY_MAX_BLOCKS]; // Length of each block in bytes
+} BinaryColumn;
+
+/**
+ * Helper function to list the blocks of a column. Returns the number of blocks.
+ */
+static size_t binary_blocks(const Column *column, size_t num_rows, const void **data, uint64_t *lengths) {
+    switch (column->type) {
+        case DATA_TYPE_INT:
+            // Encoded columns are decoded while writing and stored plain
+            data[0] = column->encoding == INT_ENCODING_PLAIN ? column->data.int_data : NULL;
+            lengths[0] = num_rows * sizeof(int);
+            return 1;
+        case DATA_TYPE_FLOAT:
+            data[0] = column->data.float_data;
+            lengths[0] = num_rows * sizeof(float);
+            return 1;
+        case DATA_TYPE_STRING:
+            data[0] = column->data.string_data.offsets;
+            lengths[0] = num_rows * sizeof(size_t);
+            data[1] = column->data.string_data.bytes;
+            lengths[1] = column->data.string_data.size;
+            return 2;
+        case DATA_TYPE_CATEGORICAL: {
+            const CategoricalData *categorical = &column->data.categorical_data;
+            data[0] = categorical->codes;
+            lengths[0] = num_rows * sizeof(int);
+            data[1] = categorical->dictionary.offsets;
+            lengths[1] = categorical->num_categories * sizeof(size_t);
+            data[2] = categorical->dictionary.bytes;
+            lengths[2] = categorical->dictionary.size;
+            return 3;
+        }
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Helper function to write a large block straight to the file, bypassing the buffer.
+ */
+static void writer_write_direct(CsvWriter *writer, const void *data, size_t length) {
+    writer_flush(writer);
+    const char *ptr = data;
+    while (!writer->failed && length > 0) {
+        ssize_t bytes = write(writer->fd, ptr, length);
+        if (bytes < 0) {
+            perror("Could not write binary output");
+            writer->failed = 1;
+            break;
+        }
+        ptr += bytes;
+        length -= (size_t)bytes;
+        STATS_ADD(STATS_BYTES_WRITTEN, bytes);
+    }
+}
+
+/**
+ * Function to save the dataframe in the binary columnar format.
+ *
+ * @param df Pointer to the DataFrame.
+ * @param filename The name of the binary file.
+ * @return 0 on success, -1 on failure.
+ */
+int save_binary(const DataFrame *df, const char *filename) {
+    if (df == NULL || filename == NULL) {
+        fprintf(stderr, "DataFrame or filename is NULL\n");
+        return -1;
+    }
+
+    BinaryColumn *descriptors = calloc(df->num_columns ? df->num_columns : 1, sizeof(BinaryColumn));
+    if (!descriptors) {
+        fprintf(stderr, "Memory allocation failed for binary column table\n");
+        return -1;
+    }
+
+    // Lay out the blocks one after the other, each starting on an aligned offset
+    uint64_t position = sizeof(BinaryHeader) + df->num_columns * sizeof(BinaryColumn);
+    for (size_t i = 0; i < df->num_columns; i++) {
+        const Column *column = &df->columns[i];
+        const void *data[BINARY_MAX_BLOCKS];
+        BinaryColumn *descriptor = &descriptors[i];
+        size_t num_blocks = binary_blocks(column, df->num_rows, data, descriptor->lengths);
+        if (num_blocks == 0) {
+            fprintf(stderr, "Unsupported DataType %d in column '%s'\n", column->type, column->name);
+            free(descriptors);
+            return -1;
+        }
+        memcpy(descriptor->name, column->name, MAX_COLUMN_NAME_LENGTH);
+        descriptor->type = (uint32_t)column->type;
+        for (size_t block = 0; block < num_blocks; block++) {
+            position = (position + BINARY_ALIGNMENT - 1) & ~(uint64_t)(BINARY_ALIGNMENT - 1);
+            descriptor->offsets[block] = position;
+            position += descriptor->lengths[block];
+        }
+    }
+
+    CsvWriter writer = {.fd = -1};
+    writer.buffer = malloc(WRITER_BUFFER_SIZE);
+    if (!writer.buffer) {
+        fprintf(stderr, "Memory allocation failed for binary writer\n");
+        free(descriptors);
+        return -1;
+    }
+    writer.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer.fd < 0) {
+        perror("Could not open file");
+        free(writer.buffer);
+        free(descriptors);
+        return -1;
+    }
+
+    BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binary_magic, sizeof(header.magic));
+    header.byte_order = BINARY_BYTE_ORDER;
+    header.version = BINARY_VERSION;
+    header.offset_size = sizeof(size_t);
+    header.num_rows = df->num_rows;
+    header.num_columns = df->num_columns;
+    writer_append(&writer, (const char *)&header, sizeof(header));
+    writer_append(&writer, (const char *)descriptors, df->num_columns * sizeof(BinaryColumn));
+
+    static const char padding[BINARY_ALIGNMENT];
+    uint64_t written = sizeof(BinaryHeader) + df->num_columns * sizeof(BinaryColumn);
+    for (size_t i = 0; i < df->num_columns && !writer.failed; i++) {
+        const void *data[BINARY_MAX_BLOCKS];
+        uint64_t lengths[BINARY_MAX_BLOCKS] = {0};
+        size_t num_blocks = binary_blocks(&df->columns[i], df->num_rows, data, lengths);
+        for (size_t block = 0; block < num_blocks; block++) {
+            writer_append(&writer, padding, descriptors[i].offsets[block] - written);
+            if (data[block] == NULL) {
+                int values[DECODE_BLOCK_ROWS];
+                for (size_t row = 0; row < df->num_rows; row += DECODE_BLOCK_ROWS) {
+                    size_t n = df->num_rows - row < DECODE_BLOCK_ROWS ? df->num_rows - row : DECODE_BLOCK_ROWS;
+                    decode_ints(&df->columns[i].data.encoded_ints, row, n, values);
+                    writer_append(&writer, (const char *)values, n * sizeof(int));
+                }
+            } else if (lengths[block] >= WRITER_BUFFER_SIZE) {
+                writer_write_direct(&writer, data[block], lengths[block]);
+            } else {
+                writer_append(&writer, data[block], lengths[block]);
+            }
+            written = descriptors[i].offsets[block] + lengths[block];
+        }
+    }
+
+    writer_flush(&writer);
+    int status = writer.failed ? -1 : 0;
+    if (close(writer.fd) != 0) {
+        perror("Could not close file");
+        status = -1;
+    }
+    free(writer.buffer);
+    free(descriptors);
+    return status;
+}
+
+/**
+ * Helper function to check a column descriptor against the file size and the
+ * row count. Only the layout is checked, row contents are trusted.
+ */
+static int validate_binary_column(const BinaryColumn *descriptor, const char *data, size_t size, uint64_t num_rows) {
+    if (memchr(descriptor->name, '\0', MAX_COLUMN_NAME_LENGTH) == NULL) {
+        return -1;
+    }
+    for (size_t block = 0; block < BINARY_MAX_BLOCKS; block++) {
+        uint64_t offset = descriptor->offsets[block];
+        if (offset % BINARY_ALIGNMENT != 0 || offset > size || descriptor->lengths[block] > size - offset) {
+            return -1;
+        }
+    }
+
+    const uint64_t *lengths = descriptor->lengths;
+    switch (descriptor->type) {
+        case DATA_TYPE_INT:
+            return lengths[0] == num_rows * sizeof(int) ? 0 : -1;
+        case DATA_TYPE_FLOAT:
+            return lengths[0] == num_rows * sizeof(float) ? 0 : -1;
+        case DATA_TYPE_STRING: {
+            if (lengths[0] != num_rows * sizeof(size_t)) return -1;
+            // Every string must end inside the block
+            if (lengths[1] != 0 && data[descriptor->offsets[1] + lengths[1] - 1] != '\0') return -1;
+            // and every row must start inside it, or be NULL
+            const size_t *offsets = (const size_t *)(data + descriptor->offsets[0]);
+            for (uint64_t row = 0; row < num_rows; row++) {
+                if (offsets[row] >= lengths[1] && offsets[row] != STRING_NULL_OFFSET) return -1;
+            }
+            return 0;
+        }
+        case DATA_TYPE_CATEGORICAL: {
+            if (lengths[0] != num_rows * sizeof(int) || lengths[1] % sizeof(size_t) != 0) return -1;
+            size_t num_categories = lengths[1] / sizeof(size_t);
+            if (num_categories > INT_MAX) return -1;
+            // Every code must name a category, or be -1 for NULL
+            const int *codes = (const int *)(data + descriptor->offsets[0]);
+            for (uint64_t row = 0; row < num_rows; row++) {
+                if (codes[row] < -1 || codes[row] >= (int)num_categories) return -1;
+            }
+            if (num_categories == 0) return 0;
+            if (lengths[2] == 0 || data[descriptor->offsets[2] + lengths[2] - 1] != '\0') return -1;
+            // The dictionary is hashed on load, so its offsets must be well formed
+            const size_t *offsets = (const size_t *)(data + descriptor->offsets[1]);
+            for (size_t code = 0; code < num_categories; code++) {
+                if (offsets[code] >= lengths[2] || (code > 0 && offsets[code] <= offsets[code - 1])) return -1;
+            }
+            return 0;
+        }
+        default:
+            return -1;
+    }
+}
+
+/**
+ * Function to load a dataframe saved by save_binary. The file is mapped into
+ * memory and the columns point straight at it.
+ *
+ * @param filename The path to the binary file.
+ * @return DataFrame* The loaded DataFrame, or NULL on failure.
+ */
+DataFrame *load_binary(const char *filename) {
+    if (filename == NULL) {
+        fprintf(stderr, "Filename is NULL\n");
+        return NULL;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file '%s'\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BinaryHeader)) {
+        fprintf(stderr, "File '%s' is too short for a binary header\n", filename);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STATS_ADD(STATS_BYTES_READ, size);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Could not map file '%s'\n", filename);
+        return NULL;
+    }
+    const char *data = mapping;
+
+    const BinaryHeader *header = mapping;
+    if (memcmp(header->magic, binary_magic, sizeof(header->magic)) != 0 || header->byte_order != BINARY_BYTE_ORDER ||
+        header->version != BINARY_VERSION || header->offset_size != sizeof(size_t)) {
+        fprintf(stderr, "File '%s' is not a binary dataframe written on this platform\n", filename);
+        munmap(mapping, size);
+        return NULL;
+    }
+    if (header->num_columns > (size - sizeof(BinaryHeader)) / sizeof(BinaryColumn) ||
+        (header->num_columns > 0 && header->num_rows > size)) {
+        fprintf(stderr, "Binary file '%s' is truncated\n", filename);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    size_t num_rows = (size_t)header->num_rows;
+    size_t num_columns = (size_t)header->num_columns;
+    DataFrame *df = create_dataframe(num_rows, num_columns);
+    if (!df) {
+        munmap(mapping, size);
+        return NULL;
+    }
+    // From here on destroy_dataframe releases the mapping
+    df->mapping = mapping;
+    df->mapping_size = size;
+
+    const BinaryColumn *descriptors = (const BinaryColumn *)(data + sizeof(BinaryHeader));
+    for (size_t i = 0; i < num_columns; i++) {
+        const BinaryColumn *descriptor = &descriptors[i];
+        if (validate_binary_column(descriptor, data, size, header->num_rows) != 0) {
+            fprintf(stderr, "Column %zu of binary file '%s' is corrupt\n", i, filename);
+            destroy_dataframe(df);
+            return NULL;
+        }
+
+        const void *blocks[BINARY_MAX_BLOCKS];
+        for (size_t block = 0; block < BINARY_MAX_BLOCKS; block++) {
+            blocks[block] = descriptor->lengths[block] ? data + descriptor->offsets[block] : NULL;
+        }
+
+        ColumnData column;
+        memset(&column, 0, sizeof(column));
+        switch (descriptor->type) {
+            case DATA_TYPE_INT:
+                column.int_data = (int *)blocks[0];
+                break;
+            case DATA_TYPE_FLOAT:
+                column.float_data = (float *)blocks[0];
+                break;
+            case DATA_TYPE_STRING:
+                column.string_data.offsets = (size_t *)blocks[0];
+                column.string_data.bytes = (char *)blocks[1];
+                column.string_data.size = descriptor->lengths[1];
+                break;
+            case DATA_TYPE_CATEGORICAL:
+                column.categorical_data.codes = (int *)blocks[0];
+                column.categorical_data.dictionary.offsets = (size_t *)blocks[1];
+                column.categorical_data.dictionary.bytes = (char *)blocks[2];
+                column.categorical_data.dictionary.size = descriptor->lengths[2];
+                column.categorical_data.num_categories = descriptor->lengths[1] / sizeof(size_t);
+                break;
+        }
+        if (attach_column(df, (DataType)descriptor->type, i, descriptor->name, &column) != 0) {
+            destroy_dataframe(df);
+            return NULL;
+        }
+    }
+    return df;
+}
@@ -0,0 +1,163 @@
+#include "dfstats.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Counters owned by one thread, linked into the registry while it runs
+typedef struct ThreadStats {
+    DataFrameStats stats;
+    struct ThreadStats *prev;
+    struct ThreadStats *next;
+} ThreadStats;
+
+static const char *counter_names[STATS_NUM_COUNTERS] = {
+    "bytes_read", "bytes_written", "rows_parsed", "rows_written", "allocations"
+};
+
+static const char *stage_names[STATS_NUM_STAGES] = {
+    "read", "tokenize", "convert", "format", "write"
+};
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadStats *registry = NULL; // Counters of running threads
+static DataFrameStats retired;       // Totals of threads that have exited
+static pthread_key_t thread_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static __thread ThreadStats *local_stats = NULL;
+
+// Only the owning thread writes a slot, so a relaxed load and store suffice
+static inline void bump(uint64_t *slot, uint64_t amount) {
+    __atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+static void add_stats(DataFrameStats *total, DataFrameStats *stats) {
+    for (size_t i = 0; i < STATS_NUM_COUNTERS; i++) {
+        total->counters[i] += __atomic_load_n(&stats->counters[i], __ATOMIC_RELAXED);
+    }
+    for (size_t i = 0; i < STATS_NUM_STAGES; i++) {
+        total->stage_ns[i] += __atomic_load_n(&stats->stage_ns[i], __ATOMIC_RELAXED);
+        total->stage_calls[i] += __atomic_load_n(&stats->stage_calls[i], __ATOMIC_RELAXED);
+    }
+}
+
+// Folds the counters of an exiting thread into the retired totals
+static void retire_thread(void *arg) {
+    ThreadStats *thread = arg;
+    pthread_mutex_lock(&registry_lock);
+    add_stats(&retired, &thread->stats);
+    if (thread->prev) thread->prev->next = thread->next;
+    else registry = thread->next;
+    if (thread->next) thread->next->prev = thread->prev;
+    pthread_mutex_unlock(&registry_lock);
+    free(thread);
+}
+
+static void create_key(void) {
+    pthread_key_create(&thread_key, retire_thread);
+}
+
+// Returns the calling thread's counters, registering them on first use
+static ThreadStats *thread_stats(void) {
+    if (local_stats != NULL) {
+        return local_stats;
+    }
+    pthread_once(&key_once, create_key);
+    ThreadStats *thread = calloc(1, sizeof(ThreadStats));
+    if (thread == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&registry_lock);
+    thread->next = registry;
+    if (registry) registry->prev = thread;
+    registry = thread;
+    pthread_mutex_unlock(&registry_lock);
+    pthread_setspecific(thread_key, thread);
+    local_stats = thread;
+    return thread;
+}
+
+// Function to add to a counter of the calling thread
+void stats_add(StatsCounter counter, uint64_t amount) {
+    ThreadStats *thread = thread_stats();
+    if (thread != NULL && (unsigned)counter < STATS_NUM_COUNTERS) {
+        bump(&thread->stats.counters[counter], amount);
+    }
+}
+
+// Function to add a timed interval to a stage of the calling thread
+void stats_record(StatsStage stage, uint64_t ns) {
+    ThreadStats *thread = thread_stats();
+    if (thread != NULL && (unsigned)stage < STATS_NUM_STAGES) {
+        bump(&thread->stats.stage_ns[stage], ns);
+        bump(&thread->stats.stage_calls[stage], 1);
+    }
+}
+
+// Function to read the monotonic clock in nanoseconds
+uint64_t stats_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Function to report whether instrumentation was compiled in
+int stats_enabled(void) {
+#ifdef DF_ENABLE_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Function to add up the counters of every thread
+void stats_snapshot(DataFrameStats *stats) {
+    pthread_mutex_lock(&registry_lock);
+    *stats = retired;
+    for (ThreadStats *thread = registry; thread != NULL; thread = thread->next) {
+        add_stats(stats, &thread->stats);
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+// Function to clear the counters of every thread
+void stats_reset(void) {
+    pthread_mutex_lock(&registry_lock);
+    memset(&retired, 0, sizeof(retired));
+    for (ThreadStats *thread = registry; thread != NULL; thread = thread->next) {
+        uint64_t *slots = (uint64_t *)&thread->stats;
+        for (size_t i = 0; i < sizeof(DataFrameStats) / sizeof(uint64_t); i++) {
+            __atomic_store_n(&slots[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+// Function to name a counter
+const char *stats_counter_name(StatsCounter counter) {
+    return (unsigned)counter < STATS_NUM_COUNTERS ? counter_names[counter] : "unknown";
+}
+
+// Function to name a stage
+const char *stats_stage_name(StatsStage stage) {
+    return (unsigned)stage < STATS_NUM_STAGES ? stage_names[stage] : "unknown";
+}
+
+// Function to write a snapshot as JSON
+int stats_dump(const DataFrameStats *stats, FILE *out) {
+    if (stats == NULL || out == NULL) {
+        fprintf(stderr, "Stats or stream is NULL\n");
+        return -1;
+    }
+    fprintf(out, "{\"enabled\":%s,\"counters\":{", stats_enabled() ? "true" : "false");
+    for (size_t i = 0; i < STATS_NUM_COUNTERS; i++) {
+        fprintf(out, "%s\"%s\":%llu", i ? "," : "", counter_names[i], (unsigned long long)stats->counters[i]);
+    }
+    fprintf(out, "},\"stages\":{");
+    for (size_t i = 0; i < STATS_NUM_STAGES; i++) {
+        fprintf(out, "%s\"%s\":{\"ns\":%llu,\"calls\":%llu}", i ? "," : "", stage_names[i],
+                (unsigned long long)stats->stage_ns[i], (unsigned long long)stats->stage_calls[i]);
+    }
+    fprintf(out, "}}\n");
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,264 @@
+#include "encoding.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+// Properties of an array gathered in one pass, used to size every encoding
+typedef struct {
+    int min;
+    int max;
+    size_t num_runs;
+    int64_t min_delta; // Smallest difference between rows of the same DELTA block
+    int64_t max_delta; // Largest difference between rows of the same DELTA block
+} IntProfile;
+
+static void profile_ints(const int *values, size_t count, IntProfile *profile) {
+    profile->min = INT_MAX;
+    profile->max = INT_MIN;
+    profile->num_runs = 0;
+    profile->min_delta = INT64_MAX;
+    profile->max_delta = INT64_MIN;
+    for (size_t i = 0; i < count; i++) {
+        int value = values[i];
+        if (value < profile->min) profile->min = value;
+        if (value > profile->max) profile->max = value;
+        profile->num_runs += i == 0 || value != values[i - 1];
+        if (i % DELTA_BLOCK_ROWS != 0) {
+            int64_t delta = (int64_t)value - values[i - 1];
+            if (delta < profile->min_delta) profile->min_delta = delta;
+            if (delta > profile->max_delta) profile->max_delta = delta;
+        }
+    }
+    if (profile->min_delta > profile->max_delta) {
+        // No row follows another within a block
+        profile->min_delta = profile->max_delta = 0;
+    }
+}
+
+// Bits needed to hold every value in [0, range]
+static unsigned bits_for(uint64_t range) {
+    return range ? 64u - (unsigned)__builtin_clzll(range) : 0u;
+}
+
+static size_t packed_words(size_t count, unsigned width) {
+    size_t words = (count * width + 63) / 64;
+    return words ? words : 1;
+}
+
+static inline void pack_value(uint64_t *packed, unsigned width, size_t i, uint64_t value) {
+    size_t bit = i * width;
+    unsigned shift = (unsigned)(bit % 64);
+    packed[bit / 64] |= value << shift;
+    if (shift + width > 64) {
+        packed[bit / 64 + 1] |= value >> (64 - shift);
+    }
+}
+
+static inline uint64_t unpack_value(const uint64_t *packed, unsigned width, size_t i) {
+    if (width == 0) {
+        return 0;
+    }
+    size_t bit = i * width;
+    unsigned shift = (unsigned)(bit % 64);
+    uint64_t value = packed[bit / 64] >> shift;
+    if (shift + width > 64) {
+        value |= packed[bit / 64 + 1] << (64 - shift);
+    }
+    return width == 64 ? value : value & ((UINT64_C(1) << width) - 1);
+}
+
+// Picks the smallest encoding for a profile, preferring FOR on ties for its O(1) row access
+static IntEncoding smallest_encoding(const IntProfile *profile, size_t count) {
+    unsigned for_width = bits_for((uint64_t)((int64_t)profile->max - profile->min));
+    unsigned delta_width = bits_for((uint64_t)(profile->max_delta - profile->min_delta));
+    size_t num_blocks = (count + DELTA_BLOCK_ROWS - 1) / DELTA_BLOCK_ROWS;
+    size_t rle = profile->num_runs * (sizeof(int) + sizeof(size_t));
+    size_t frame = packed_words(count, for_width) * sizeof(uint64_t);
+    size_t delta = packed_words(count, delta_width) * sizeof(uint64_t) + num_blocks * sizeof(int);
+
+    IntEncoding best = INT_ENCODING_FOR;
+    size_t best_size = frame;
+    if (delta < best_size) {
+        best = INT_ENCODING_DELTA;
+        best_size = delta;
+    }
+    if (rle < best_size) {
+        best = INT_ENCODING_RLE;
+    }
+    return best;
+}
+
+// Function to compress an array of ints
+int encode_ints(const int *values, size_t count, IntEncoding encoding, const DataFrameAllocator *allocator,
+                EncodedInts *encoded) {
+    if ((values == NULL && count > 0) || allocator == NULL || encoded == NULL) {
+        fprintf(stderr, "Values, allocator or output is NULL\n");
+        return -1;
+    }
+    if (encoding <= INT_ENCODING_PLAIN || encoding > INT_ENCODING_AUTO) {
+        fprintf(stderr, "Unsupported encoding %d\n", encoding);
+        return -1;
+    }
+
+    IntProfile profile;
+    profile_ints(values, count, &profile);
+    if (encoding == INT_ENCODING_AUTO) {
+        encoding = smallest_encoding(&profile, count);
+    }
+
+    memset(encoded, 0, sizeof(EncodedInts));
+    encoded->encoding = encoding;
+    encoded->num_values = count;
+    encoded->min = profile.min;
+    encoded->max = profile.max;
+
+    void *context = allocator->context;
+    switch (encoding) {
+        case INT_ENCODING_RLE: {
+            size_t runs = profile.num_runs ? profile.num_runs : 1;
+            encoded->run_values = allocator->allocate(context, runs * sizeof(int));
+            encoded->run_ends = allocator->allocate(context, runs * sizeof(size_t));
+            if (encoded->run_values == NULL || encoded->run_ends == NULL) break;
+            size_t run = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (i > 0 && values[i] != values[i - 1]) run++;
+                encoded->run_values[run] = values[i];
+                encoded->run_ends[run] = i + 1;
+            }
+            encoded->num_runs = profile.num_runs;
+            return 0;
+        }
+        case INT_ENCODING_FOR: {
+            encoded->reference = profile.min;
+            encoded->bit_width = bits_for((uint64_t)((int64_t)profile.max - profile.min));
+            size_t words = packed_words(count, encoded->bit_width);
+            encoded->packed = allocator->allocate(context, words * sizeof(uint64_t));
+            if (encoded->packed == NULL) break;
+            memset(encoded->packed, 0, words * sizeof(uint64_t));
+            for (size_t i = 0; i < count; i++) {
+                pack_value(encoded->packed, encoded->bit_width, i, (uint64_t)((int64_t)values[i] - profile.min));
+            }
+            return 0;
+        }
+        default: {
+            encoded->reference = profile.min_delta;
+            encoded->bit_width = bits_for((uint64_t)(profile.max_delta - profile.min_delta));
+            size_t words = packed_words(count, encoded->bit_width);
+            size_t num_blocks = (count + DELTA_BLOCK_ROWS - 1) / DELTA_BLOCK_ROWS;
+            encoded->packed = allocator->allocate(context, words * sizeof(uint64_t));
+            encoded->anchors = allocator->allocate(context, (num_blocks ? num_blocks : 1) * sizeof(int));
+            if (encoded->packed == NULL || encoded->anchors == NULL) break;
+            memset(encoded->packed, 0, words * sizeof(uint64_t));
+            for (size_t i = 0; i < count; i++) {
+                if (i % DELTA_BLOCK_ROWS == 0) {
+                    encoded->anchors[i / DELTA_BLOCK_ROWS] = values[i];
+                } else {
+                    int64_t delta = (int64_t)values[i] - values[i - 1];
+                    pack_value(encoded->packed, encoded->bit_width, i, (uint64_t)(delta - profile.min_delta));
+                }
+            }
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "Memory allocation failed for %s encoding of %zu values\n", int_encoding_name(encoding), count);
+    free_encoded_ints(encoded, allocator);
+    return -1;
+}
+
+// Function to find the RLE run holding a row
+size_t encoded_run_at(const EncodedInts *encoded, size_t row) {
+    size_t low = 0, high = encoded->num_runs;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (encoded->run_ends[mid] <= row) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Function to decode a range of rows
+void decode_ints(const EncodedInts *encoded, size_t start, size_t count, int *out) {
+    size_t end = start + count;
+    switch (encoded->encoding) {
+        case INT_ENCODING_RLE: {
+            size_t row = start;
+            for (size_t run = encoded_run_at(encoded, start); row < end; run++) {
+                size_t run_end = encoded->run_ends[run] < end ? encoded->run_ends[run] : end;
+                int value = encoded->run_values[run];
+                for (; row < run_end; row++) out[row - start] = value;
+            }
+            break;
+        }
+        case INT_ENCODING_FOR:
+            for (size_t row = start; row < end; row++) {
+                out[row - start] = (int)(encoded->reference + (int64_t)unpack_value(encoded->packed, encoded->bit_width, row));
+            }
+            break;
+        default: {
+            // Walk from the anchor of the block holding start
+            int64_t value = 0;
+            for (size_t row = start - start % DELTA_BLOCK_ROWS; row < end; row++) {
+                if (row % DELTA_BLOCK_ROWS == 0) {
+                    value = encoded->anchors[row / DELTA_BLOCK_ROWS];
+                } else {
+                    value += encoded->reference + (int64_t)unpack_value(encoded->packed, encoded->bit_width, row);
+                }
+                if (row >= start) out[row - start] = (int)value;
+            }
+            break;
+        }
+    }
+}
+
+// Function to decode one row
+int encoded_int_at(const EncodedInts *encoded, size_t row) {
+    switch (encoded->encoding) {
+        case INT_ENCODING_RLE:
+            return encoded->run_values[encoded_run_at(encoded, row)];
+        case INT_ENCODING_FOR:
+            return (int)(encoded->reference + (int64_t)unpack_value(encoded->packed, encoded->bit_width, row));
+        default: {
+            int value;
+            decode_ints(encoded, row, 1, &value);
+            return value;
+        }
+    }
+}
+
+// Function to measure the encoded buffers
+size_t encoded_ints_size(const EncodedInts *encoded) {
+    switch (encoded->encoding) {
+        case INT_ENCODING_RLE:
+            return encoded->num_runs * (sizeof(int) + sizeof(size_t));
+        case INT_ENCODING_FOR:
+            return packed_words(encoded->num_values, encoded->bit_width) * sizeof(uint64_t);
+        default:
+            return packed_words(encoded->num_values, encoded->bit_width) * sizeof(uint64_t) +
+                   (encoded->num_values + DELTA_BLOCK_ROWS - 1) / DELTA_BLOCK_ROWS * sizeof(int);
+    }
+}
+
+// Function to release the encoded buffers
+void free_encoded_ints(EncodedInts *encoded, const DataFrameAllocator *allocator) {
+    allocator->release(allocator->context, encoded->run_values);
+    allocator->release(allocator->context, encoded->run_ends);
+    allocator->release(allocator->context, encoded->packed);
+    allocator->release(allocator->context, encoded->anchors);
+    memset(encoded, 0, sizeof(EncodedInts));
+}
+
+// Function to name an encoding
+const char *int_encoding_name(IntEncoding encoding) {
+    switch (encoding) {
+        case INT_ENCODING_PLAIN: return "plain";
+        case INT_ENCODING_RLE: return "rle";
+        case INT_ENCODING_FOR: return "for";
+        case INT_ENCODING_DELTA: return "delta";
+        case INT_ENCODING_AUTO: return "auto";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,414 @@
+#include "filter.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_X86 1
+#endif
+
+// Rows per mask word
+#define WORD_BITS 64
+
+// Rows of an encoded column decoded at a time, a multiple of WORD_BITS
+#define DECODE_BLOCK_ROWS 1024
+
+// Kernels comparing up to WORD_BITS values against a constant, returning one bit per value
+typedef struct {
+    const char *name;
+    uint64_t (*compare_ints)(const int *data, size_t n, int value, CompareOp op);
+    uint64_t (*compare_floats)(const float *data, size_t n, float value, CompareOp op);
+} FilterKernels;
+
+// Sets bit i of bits to the result of test for each of the n values, without branches
+#define COMPARE_LOOP(test)                                  \
+    for (size_t i = 0; i < n; i++) {                        \
+        bits |= (uint64_t)(data[i] test value) << i;        \
+    }
+
+static uint64_t compare_ints_scalar(const int *data, size_t n, int value, CompareOp op) {
+    uint64_t bits = 0;
+    switch (op) {
+        case COMPARE_EQ: COMPARE_LOOP(==); break;
+        case COMPARE_NE: COMPARE_LOOP(!=); break;
+        case COMPARE_LT: COMPARE_LOOP(<); break;
+        case COMPARE_LE: COMPARE_LOOP(<=); break;
+        case COMPARE_GT: COMPARE_LOOP(>); break;
+        case COMPARE_GE: COMPARE_LOOP(>=); break;
+    }
+    return bits;
+}
+
+static uint64_t compare_floats_scalar(const float *data, size_t n, float value, CompareOp op) {
+    uint64_t bits = 0;
+    switch (op) {
+        case COMPARE_EQ: COMPARE_LOOP(==); break;
+        case COMPARE_NE: COMPARE_LOOP(!=); break;
+        case COMPARE_LT: COMPARE_LOOP(<); break;
+        case COMPARE_LE: COMPARE_LOOP(<=); break;
+        case COMPARE_GT: COMPARE_LOOP(>); break;
+        case COMPARE_GE: COMPARE_LOOP(>=); break;
+    }
+    return bits;
+}
+
+static const FilterKernels scalar_kernels = {"scalar", compare_ints_scalar, compare_floats_scalar};
+
+#ifdef FILTER_X86
+// AVX2 int compares: only ==, > and < exist, the other operators are their complements
+__attribute__((target("avx2")))
+static uint64_t compare_ints_avx2(const int *data, size_t n, int value, CompareOp op) {
+    if (n < WORD_BITS) {
+        return compare_ints_scalar(data, n, value, op);
+    }
+    const __m256i constant = _mm256_set1_epi32(value);
+    uint64_t bits = 0;
+    for (int k = 0; k < WORD_BITS / 8; k++) {
+        __m256i values = _mm256_loadu_si256((const __m256i *)(data + 8 * k));
+        __m256i matches;
+        if (op == COMPARE_EQ || op == COMPARE_NE) {
+            matches = _mm256_cmpeq_epi32(values, constant);
+        } else if (op == COMPARE_LT || op == COMPARE_GE) {
+            matches = _mm256_cmpgt_epi32(constant, values);
+        } else {
+            matches = _mm256_cmpgt_epi32(values, constant);
+        }
+        bits |= (uint64_t)(uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(matches)) << (8 * k);
+    }
+    return op == COMPARE_NE || op == COMPARE_GE || op == COMPARE_LE ? ~bits : bits;
+}
+
+// Compares WORD_BITS floats with an immediate VCMPPS predicate
+#define COMPARE_FLOATS_AVX2(predicate)                                                                  \
+    for (int k = 0; k < WORD_BITS / 8; k++) {                                                           \
+        __m256 matches = _mm256_cmp_ps(_mm256_loadu_ps(data + 8 * k), constant, predicate);             \
+        bits |= (uint64_t)(uint8_t)_mm256_movemask_ps(matches) << (8 * k);                              \
+    }
+
+// AVX2 float compares; ordered predicates are false for NaN and != is true, as in C
+__attribute__((target("avx2")))
+static uint64_t compare_floats_avx2(const float *data, size_t n, float value, CompareOp op) {
+    if (n < WORD_BITS) {
+        return compare_floats_scalar(data, n, value, op);
+    }
+    const __m256 constant = _mm256_set1_ps(value);
+    uint64_t bits = 0;
+    switch (op) {
+        case COMPARE_EQ: COMPARE_FLOATS_AVX2(_CMP_EQ_OQ); break;
+        case COMPARE_NE: COMPARE_FLOATS_AVX2(_CMP_NEQ_UQ); break;
+        case COMPARE_LT: COMPARE_FLOATS_AVX2(_CMP_LT_OQ); break;
+        case COMPARE_LE: COMPARE_FLOATS_AVX2(_CMP_LE_OQ); break;
+        case COMPARE_GT: COMPARE_FLOATS_AVX2(_CMP_GT_OQ); break;
+        case COMPARE_GE: COMPARE_FLOATS_AVX2(_CMP_GE_OQ); break;
+    }
+    return bits;
+}
+
+static const FilterKernels avx2_kernels = {"avx2", compare_ints_avx2, compare_floats_avx2};
+#endif
+
+static const FilterKernels *kernels = &scalar_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+// Picks the widest kernels supported by the running CPU
+static void select_kernels(void) {
+#ifdef FILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels = &avx2_kernels;
+    }
+#endif
+}
+
+const char *filter_implementation(void) {
+    pthread_once(&kernels_once, select_kernels);
+    return kernels->name;
+}
+
+static inline size_t num_words(size_t num_rows) {
+    return (num_rows + WORD_BITS - 1) / WORD_BITS;
+}
+
+// Number of rows held by word w of a mask over num_rows rows
+static inline size_t word_rows(size_t num_rows, size_t w) {
+    size_t remaining = num_rows - w * WORD_BITS;
+    return remaining < WORD_BITS ? remaining : WORD_BITS;
+}
+
+int row_mask_init(RowMask *mask, size_t num_rows) {
+    mask->words = calloc(num_words(num_rows) ? num_words(num_rows) : 1, sizeof(uint64_t));
+    if (mask->words == NULL) {
+        fprintf(stderr, "Memory allocation failed for row mask of %zu rows\n", num_rows);
+        return -1;
+    }
+    mask->num_rows = num_rows;
+    return 0;
+}
+
+void row_mask_free(RowMask *mask) {
+    free(mask->words);
+    mask->words = NULL;
+    mask->num_rows = 0;
+}
+
+// Whether a strcmp result satisfies op
+static inline int compare_result(int cmp, CompareOp op) {
+    switch (op) {
+        case COMPARE_EQ: return cmp == 0;
+        case COMPARE_NE: return cmp != 0;
+        case COMPARE_LT: return cmp < 0;
+        case COMPARE_LE: return cmp <= 0;
+        case COMPARE_GT: return cmp > 0;
+        case COMPARE_GE: return cmp >= 0;
+    }
+    return 0;
+}
+
+// Compares every code of a column against one code with the int kernels
+static void compare_codes(const int *codes, size_t num_rows, int code, CompareOp op, uint64_t *words) {
+    for (size_t w = 0; w < num_words(num_rows); w++) {
+        size_t n = word_rows(num_rows, w);
+        words[w] = kernels->compare_ints(codes + w * WORD_BITS, n, code, op);
+    }
+}
+
+// Sets the mask bits of rows [from, to)
+static void set_rows(uint64_t *words, size_t from, size_t to) {
+    while (from < to) {
+        size_t w = from / WORD_BITS;
+        size_t bit = from % WORD_BITS;
+        size_t n = to - from < WORD_BITS - bit ? to - from : WORD_BITS - bit;
+        words[w] |= (n == WORD_BITS ? ~UINT64_C(0) : ((UINT64_C(1) << n) - 1)) << bit;
+        from += n;
+    }
+}
+
+// Whether an int satisfies op against value
+static inline int compare_int(int a, int value, CompareOp op) {
+    return compare_result((a > value) - (a < value), op);
+}
+
+// Evaluates a predicate on an encoded INT column. The min/max range settles
+// many predicates outright, RLE runs are tested once each and the other
+// encodings are decoded a block at a time for the int kernels.
+static void compare_encoded(const EncodedInts *encoded, size_t num_rows, int value, CompareOp op, uint64_t *words) {
+    memset(words, 0, num_words(num_rows) * sizeof(uint64_t));
+    if (num_rows == 0) {
+        return;
+    }
+    int at_min = compare_int(encoded->min, value, op);
+    int at_max = compare_int(encoded->max, value, op);
+    int outside = value < encoded->min || value > encoded->max;
+    int decided = op == COMPARE_EQ || op == COMPARE_NE ? outside || encoded->min == encoded->max : at_min == at_max;
+    if (decided) {
+        if (at_min) set_rows(words, 0, num_rows);
+        return;
+    }
+
+    if (encoded->encoding == INT_ENCODING_RLE) {
+        for (size_t run = 0, row = 0; run < encoded->num_runs; run++) {
+            if (compare_int(encoded->run_values[run], value, op)) {
+                set_rows(words, row, encoded->run_ends[run]);
+            }
+            row = encoded->run_ends[run];
+        }
+        return;
+    }
+    int block[DECODE_BLOCK_ROWS];
+    for (size_t row = 0; row < num_rows; row += DECODE_BLOCK_ROWS) {
+        size_t count = num_rows - row < DECODE_BLOCK_ROWS ? num_rows - row : DECODE_BLOCK_ROWS;
+        decode_ints(encoded, row, count, block);
+        compare_codes(block, count, value, op, words + row / WORD_BITS);
+    }
+}
+
+// Evaluates a predicate on a CATEGORICAL column through its codes
+static int compare_categorical(const Column *col, size_t num_rows, CompareOp op, const char *value, uint64_t *words) {
+    const CategoricalData *categorical = &col->data.categorical_data;
+    int code = find_category(col, value, strlen(value));
+
+    if (op == COMPARE_EQ || op == COMPARE_NE) {
+        if (op == COMPARE_EQ && code < 0) {
+            memset(words, 0, num_words(num_rows) * sizeof(uint64_t));
+            return 0;
+        }
+        // Non-NULL rows, intersected with the rows whose code satisfies op
+        compare_codes(categorical->codes, num_rows, 0, COMPARE_GE, words);
+        if (op == COMPARE_NE && code < 0) {
+            return 0;
+        }
+        for (size_t w = 0; w < num_words(num_rows); w++) {
+            size_t n = word_rows(num_rows, w);
+            words[w] &= kernels->compare_ints(categorical->codes + w * WORD_BITS, n, code, op);
+        }
+        return 0;
+    }
+
+    // Resolve the ordering once per category; entry 0 stands for NULL and never matches
+    unsigned char *matches = malloc(categorical->num_categories + 1);
+    if (matches == NULL) {
+        fprintf(stderr, "Memory allocation failed while filtering categories\n");
+        return -1;
+    }
+    matches[0] = 0;
+    for (size_t c = 0; c < categorical->num_categories; c++) {
+        matches[c + 1] = (unsigned char)compare_result(strcmp(category_string(col, (int)c), value), op);
+    }
+    const int *codes = categorical->codes;
+    for (size_t w = 0; w < num_words(num_rows); w++) {
+        size_t n = word_rows(num_rows, w);
+        uint64_t bits = 0;
+        for (size_t i = 0; i < n; i++) {
+            bits |= (uint64_t)matches[codes[w * WORD_BITS + i] + 1] << i;
+        }
+        words[w] = bits;
+    }
+    free(matches);
+    return 0;
+}
+
+int filter_compare(const DataFrame *df, size_t column, CompareOp op, const void *value, RowMask *mask) {
+    if (df == NULL || value == NULL || mask == NULL) {
+        fprintf(stderr, "DataFrame, value or mask is NULL\n");
+        return -1;
+    }
+    if (column >= df->num_columns) {
+        fprintf(stderr, "Column index %zu out of bounds\n", column);
+        return -1;
+    }
+    if (mask->num_rows != df->num_rows) {
+        fprintf(stderr, "Mask covers %zu rows, DataFrame has %zu\n", mask->num_rows, df->num_rows);
+        return -1;
+    }
+    if (op < COMPARE_EQ || op > COMPARE_GE) {
+        fprintf(stderr, "Unsupported comparison %d\n", op);
+        return -1;
+    }
+    pthread_once(&kernels_once, select_kernels);
+
+    const Column *col = &df->columns[column];
+    size_t num_rows = df->num_rows;
+    uint64_t *words = mask->words;
+    switch (col->type) {
+        case DATA_TYPE_INT:
+            if (col->encoding != INT_ENCODING_PLAIN) {
+                compare_encoded(&col->data.encoded_ints, num_rows, *(const int *)value, op, words);
+            } else {
+                compare_codes(col->data.int_data, num_rows, *(const int *)value, op, words);
+            }
+            break;
+        case DATA_TYPE_FLOAT: {
+            float constant = *(const float *)value;
+            for (size_t w = 0; w < num_words(num_rows); w++) {
+                size_t n = word_rows(num_rows, w);
+                words[w] = kernels->compare_floats(col->data.float_data + w * WORD_BITS, n, constant, op);
+            }
+            break;
+        }
+        case DATA_TYPE_STRING:
+            for (size_t w = 0; w < num_words(num_rows); w++) {
+                size_t n = word_rows(num_rows, w);
+                uint64_t bits = 0;
+                for (size_t i = 0; i < n; i++) {
+                    const char *text = column_string(col, w * WORD_BITS + i);
+                    bits |= (uint64_t)(text != NULL && compare_result(strcmp(text, value), op)) << i;
+                }
+                words[w] = bits;
+            }
+            break;
+        case DATA_TYPE_CATEGORICAL:
+            return compare_categorical(col, num_rows, op, value, words);
+        default:
+            fprintf(stderr, "Unsupported DataType %d\n", col->type);
+            return -1;
+    }
+    return 0;
+}
+
+// Checks that two masks can be combined
+static int same_size(const RowMask *dst, const RowMask *src) {
+    if (dst == NULL || src == NULL || dst->num_rows != src->num_rows) {
+        fprintf(stderr, "Row masks are NULL or of different sizes\n");
+        return 0;
+    }
+    return 1;
+}
+
+int row_mask_and(RowMask *dst, const RowMask *src) {
+    if (!same_size(dst, src)) {
+        return -1;
+    }
+    for (size_t w = 0; w < num_words(dst->num_rows); w++) {
+        dst->words[w] &= src->words[w];
+    }
+    return 0;
+}
+
+int row_mask_or(RowMask *dst, const RowMask *src) {
+    if (!same_size(dst, src)) {
+        return -1;
+    }
+    for (size_t w = 0; w < num_words(dst->num_rows); w++) {
+        dst->words[w] |= src->words[w];
+    }
+    return 0;
+}
+
+void row_mask_not(RowMask *mask) {
+    size_t count = num_words(mask->num_rows);
+    for (size_t w = 0; w < count; w++) {
+        mask->words[w] = ~mask->words[w];
+    }
+    // Keep the bits past the last row clear
+    if (mask->num_rows % WORD_BITS != 0) {
+        mask->words[count - 1] &= (UINT64_C(1) << (mask->num_rows % WORD_BITS)) - 1;
+    }
+}
+
+size_t row_mask_count(const RowMask *mask) {
+    size_t count = 0;
+    for (size_t w = 0; w < num_words(mask->num_rows); w++) {
+        count += (size_t)__builtin_popcountll(mask->words[w]);
+    }
+    return count;
+}
+
+size_t *row_mask_selection(const RowMask *mask, size_t *count) {
+    if (mask == NULL || count == NULL) {
+        fprintf(stderr, "Row mask or count is NULL\n");
+        return NULL;
+    }
+    size_t total = row_mask_count(mask);
+    size_t *rows = malloc((total ? total : 1) * sizeof(size_t));
+    if (rows == NULL) {
+        fprintf(stderr, "Memory allocation failed for selection of %zu rows\n", total);
+        return NULL;
+    }
+
+    size_t n = 0;
+    for (size_t w = 0; w < num_words(mask->num_rows); w++) {
+        uint64_t bits = mask->words[w];
+        while (bits) {
+            rows[n++] = w * WORD_BITS + (size_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+        }
+    }
+    *count = n;
+    return rows;
+}
+
+DataFrame *filter_rows(const DataFrame *df, const RowMask *mask) {
+    if (df == NULL || mask == NULL || mask->num_rows != df->num_rows) {
+        fprintf(stderr, "DataFrame or mask is NULL, or the mask does not match the DataFrame\n");
+        return NULL;
+    }
+    size_t count = 0;
+    size_t *rows = row_mask_selection(mask, &count);
+    if (rows == NULL) {
+        return NULL;
+    }
+    DataFrame *out = take_rows(df, rows, count);
+    free(rows);
+    return out;
+}
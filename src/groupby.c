@@ -0,0 +1,491 @@
+#include "groupby.h"
+#include "dfhash.h"
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Rows hashed and looked up together
+#define GROUP_BLOCK 1024
+
+// Rows ahead of the current one whose table slot is prefetched
+#define PREFETCH_DISTANCE 16
+
+// Rows below which another thread does not pay for itself
+#define MIN_ROWS_PER_THREAD (64 * 1024)
+
+// Returned by probe_group when the table cannot grow
+#define GROUP_FAILED ((size_t)-1)
+
+// Slot of the group hash table
+typedef struct {
+    uint64_t hash; // Hash of the group's key
+    size_t group;  // Group index + 1, 0 when the slot is empty
+} GroupSlot;
+
+// Groups found so far and their aggregate state
+typedef struct {
+    GroupSlot *slots;
+    size_t num_slots;  // Size of slots, a power of two
+    size_t *rows;      // Input row holding each group's key
+    uint64_t *hashes;  // Hash of each group's key
+    size_t *counts;    // Number of rows in each group
+    double *values;    // num_aggregations accumulators per group
+    size_t num_groups; // Number of groups
+    size_t capacity;   // Groups allocated in rows, hashes, counts and values
+} GroupTable;
+
+// Description of the group-by shared by every thread
+typedef struct {
+    const DataFrame *df;
+    const size_t *keys;
+    size_t num_keys;
+    const Aggregation *aggregations;
+    size_t num_aggregations;
+} GroupSpec;
+
+// Slice of the input grouped by one thread
+typedef struct {
+    const GroupSpec *spec;
+    size_t start;     // First row of the slice
+    size_t end;       // One past the last row of the slice
+    GroupTable table; // Partial groups of the slice
+    int status;       // 0 on success, -1 on failure
+} GroupTask;
+
+static const char *op_names[] = {"sum", "count", "min", "max", "mean"};
+
+static int table_init(GroupTable *table) {
+    memset(table, 0, sizeof(*table));
+    table->num_slots = 64;
+    table->slots = calloc(table->num_slots, sizeof(GroupSlot));
+    if (table->slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for group table\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void table_free(GroupTable *table) {
+    free(table->slots);
+    free(table->rows);
+    free(table->hashes);
+    free(table->counts);
+    free(table->values);
+    memset(table, 0, sizeof(*table));
+}
+
+// Doubles the slots and reinserts every group from its stored hash
+static int table_grow_slots(GroupTable *table) {
+    size_t num_slots = table->num_slots * 2;
+    GroupSlot *slots = calloc(num_slots, sizeof(GroupSlot));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for group table of %zu slots\n", num_slots);
+        return -1;
+    }
+    for (size_t group = 0; group < table->num_groups; group++) {
+        size_t slot = table->hashes[group] & (num_slots - 1);
+        while (slots[slot].group != 0) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+        slots[slot].hash = table->hashes[group];
+        slots[slot].group = group + 1;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->num_slots = num_slots;
+    return 0;
+}
+
+// Grows the per-group arrays to hold at least one more group
+static int table_reserve_group(GroupTable *table, size_t num_aggregations) {
+    if (table->num_groups < table->capacity) {
+        return 0;
+    }
+    size_t capacity = table->capacity ? table->capacity * 2 : 256;
+    size_t *rows = realloc(table->rows, capacity * sizeof(size_t));
+    if (rows) table->rows = rows;
+    uint64_t *hashes = realloc(table->hashes, capacity * sizeof(uint64_t));
+    if (hashes) table->hashes = hashes;
+    size_t *counts = realloc(table->counts, capacity * sizeof(size_t));
+    if (counts) table->counts = counts;
+    double *values = realloc(table->values, capacity * (num_aggregations ? num_aggregations : 1) * sizeof(double));
+    if (values) table->values = values;
+    if (!rows || !hashes || !counts || !values) {
+        fprintf(stderr, "Memory allocation failed for %zu groups\n", capacity);
+        return -1;
+    }
+    table->capacity = capacity;
+    return 0;
+}
+
+// Returns n ints of an INT column from start, decoding encoded columns into block
+static const int *int_rows(const Column *col, size_t start, size_t n, int *block) {
+    if (col->encoding == INT_ENCODING_PLAIN) {
+        return col->data.int_data + start;
+    }
+    decode_ints(&col->data.encoded_ints, start, n, block);
+    return block;
+}
+
+// Whether two input rows have the same key
+static int keys_equal(const GroupSpec *spec, size_t a, size_t b) {
+    for (size_t k = 0; k < spec->num_keys; k++) {
+        const Column *col = &spec->df->columns[spec->keys[k]];
+        switch (col->type) {
+            case DATA_TYPE_INT:
+                if (column_int(col, a) != column_int(col, b)) return 0;
+                break;
+            case DATA_TYPE_CATEGORICAL:
+                if (col->data.categorical_data.codes[a] != col->data.categorical_data.codes[b]) return 0;
+                break;
+            default: {
+                const char *x = column_string(col, a);
+                const char *y = column_string(col, b);
+                if (x != y && (x == NULL || y == NULL || strcmp(x, y) != 0)) return 0;
+                break;
+            }
+        }
+    }
+    return 1;
+}
+
+// Hashes the keys of n rows from start, one key column at a time
+static void hash_keys(const GroupSpec *spec, size_t start, size_t n, uint64_t *hashes) {
+    int block[GROUP_BLOCK];
+    memset(hashes, 0, n * sizeof(uint64_t));
+    for (size_t k = 0; k < spec->num_keys; k++) {
+        const Column *col = &spec->df->columns[spec->keys[k]];
+        switch (col->type) {
+            case DATA_TYPE_INT: {
+                const int *data = int_rows(col, start, n, block);
+                for (size_t i = 0; i < n; i++) hashes[i] = hash_combine(hashes[i], hash_int(data[i]));
+                break;
+            }
+            case DATA_TYPE_CATEGORICAL: {
+                const int *codes = col->data.categorical_data.codes + start;
+                for (size_t i = 0; i < n; i++) hashes[i] = hash_combine(hashes[i], hash_int(codes[i]));
+                break;
+            }
+            default:
+                for (size_t i = 0; i < n; i++) {
+                    const char *value = column_string(col, start + i);
+                    uint64_t hash = value ? hash_bytes(value, strlen(value)) : 0;
+                    hashes[i] = hash_combine(hashes[i], hash);
+                }
+                break;
+        }
+    }
+    for (size_t i = 0; i < n; i++) hashes[i] = hash_mix(hashes[i]);
+}
+
+// Returns the group of a key, adding a group with empty accumulators if the key is new
+static size_t probe_group(GroupTable *table, const GroupSpec *spec, size_t row, uint64_t hash) {
+    // Keep the table at most half full
+    if ((table->num_groups + 1) * 2 > table->num_slots && table_grow_slots(table) != 0) {
+        return GROUP_FAILED;
+    }
+
+    size_t mask = table->num_slots - 1;
+    size_t slot = hash & mask;
+    while (table->slots[slot].group != 0) {
+        size_t group = table->slots[slot].group - 1;
+        if (table->slots[slot].hash == hash && keys_equal(spec, table->rows[group], row)) {
+            return group;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (table_reserve_group(table, spec->num_aggregations) != 0) {
+        return GROUP_FAILED;
+    }
+    size_t group = table->num_groups++;
+    table->rows[group] = row;
+    table->hashes[group] = hash;
+    table->counts[group] = 0;
+    double *values = table->values + group * spec->num_aggregations;
+    for (size_t a = 0; a < spec->num_aggregations; a++) {
+        AggregateOp op = spec->aggregations[a].op;
+        values[a] = op == AGGREGATE_MIN ? INFINITY : op == AGGREGATE_MAX ? -INFINITY : 0.0;
+    }
+    table->slots[slot].hash = hash;
+    table->slots[slot].group = group + 1;
+    return group;
+}
+
+// Updates the accumulators of n rows from start whose groups are known, one aggregate at a time
+static void update_aggregates(GroupTable *table, const GroupSpec *spec, size_t start, size_t n, const size_t *groups) {
+    size_t stride = spec->num_aggregations;
+    int block[GROUP_BLOCK];
+    for (size_t i = 0; i < n; i++) table->counts[groups[i]]++;
+
+    for (size_t a = 0; a < stride; a++) {
+        const Aggregation *aggregation = &spec->aggregations[a];
+        const Column *col = &spec->df->columns[aggregation->column];
+        double *values = table->values + a;
+        if (aggregation->op == AGGREGATE_COUNT) {
+            if (col->type == DATA_TYPE_STRING) {
+                const size_t *offsets = col->data.string_data.offsets + start;
+                for (size_t i = 0; i < n; i++) values[groups[i] * stride] += offsets[i] != STRING_NULL_OFFSET;
+            } else if (col->type == DATA_TYPE_CATEGORICAL) {
+                const int *codes = col->data.categorical_data.codes + start;
+                for (size_t i = 0; i < n; i++) values[groups[i] * stride] += codes[i] >= 0;
+            }
+            // INT and FLOAT have no NULLs, their count is the group's row count
+            continue;
+        }
+
+        const int *ints = col->type == DATA_TYPE_INT ? int_rows(col, start, n, block) : NULL;
+        for (size_t i = 0; i < n; i++) {
+            double value = ints ? ints[i] : col->data.float_data[start + i];
+            double *acc = &values[groups[i] * stride];
+            switch (aggregation->op) {
+                case AGGREGATE_MIN:
+                    if (value < *acc) *acc = value;
+                    break;
+                case AGGREGATE_MAX:
+                    if (value > *acc) *acc = value;
+                    break;
+                default:
+                    *acc += value;
+                    break;
+            }
+        }
+    }
+}
+
+// Groups one slice of the input into a partial table
+static void *run_group_task(void *arg) {
+    GroupTask *task = arg;
+    const GroupSpec *spec = task->spec;
+    uint64_t hashes[GROUP_BLOCK];
+    size_t groups[GROUP_BLOCK];
+
+    task->status = 0;
+    for (size_t start = task->start; start < task->end; start += GROUP_BLOCK) {
+        size_t n = task->end - start < GROUP_BLOCK ? task->end - start : GROUP_BLOCK;
+        hash_keys(spec, start, n, hashes);
+        for (size_t i = 0; i < n; i++) {
+            if (i + PREFETCH_DISTANCE < n) {
+                __builtin_prefetch(&task->table.slots[hashes[i + PREFETCH_DISTANCE] & (task->table.num_slots - 1)]);
+            }
+            groups[i] = probe_group(&task->table, spec, start + i, hashes[i]);
+            if (groups[i] == GROUP_FAILED) {
+                task->status = -1;
+                return NULL;
+            }
+        }
+        update_aggregates(&task->table, spec, start, n, groups);
+    }
+    return NULL;
+}
+
+// Folds the groups of a partial table into the final table
+static int merge_table(GroupTable *table, const GroupTable *partial, const GroupSpec *spec) {
+    size_t stride = spec->num_aggregations;
+    for (size_t g = 0; g < partial->num_groups; g++) {
+        size_t group = probe_group(table, spec, partial->rows[g], partial->hashes[g]);
+        if (group == GROUP_FAILED) {
+            return -1;
+        }
+        table->counts[group] += partial->counts[g];
+        double *values = table->values + group * stride;
+        const double *other = partial->values + g * stride;
+        for (size_t a = 0; a < stride; a++) {
+            switch (spec->aggregations[a].op) {
+                case AGGREGATE_MIN:
+                    if (other[a] < values[a]) values[a] = other[a];
+                    break;
+                case AGGREGATE_MAX:
+                    if (other[a] > values[a]) values[a] = other[a];
+                    break;
+                default:
+                    values[a] += other[a];
+                    break;
+            }
+        }
+    }
+    return 0;
+}
+
+// Checks the key columns and aggregations against the DataFrame
+static int validate_group_by(const DataFrame *df, const size_t *key_columns, size_t num_keys,
+                             const Aggregation *aggregations, size_t num_aggregations) {
+    if (df == NULL || key_columns == NULL || num_keys == 0 || (aggregations == NULL && num_aggregations > 0)) {
+        fprintf(stderr, "Invalid arguments to group_by\n");
+        return -1;
+    }
+    for (size_t k = 0; k < num_keys; k++) {
+        if (key_columns[k] >= df->num_columns) {
+            fprintf(stderr, "Key column index %zu out of bounds\n", key_columns[k]);
+            return -1;
+        }
+        DataType type = df->columns[key_columns[k]].type;
+        if (type != DATA_TYPE_INT && type != DATA_TYPE_STRING && type != DATA_TYPE_CATEGORICAL) {
+            fprintf(stderr, "Column '%s' cannot be a group key\n", df->columns[key_columns[k]].name);
+            return -1;
+        }
+    }
+    for (size_t a = 0; a < num_aggregations; a++) {
+        const Aggregation *aggregation = &aggregations[a];
+        if (aggregation->column >= df->num_columns) {
+            fprintf(stderr, "Aggregation column index %zu out of bounds\n", aggregation->column);
+            return -1;
+        }
+        if (aggregation->op < AGGREGATE_SUM || aggregation->op > AGGREGATE_MEAN) {
+            fprintf(stderr, "Unsupported aggregate %d\n", aggregation->op);
+            return -1;
+        }
+        DataType type = df->columns[aggregation->column].type;
+        if (aggregation->op != AGGREGATE_COUNT && type != DATA_TYPE_INT && type != DATA_TYPE_FLOAT) {
+            fprintf(stderr, "Cannot compute %s of non-numeric column '%s'\n",
+                    op_names[aggregation->op], df->columns[aggregation->column].name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Builds the result frame: the key of each group followed by its aggregates
+static DataFrame *materialize_groups(const GroupTable *table, const GroupSpec *spec) {
+    const DataFrame *df = spec->df;
+    size_t num_groups = table->num_groups;
+    DataFrame *out = create_dataframe(num_groups, spec->num_keys + spec->num_aggregations);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    for (size_t k = 0; k < spec->num_keys; k++) {
+        const Column *key = &df->columns[spec->keys[k]];
+        if (add_column(out, key->type, k, key->name) != 0 ||
+            gather_values(out, k, df, spec->keys[k], table->rows, num_groups) != 0) {
+            destroy_dataframe(out);
+            return NULL;
+        }
+    }
+
+    size_t stride = spec->num_aggregations;
+    for (size_t a = 0; a < stride; a++) {
+        const Aggregation *aggregation = &spec->aggregations[a];
+        const Column *input = &df->columns[aggregation->column];
+        size_t index = spec->num_keys + a;
+
+        // Room for the operator prefix; long names are cut to the column name limit
+        char name[MAX_COLUMN_NAME_LENGTH + 8];
+        if (aggregation->name != NULL) {
+            snprintf(name, MAX_COLUMN_NAME_LENGTH, "%s", aggregation->name);
+        } else {
+            snprintf(name, sizeof(name), "%s_%s", op_names[aggregation->op], input->name);
+        }
+        name[MAX_COLUMN_NAME_LENGTH - 1] = '\0';
+
+        DataType type = DATA_TYPE_FLOAT;
+        if (aggregation->op == AGGREGATE_COUNT) {
+            type = DATA_TYPE_INT;
+        } else if (aggregation->op == AGGREGATE_MIN || aggregation->op == AGGREGATE_MAX) {
+            type = input->type;
+        }
+        if (add_column(out, type, index, name) != 0) {
+            destroy_dataframe(out);
+            return NULL;
+        }
+
+        Column *col = &out->columns[index];
+        for (size_t g = 0; g < num_groups; g++) {
+            double value = table->values[g * stride + a];
+            switch (aggregation->op) {
+                case AGGREGATE_COUNT:
+                    if (input->type == DATA_TYPE_INT || input->type == DATA_TYPE_FLOAT) value = (double)table->counts[g];
+                    // Converting a count beyond INT_MAX to int is undefined
+                    if (value > INT_MAX) {
+                        fprintf(stderr, "Count of group %zu (%.0f rows) does not fit an INT column\n", g, value);
+                        destroy_dataframe(out);
+                        return NULL;
+                    }
+                    col->data.int_data[g] = (int)value;
+                    break;
+                case AGGREGATE_MEAN:
+                    col->data.float_data[g] = (float)(value / (double)table->counts[g]);
+                    break;
+                case AGGREGATE_MIN:
+                case AGGREGATE_MAX:
+                    if (type == DATA_TYPE_INT) {
+                        col->data.int_data[g] = (int)value;
+                    } else {
+                        col->data.float_data[g] = (float)value;
+                    }
+                    break;
+                default:
+                    col->data.float_data[g] = (float)value;
+                    break;
+            }
+        }
+    }
+    return out;
+}
+
+// Function to group a dataframe by key columns and aggregate each group
+DataFrame *group_by(const DataFrame *df, const size_t *key_columns, size_t num_keys,
+                    const Aggregation *aggregations, size_t num_aggregations, size_t num_threads) {
+    if (validate_group_by(df, key_columns, num_keys, aggregations, num_aggregations) != 0) {
+        return NULL;
+    }
+    GroupSpec spec = {df, key_columns, num_keys, aggregations, num_aggregations};
+
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    size_t max_threads = df->num_rows / MIN_ROWS_PER_THREAD;
+    if (num_threads > max_threads) num_threads = max_threads;
+    if (num_threads == 0) num_threads = 1;
+
+    GroupTask *tasks = calloc(num_threads, sizeof(GroupTask));
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    if (tasks == NULL || threads == NULL) {
+        fprintf(stderr, "Memory allocation failed for group-by tasks\n");
+        free(tasks);
+        free(threads);
+        return NULL;
+    }
+
+    DataFrame *out = NULL;
+    size_t ready = 0;
+    for (; ready < num_threads; ready++) {
+        tasks[ready].spec = &spec;
+        tasks[ready].start = df->num_rows * ready / num_threads;
+        tasks[ready].end = df->num_rows * (ready + 1) / num_threads;
+        if (table_init(&tasks[ready].table) != 0) goto cleanup;
+    }
+
+    // The calling thread takes the first slice; slices whose thread fails to start run inline
+    size_t started = 0;
+    for (size_t i = 1; i < num_threads; i++, started++) {
+        if (pthread_create(&threads[i], NULL, run_group_task, &tasks[i]) != 0) break;
+    }
+    run_group_task(&tasks[0]);
+    for (size_t i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = started + 1; i < num_threads; i++) {
+        run_group_task(&tasks[i]);
+    }
+
+    // Merging in slice order keeps groups in order of first appearance
+    for (size_t i = 0; i < num_threads; i++) {
+        if (tasks[i].status != 0) goto cleanup;
+        if (i > 0 && merge_table(&tasks[0].table, &tasks[i].table, &spec) != 0) goto cleanup;
+    }
+    out = materialize_groups(&tasks[0].table, &spec);
+
+cleanup:
+    for (size_t i = 0; i < ready; i++) {
+        table_free(&tasks[i].table);
+    }
+    free(tasks);
+    free(threads);
+    return out;
+}
@@ -0,0 +1,350 @@
+#include "join.h"
+#include "dfhash.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Probe rows whose buckets are prefetched together
+#define PROBE_BATCH 256
+
+// Build rows per partition targeted by partitioned joins, about 1 MB of table
+#define PARTITION_ROWS (32 * 1024)
+
+// Upper bound on the partition bits
+#define MAX_PARTITION_BITS 12
+
+// Rows of an encoded key column decoded at a time
+#define DECODE_BLOCK_ROWS 1024
+
+// Rows of one side of the join, possibly scattered into partitions
+typedef struct {
+    const Column *key;        // Key column
+    size_t num_rows;          // Rows in the DataFrame
+    size_t *rows;             // Row indices, grouped by partition
+    uint64_t *hashes;         // Key hash of each entry of rows
+    size_t *partition_starts; // Start of each partition in rows, plus the total at the end
+} JoinSide;
+
+// Chained hash table over the build entries of one partition
+typedef struct {
+    size_t *heads;      // Entry + 1 of the first entry in each bucket, 0 when empty
+    size_t *next;       // Entry + 1 of the next entry in the same bucket
+    size_t num_buckets; // Power of two
+} JoinTable;
+
+// Growable list of matched (left, right) row pairs
+typedef struct {
+    size_t *left;
+    size_t *right;
+    size_t count;
+    size_t capacity;
+} JoinPairs;
+
+// Whether the key of a row is NULL
+static inline int key_is_null(const Column *key, size_t row) {
+    switch (key->type) {
+        case DATA_TYPE_STRING:
+            return key->data.string_data.offsets[row] == STRING_NULL_OFFSET;
+        case DATA_TYPE_CATEGORICAL:
+            return key->data.categorical_data.codes[row] < 0;
+        default:
+            return 0;
+    }
+}
+
+// Hashes every key of a column; text keys hash the same whether STRING or CATEGORICAL
+static void hash_key_column(const Column *key, size_t num_rows, uint64_t *hashes) {
+    switch (key->type) {
+        case DATA_TYPE_INT:
+            if (key->encoding != INT_ENCODING_PLAIN) {
+                int block[DECODE_BLOCK_ROWS];
+                for (size_t start = 0; start < num_rows; start += DECODE_BLOCK_ROWS) {
+                    size_t n = num_rows - start < DECODE_BLOCK_ROWS ? num_rows - start : DECODE_BLOCK_ROWS;
+                    decode_ints(&key->data.encoded_ints, start, n, block);
+                    for (size_t i = 0; i < n; i++) hashes[start + i] = hash_int(block[i]);
+                }
+                break;
+            }
+            for (size_t row = 0; row < num_rows; row++) hashes[row] = hash_int(key->data.int_data[row]);
+            break;
+        case DATA_TYPE_CATEGORICAL: {
+            // The dictionary already holds the hash of every category
+            const CategoricalData *categorical = &key->data.categorical_data;
+            for (size_t row = 0; row < num_rows; row++) {
+                int code = categorical->codes[row];
+                hashes[row] = code < 0 ? 0 : categorical->hashes[code];
+            }
+            break;
+        }
+        default:
+            for (size_t row = 0; row < num_rows; row++) {
+                const char *value = column_string(key, row);
+                hashes[row] = value ? hash_bytes(value, strlen(value)) : 0;
+            }
+            break;
+    }
+}
+
+// Whether two non-NULL keys are equal
+static inline int keys_match(const Column *a, size_t row_a, const Column *b, size_t row_b) {
+    if (a->type == DATA_TYPE_INT) {
+        return column_int(a, row_a) == column_int(b, row_b);
+    }
+    return strcmp(column_text(a, row_a), column_text(b, row_b)) == 0;
+}
+
+static void free_side(JoinSide *side) {
+    free(side->rows);
+    free(side->hashes);
+    free(side->partition_starts);
+}
+
+// Hashes a side and scatters its rows into 2^bits partitions by the top hash bits
+static int partition_side(JoinSide *side, size_t bits, int skip_nulls) {
+    size_t num_partitions = (size_t)1 << bits;
+    size_t n = side->num_rows;
+    uint64_t *hashes = malloc((n ? n : 1) * sizeof(uint64_t));
+    side->rows = malloc((n ? n : 1) * sizeof(size_t));
+    side->hashes = malloc((n ? n : 1) * sizeof(uint64_t));
+    side->partition_starts = calloc(num_partitions + 1, sizeof(size_t));
+    if (!hashes || !side->rows || !side->hashes || !side->partition_starts) {
+        fprintf(stderr, "Memory allocation failed while partitioning join input\n");
+        free(hashes);
+        return -1;
+    }
+    hash_key_column(side->key, n, hashes);
+
+    // Histogram, prefix sums, then scatter; rows keep their order inside a partition
+    int shift = bits ? (int)(64 - bits) : 0;
+    size_t *starts = side->partition_starts;
+    for (size_t row = 0; row < n; row++) {
+        if (skip_nulls && key_is_null(side->key, row)) continue;
+        starts[bits ? (hashes[row] >> shift) + 1 : 1]++;
+    }
+    for (size_t p = 0; p < num_partitions; p++) starts[p + 1] += starts[p];
+
+    size_t *fill = malloc(num_partitions * sizeof(size_t));
+    if (!fill) {
+        fprintf(stderr, "Memory allocation failed while partitioning join input\n");
+        free(hashes);
+        return -1;
+    }
+    memcpy(fill, starts, num_partitions * sizeof(size_t));
+    for (size_t row = 0; row < n; row++) {
+        if (skip_nulls && key_is_null(side->key, row)) continue;
+        size_t slot = fill[bits ? hashes[row] >> shift : 0]++;
+        side->rows[slot] = row;
+        side->hashes[slot] = hashes[row];
+    }
+    free(fill);
+    free(hashes);
+    return 0;
+}
+
+// Builds the chained table over entries [start, end) of the build side
+static int build_table(JoinTable *table, const JoinSide *build, size_t start, size_t end) {
+    size_t n = end - start;
+    size_t num_buckets = 16;
+    while (num_buckets < n) num_buckets *= 2;
+
+    if (num_buckets > table->num_buckets) {
+        free(table->heads);
+        table->heads = malloc(num_buckets * sizeof(size_t));
+        if (!table->heads) {
+            fprintf(stderr, "Memory allocation failed for join table of %zu buckets\n", num_buckets);
+            table->num_buckets = 0;
+            return -1;
+        }
+    }
+    table->num_buckets = num_buckets;
+    memset(table->heads, 0, num_buckets * sizeof(size_t));
+
+    // Insert backwards so that every chain lists its entries in row order
+    for (size_t i = n; i-- > 0;) {
+        size_t bucket = build->hashes[start + i] & (num_buckets - 1);
+        table->next[i] = table->heads[bucket];
+        table->heads[bucket] = i + 1;
+    }
+    return 0;
+}
+
+static int add_pair(JoinPairs *pairs, size_t left, size_t right) {
+    if (pairs->count == pairs->capacity) {
+        size_t capacity = pairs->capacity ? pairs->capacity * 2 : 1024;
+        size_t *l = realloc(pairs->left, capacity * sizeof(size_t));
+        if (l) pairs->left = l;
+        size_t *r = realloc(pairs->right, capacity * sizeof(size_t));
+        if (r) pairs->right = r;
+        if (!l || !r) {
+            fprintf(stderr, "Memory allocation failed for %zu joined rows\n", capacity);
+            return -1;
+        }
+        pairs->capacity = capacity;
+    }
+    pairs->left[pairs->count] = left;
+    pairs->right[pairs->count] = right;
+    pairs->count++;
+    return 0;
+}
+
+// Probes one partition's table with the probe entries of the same partition
+static int probe_partition(const JoinTable *table, const JoinSide *build, size_t build_start,
+                           const JoinSide *probe, size_t start, size_t end,
+                           int build_is_left, int keep_unmatched, JoinPairs *pairs) {
+    size_t mask = table->num_buckets - 1;
+    for (size_t base = start; base < end; base += PROBE_BATCH) {
+        size_t batch_end = end - base < PROBE_BATCH ? end : base + PROBE_BATCH;
+        for (size_t i = base; i < batch_end; i++) {
+            __builtin_prefetch(&table->heads[probe->hashes[i] & mask]);
+        }
+
+        for (size_t i = base; i < batch_end; i++) {
+            size_t probe_row = probe->rows[i];
+            uint64_t hash = probe->hashes[i];
+            int matched = 0;
+            if (!key_is_null(probe->key, probe_row)) {
+                for (size_t entry = table->heads[hash & mask]; entry != 0; entry = table->next[entry - 1]) {
+                    size_t slot = build_start + entry - 1;
+                    if (build->hashes[slot] != hash || !keys_match(build->key, build->rows[slot], probe->key, probe_row)) {
+                        continue;
+                    }
+                    matched = 1;
+                    size_t build_row = build->rows[slot];
+                    if (add_pair(pairs, build_is_left ? build_row : probe_row, build_is_left ? probe_row : build_row) != 0) {
+                        return -1;
+                    }
+                }
+            }
+            if (!matched && keep_unmatched && add_pair(pairs, probe_row, GATHER_NULL_ROW) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Checks that the two key columns can be compared
+static int validate_join(const DataFrame *left, size_t left_key, const DataFrame *right, size_t right_key,
+                         const JoinOptions *options) {
+    if (left == NULL || right == NULL) {
+        fprintf(stderr, "DataFrame is NULL\n");
+        return -1;
+    }
+    if (left_key >= left->num_columns || right_key >= right->num_columns) {
+        fprintf(stderr, "Join key index out of bounds (left: %zu, right: %zu)\n", left_key, right_key);
+        return -1;
+    }
+    if (options != NULL && options->type != JOIN_INNER && options->type != JOIN_LEFT) {
+        fprintf(stderr, "Unsupported join type %d\n", options->type);
+        return -1;
+    }
+
+    DataType a = left->columns[left_key].type;
+    DataType b = right->columns[right_key].type;
+    int a_text = a == DATA_TYPE_STRING || a == DATA_TYPE_CATEGORICAL;
+    int b_text = b == DATA_TYPE_STRING || b == DATA_TYPE_CATEGORICAL;
+    if (!((a == DATA_TYPE_INT && b == DATA_TYPE_INT) || (a_text && b_text))) {
+        fprintf(stderr, "Cannot join key '%s' of type %d with key '%s' of type %d\n",
+                left->columns[left_key].name, a, right->columns[right_key].name, b);
+        return -1;
+    }
+    return 0;
+}
+
+// Creates the result frame and fills each column with one gather
+static DataFrame *materialize_join(const DataFrame *left, const DataFrame *right, size_t right_key, const JoinPairs *pairs) {
+    DataFrame *out = create_dataframe(pairs->count, left->num_columns + right->num_columns - 1);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < left->num_columns; i++) {
+        const Column *col = &left->columns[i];
+        if (add_column(out, col->type, i, col->name) != 0 || gather_values(out, i, left, i, pairs->left, pairs->count) != 0) {
+            destroy_dataframe(out);
+            return NULL;
+        }
+    }
+
+    size_t index = left->num_columns;
+    for (size_t i = 0; i < right->num_columns; i++) {
+        if (i == right_key) continue;
+        const Column *col = &right->columns[i];
+
+        // Suffix names already taken by a left column
+        char name[MAX_COLUMN_NAME_LENGTH];
+        snprintf(name, sizeof(name), "%s", col->name);
+        if (find_column(left, col->name) >= 0) {
+            size_t length = strlen(col->name);
+            if (length > MAX_COLUMN_NAME_LENGTH - 7) length = MAX_COLUMN_NAME_LENGTH - 7;
+            memcpy(name + length, "_right", 7);
+        }
+
+        if (add_column(out, col->type, index, name) != 0 || gather_values(out, index, right, i, pairs->right, pairs->count) != 0) {
+            destroy_dataframe(out);
+            return NULL;
+        }
+        index++;
+    }
+    return out;
+}
+
+// Function to join two dataframes on a key column each
+DataFrame *hash_join(const DataFrame *left, size_t left_key, const DataFrame *right, size_t right_key,
+                     const JoinOptions *options) {
+    if (validate_join(left, left_key, right, right_key, options) != 0) {
+        return NULL;
+    }
+    JoinType type = options ? options->type : JOIN_INNER;
+
+    // Build on the smaller side; a left join must probe with every left row
+    int build_is_left = type == JOIN_INNER && left->num_rows < right->num_rows;
+    JoinSide sides[2] = {
+        {&left->columns[left_key], left->num_rows, NULL, NULL, NULL},
+        {&right->columns[right_key], right->num_rows, NULL, NULL, NULL},
+    };
+    JoinSide *build = &sides[build_is_left ? 0 : 1];
+    JoinSide *probe = &sides[build_is_left ? 1 : 0];
+
+    size_t bits = 0;
+    if (options && options->partitioned) {
+        while (bits < MAX_PARTITION_BITS && (build->num_rows >> bits) > PARTITION_ROWS) bits++;
+    }
+    size_t num_partitions = (size_t)1 << bits;
+
+    DataFrame *out = NULL;
+    JoinTable table = {NULL, NULL, 0};
+    JoinPairs pairs = {NULL, NULL, 0, 0};
+    if (partition_side(build, bits, 1) != 0 || partition_side(probe, bits, 0) != 0) goto cleanup;
+
+    // Chains are indexed per partition, so next only needs room for the largest one
+    size_t largest = 1;
+    for (size_t p = 0; p < num_partitions; p++) {
+        size_t n = build->partition_starts[p + 1] - build->partition_starts[p];
+        if (n > largest) largest = n;
+    }
+    table.next = malloc(largest * sizeof(size_t));
+    if (!table.next) {
+        fprintf(stderr, "Memory allocation failed for join table\n");
+        goto cleanup;
+    }
+
+    for (size_t p = 0; p < num_partitions; p++) {
+        size_t build_start = build->partition_starts[p];
+        if (build_table(&table, build, build_start, build->partition_starts[p + 1]) != 0 ||
+            probe_partition(&table, build, build_start, probe, probe->partition_starts[p], probe->partition_starts[p + 1],
+                            build_is_left, type == JOIN_LEFT, &pairs) != 0) {
+            goto cleanup;
+        }
+    }
+    out = materialize_join(left, right, right_key, &pairs);
+
+cleanup:
+    free_side(&sides[0]);
+    free_side(&sides[1]);
+    free(table.heads);
+    free(table.next);
+    free(pairs.left);
+    free(pairs.right);
+    return out;
+}
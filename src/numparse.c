@@ -0,0 +1,274 @@
+#define _GNU_SOURCE // strtof_l
+#include "numparse.h"
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+// Significant digits kept in the 64-bit mantissa of a float being parsed
+#define MAX_MANTISSA_DIGITS 19
+
+// Largest mantissa and decimal exponent for which the float fast path is exact
+#define FAST_MANTISSA_MAX (UINT64_C(1) << 24)
+#define FAST_EXPONENT_MAX 10
+
+// Fields longer than this are copied to the heap for strtof
+#define FLOAT_BUFFER_SIZE 64
+
+// Powers of ten that are exact in a float
+static const float float_powers[FAST_EXPONENT_MAX + 1] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static inline int is_digit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Loads eight bytes with the first byte in the lowest position
+static inline uint64_t load_eight(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// Whether all eight bytes of a word are ASCII digits
+static inline int is_eight_digits(uint64_t v) {
+    return ((v & UINT64_C(0xF0F0F0F0F0F0F0F0)) |
+            (((v + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4)) ==
+           UINT64_C(0x3333333333333333);
+}
+
+// Converts eight ASCII digits to their value with three multiplications
+static inline uint32_t eight_digits(uint64_t v) {
+    const uint64_t mask = UINT64_C(0x000000FF000000FF);
+    v -= UINT64_C(0x3030303030303030);
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * (100 + (UINT64_C(1000000) << 32))) +
+         (((v >> 16) & mask) * (1 + (UINT64_C(10000) << 32)))) >> 32;
+    return (uint32_t)v;
+}
+
+// Narrows [*start, *end) by removing surrounding spaces and tabs
+static inline void trim_blanks(const char **start, const char **end) {
+    while (*start < *end && is_blank(**start)) (*start)++;
+    while (*end > *start && is_blank((*end)[-1])) (*end)--;
+}
+
+// Function to convert a decimal field to an int
+ParseStatus parse_int32(const char *start, size_t length, int *value) {
+    const char *p = start;
+    const char *end = start + length;
+    *value = 0;
+    trim_blanks(&p, &end);
+    if (p == end) {
+        return PARSE_EMPTY;
+    }
+
+    int negative = 0;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || !is_digit(*p)) {
+        return PARSE_INVALID;
+    }
+
+    // Magnitudes beyond the limit stop growing, so the accumulator cannot wrap
+    const uint64_t limit = negative ? (uint64_t)INT32_MAX + 1 : (uint64_t)INT32_MAX;
+    uint64_t magnitude = 0;
+    while (end - p >= 8) {
+        uint64_t word = load_eight(p);
+        if (!is_eight_digits(word)) break;
+        magnitude = magnitude * 100000000 + eight_digits(word);
+        if (magnitude > limit) magnitude = limit + 1;
+        p += 8;
+    }
+    while (p < end && is_digit(*p)) {
+        magnitude = magnitude * 10 + (uint64_t)(*p - '0');
+        if (magnitude > limit) magnitude = limit + 1;
+        p++;
+    }
+    if (p != end) {
+        return PARSE_INVALID;
+    }
+    if (magnitude > limit) {
+        return PARSE_OVERFLOW;
+    }
+    *value = negative ? (int)(-(int64_t)magnitude) : (int)magnitude;
+    return PARSE_OK;
+}
+
+// The "C" locale used by the slow path, created once for all threads
+static locale_t c_locale;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+static void create_c_locale(void) {
+    c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+// Converts a validated field with strtof_l in the "C" locale, which needs a NUL-terminated copy
+static ParseStatus parse_float_slow(const char *start, const char *end, float *value) {
+    size_t length = (size_t)(end - start);
+    char buffer[FLOAT_BUFFER_SIZE];
+    char *text = length < sizeof(buffer) ? buffer : malloc(length + 1);
+    if (text == NULL) {
+        *value = 0.0f;
+        return PARSE_INVALID;
+    }
+    memcpy(text, start, length);
+    text[length] = '\0';
+    pthread_once(&c_locale_once, create_c_locale);
+    char *parsed_end;
+    // Without a "C" locale a mismatched decimal point is caught by the end check below
+    *value = c_locale != (locale_t)0 ? strtof_l(text, &parsed_end, c_locale) : strtof(text, &parsed_end);
+    int complete = parsed_end == text + length;
+    if (text != buffer) free(text);
+    if (!complete) {
+        *value = 0.0f;
+        return PARSE_INVALID;
+    }
+    return isinf(*value) ? PARSE_OVERFLOW : PARSE_OK;
+}
+
+// Function to convert a decimal field to a float
+ParseStatus parse_float32(const char *start, size_t length, float *value) {
+    const char *p = start;
+    const char *end = start + length;
+    *value = 0.0f;
+    trim_blanks(&p, &end);
+    if (p == end) {
+        return PARSE_EMPTY;
+    }
+    const char *number = p;
+
+    int negative = 0;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+
+    // Special values
+    size_t rest = (size_t)(end - p);
+    if (rest > 0 && !is_digit(*p) && *p != '.') {
+        if ((rest == 3 && strncasecmp(p, "inf", 3) == 0) || (rest == 8 && strncasecmp(p, "infinity", 8) == 0)) {
+            *value = negative ? -INFINITY : INFINITY;
+            return PARSE_OK;
+        }
+        if (rest == 3 && strncasecmp(p, "nan", 3) == 0) {
+            *value = negative ? -NAN : NAN;
+            return PARSE_OK;
+        }
+        return PARSE_INVALID;
+    }
+
+    // Significant digits go into the mantissa, the rest only move the exponent
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int truncated = 0;
+    int seen_digit = 0;
+    while (p < end && is_digit(*p)) {
+        if (mantissa != 0 && digits + 8 <= MAX_MANTISSA_DIGITS && end - p >= 8 && is_eight_digits(load_eight(p))) {
+            mantissa = mantissa * 100000000 + eight_digits(load_eight(p));
+            digits += 8;
+            p += 8;
+            seen_digit = 1;
+            continue;
+        }
+        int digit = *p++ - '0';
+        seen_digit = 1;
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (uint64_t)digit;
+            if (mantissa != 0) digits++;
+        } else {
+            exponent++;
+            truncated |= digit != 0;
+        }
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && is_digit(*p)) {
+            if (mantissa != 0 && digits + 8 <= MAX_MANTISSA_DIGITS && end - p >= 8 && is_eight_digits(load_eight(p))) {
+                mantissa = mantissa * 100000000 + eight_digits(load_eight(p));
+                digits += 8;
+                exponent -= 8;
+                p += 8;
+                seen_digit = 1;
+                continue;
+            }
+            int digit = *p++ - '0';
+            seen_digit = 1;
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (uint64_t)digit;
+                if (mantissa != 0) digits++;
+                exponent--;
+            } else {
+                truncated |= digit != 0;
+            }
+        }
+    }
+    if (!seen_digit) {
+        return PARSE_INVALID;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int exponent_negative = 0;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exponent_negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p)) {
+            return PARSE_INVALID;
+        }
+        int explicit_exponent = 0;
+        while (p < end && is_digit(*p)) {
+            if (explicit_exponent < 100000) explicit_exponent = explicit_exponent * 10 + (*p - '0');
+            p++;
+        }
+        exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+    if (p != end) {
+        return PARSE_INVALID;
+    }
+
+    if (mantissa == 0 && !truncated) {
+        *value = negative ? -0.0f : 0.0f;
+        return PARSE_OK;
+    }
+#if FLT_EVAL_METHOD == 0
+    // Both operands are exact floats, so one correctly rounded operation gives the answer
+    if (!truncated && mantissa <= FAST_MANTISSA_MAX && exponent >= -FAST_EXPONENT_MAX && exponent <= FAST_EXPONENT_MAX) {
+        float result = (float)mantissa;
+        result = exponent >= 0 ? result * float_powers[exponent] : result / float_powers[-exponent];
+        *value = negative ? -result : result;
+        return PARSE_OK;
+    }
+#endif
+    return parse_float_slow(number, end, value);
+}
+
+// Function to describe a parse status
+const char *parse_status_message(ParseStatus status) {
+    switch (status) {
+        case PARSE_OK:
+            return "ok";
+        case PARSE_EMPTY:
+            return "empty field";
+        case PARSE_INVALID:
+            return "invalid number";
+        case PARSE_OVERFLOW:
+            return "number out of range";
+        default:
+            return "unknown status";
+    }
+}
@@ -0,0 +1,255 @@
+#define _GNU_SOURCE // O_DIRECT
+#include "readahead.h"
+#include "dfstats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Alignment of every block and of the block size, as O_DIRECT requires
+#define READAHEAD_ALIGNMENT 4096
+
+// Defaults for zeroed options
+#define DEFAULT_BLOCK_SIZE (1024 * 1024)
+#define DEFAULT_NUM_BLOCKS 4
+
+struct ReadAhead {
+    ReadAheadSource source;
+    void *context;
+    int fd;               // File opened by readahead_open, or -1
+    Decompressor *decompressor; // Compressed file opened by readahead_open, or NULL
+    char **blocks;        // num_blocks buffers of block_size bytes
+    size_t *lengths;      // Bytes of input in each filled block
+    size_t block_size;
+    size_t num_blocks;
+    size_t head;          // Blocks filled so far; only the reader thread writes it
+    size_t tail;          // Blocks released so far; only the consumer writes it
+    int done;             // Set once the reader thread exits: 1 at the end of the input, -1 on failure
+    int stop;             // Asks the reader thread to exit
+    int waiters;          // Threads sleeping on changed or about to, counted under lock
+    pthread_mutex_t lock; // Only taken to sleep on an empty or full ring, or to wake a sleeper
+    pthread_cond_t changed;
+    pthread_t thread;
+};
+
+// Locks the ring and counts the caller as a sleeper before it checks whether it must wait
+static void begin_wait(ReadAhead *ra) {
+    pthread_mutex_lock(&ra->lock);
+    __atomic_add_fetch(&ra->waiters, 1, __ATOMIC_RELAXED);
+    // Pairs with the fence in notify: either the caller sees the new index or
+    // flag, or notify sees the caller and broadcasts under the lock
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Uncounts the caller and unlocks the ring
+static void end_wait(ReadAhead *ra) {
+    __atomic_sub_fetch(&ra->waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ra->lock);
+}
+
+// Wakes the other side after an index or flag changed; the lock is skipped when no one sleeps
+static void notify(ReadAhead *ra) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ra->waiters, __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&ra->lock);
+    pthread_cond_broadcast(&ra->changed);
+    pthread_mutex_unlock(&ra->lock);
+}
+
+// Reads a file descriptor, dropping O_DIRECT if the file system or a short read rules it out
+static ssize_t read_fd(void *context, char *buffer, size_t size) {
+    ReadAhead *ra = context;
+    for (;;) {
+        ssize_t bytes = read(ra->fd, buffer, size);
+        if (bytes >= 0) {
+            STATS_ADD(STATS_BYTES_READ, bytes);
+            return bytes;
+        }
+        int flags = fcntl(ra->fd, F_GETFL);
+        if (errno == EINVAL && flags >= 0 && (flags & O_DIRECT)) {
+            fcntl(ra->fd, F_SETFL, flags & ~O_DIRECT);
+            continue;
+        }
+        if (errno != EINTR) {
+            perror("Could not read input");
+            return -1;
+        }
+    }
+}
+
+// Body of the reader thread: fills free blocks in ring order until the input ends
+static void *readahead_thread(void *arg) {
+    ReadAhead *ra = arg;
+    int status = 1;
+    for (size_t head = 0;; head++) {
+        // Wait for the consumer to release the block filled num_blocks ago
+        if (head - __atomic_load_n(&ra->tail, __ATOMIC_ACQUIRE) == ra->num_blocks) {
+            begin_wait(ra);
+            while (head - __atomic_load_n(&ra->tail, __ATOMIC_ACQUIRE) == ra->num_blocks &&
+                   !__atomic_load_n(&ra->stop, __ATOMIC_ACQUIRE)) {
+                pthread_cond_wait(&ra->changed, &ra->lock);
+            }
+            end_wait(ra);
+        }
+        if (__atomic_load_n(&ra->stop, __ATOMIC_ACQUIRE)) break;
+
+        size_t slot = head % ra->num_blocks;
+        char *block = ra->blocks[slot];
+        size_t filled = 0;
+        int eof = 0;
+        STATS_TIMER_START(read_timer);
+        while (filled < ra->block_size) {
+            ssize_t bytes = ra->source(ra->context, block + filled, ra->block_size - filled);
+            if (bytes <= 0) {
+                status = bytes < 0 ? -1 : 1;
+                eof = 1;
+                break;
+            }
+            filled += (size_t)bytes;
+        }
+        STATS_TIMER_STOP(read_timer, STAGE_READ);
+
+        if (filled > 0 && status > 0) {
+            ra->lengths[slot] = filled;
+            __atomic_store_n(&ra->head, head + 1, __ATOMIC_RELEASE);
+            notify(ra);
+        }
+        if (eof) break;
+    }
+    __atomic_store_n(&ra->done, status, __ATOMIC_RELEASE);
+    notify(ra);
+    return NULL;
+}
+
+// Frees a ring whose thread is not running
+static void free_ring(ReadAhead *ra) {
+    if (ra->blocks) {
+        for (size_t i = 0; i < ra->num_blocks; i++) free(ra->blocks[i]);
+    }
+    free(ra->blocks);
+    free(ra->lengths);
+    if (ra->fd >= 0) close(ra->fd);
+    decompressor_close(ra->decompressor);
+    pthread_cond_destroy(&ra->changed);
+    pthread_mutex_destroy(&ra->lock);
+    free(ra);
+}
+
+// Allocates the ring and starts the reader thread; the ring takes over fd and decompressor
+static ReadAhead *start_ring(ReadAheadSource source, void *context, int fd, Decompressor *decompressor,
+                             const ReadAheadOptions *options) {
+    ReadAhead *ra = calloc(1, sizeof(ReadAhead));
+    if (ra == NULL) {
+        fprintf(stderr, "Memory allocation failed for read-ahead ring\n");
+        if (fd >= 0) close(fd);
+        decompressor_close(decompressor);
+        return NULL;
+    }
+    ra->source = source;
+    ra->context = fd >= 0 ? ra : context;
+    ra->fd = fd;
+    ra->decompressor = decompressor;
+    size_t block_size = options && options->block_size ? options->block_size : DEFAULT_BLOCK_SIZE;
+    ra->block_size = (block_size + READAHEAD_ALIGNMENT - 1) & ~(size_t)(READAHEAD_ALIGNMENT - 1);
+    ra->num_blocks = options && options->num_blocks ? options->num_blocks : DEFAULT_NUM_BLOCKS;
+    if (ra->num_blocks < 2) ra->num_blocks = 2;
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->changed, NULL);
+
+    ra->blocks = calloc(ra->num_blocks, sizeof(char *));
+    ra->lengths = calloc(ra->num_blocks, sizeof(size_t));
+    int failed = ra->blocks == NULL || ra->lengths == NULL;
+    for (size_t i = 0; !failed && i < ra->num_blocks; i++) {
+        void *block = NULL;
+        failed = posix_memalign(&block, READAHEAD_ALIGNMENT, ra->block_size) != 0;
+        ra->blocks[i] = block;
+    }
+    if (failed) {
+        fprintf(stderr, "Memory allocation failed for %zu read-ahead blocks of %zu bytes\n", ra->num_blocks, ra->block_size);
+        free_ring(ra);
+        return NULL;
+    }
+    if (pthread_create(&ra->thread, NULL, readahead_thread, ra) != 0) {
+        fprintf(stderr, "Could not start the read-ahead thread\n");
+        free_ring(ra);
+        return NULL;
+    }
+    return ra;
+}
+
+// Function to open a file and read it ahead
+ReadAhead *readahead_open(const char *filename, const ReadAheadOptions *options) {
+    if (filename == NULL) {
+        fprintf(stderr, "Filename is NULL\n");
+        return NULL;
+    }
+    Compression compression = compression_for_file(filename, options ? options->compression : COMPRESSION_AUTO);
+    if (compression != COMPRESSION_NONE) {
+        Decompressor *decompressor = decompressor_open(filename, compression);
+        if (decompressor == NULL) return NULL;
+        return start_ring(decompressor_read, decompressor, -1, decompressor, options);
+    }
+
+    int fd = -1;
+    if (options && options->direct_io) {
+        fd = open(filename, O_RDONLY | O_DIRECT);
+    }
+    if (fd < 0) {
+        fd = open(filename, O_RDONLY);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file '%s'\n", filename);
+        return NULL;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return start_ring(read_fd, NULL, fd, NULL, options);
+}
+
+// Function to read ahead from a custom source
+ReadAhead *readahead_start(ReadAheadSource source, void *context, const ReadAheadOptions *options) {
+    if (source == NULL) {
+        fprintf(stderr, "Read-ahead source is NULL\n");
+        return NULL;
+    }
+    return start_ring(source, context, -1, NULL, options);
+}
+
+// Function to wait for the next block
+int readahead_next(ReadAhead *ra, const char **data, size_t *length) {
+    size_t tail = ra->tail;
+    if (__atomic_load_n(&ra->head, __ATOMIC_ACQUIRE) == tail) {
+        begin_wait(ra);
+        while (__atomic_load_n(&ra->head, __ATOMIC_ACQUIRE) == tail && !__atomic_load_n(&ra->done, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&ra->changed, &ra->lock);
+        }
+        end_wait(ra);
+        // The last block is published before done is set
+        if (__atomic_load_n(&ra->head, __ATOMIC_ACQUIRE) == tail) {
+            return __atomic_load_n(&ra->done, __ATOMIC_ACQUIRE) < 0 ? -1 : 0;
+        }
+    }
+    size_t slot = tail % ra->num_blocks;
+    *data = ra->blocks[slot];
+    *length = ra->lengths[slot];
+    return 1;
+}
+
+// Function to hand a block back to the reader thread
+void readahead_release(ReadAhead *ra) {
+    if (ra->tail == __atomic_load_n(&ra->head, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&ra->tail, ra->tail + 1, __ATOMIC_RELEASE);
+    notify(ra);
+}
+
+// Function to stop reading ahead and free the ring
+void readahead_close(ReadAhead *ra) {
+    if (ra == NULL) return;
+    __atomic_store_n(&ra->stop, 1, __ATOMIC_RELEASE);
+    notify(ra);
+    pthread_join(ra->thread, NULL);
+    free_ring(ra);
+}
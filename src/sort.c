@@ -0,0 +1,378 @@
+#include "sort.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Bits of the key consumed by one radix pass
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+// Rows below which another thread does not pay for itself
+#define MIN_ROWS_PER_THREAD (64 * 1024)
+
+// Strings below which the multi-key quicksort switches to insertion sort
+#define INSERTION_THRESHOLD 16
+
+// Slice of the rows histogrammed and scattered by one thread in a radix pass
+typedef struct {
+    const uint32_t *keys;
+    const size_t *rows;
+    uint32_t *out_keys;
+    size_t *out_rows;
+    size_t start;                   // First position of the slice
+    size_t end;                     // One past the last position of the slice
+    unsigned shift;                 // Position of the digit in the key
+    size_t counts[RADIX_BUCKETS];   // Digit counts, then output positions
+} RadixTask;
+
+// String being sorted and its position in the current order
+typedef struct {
+    const char *text;
+    size_t position;
+} StringEntry;
+
+// Maps a float to a key whose unsigned order matches the float order, NaNs last
+static inline uint32_t float_key(float value, int descending) {
+    if (isnan(value)) {
+        return UINT32_MAX;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+    return descending ? ~bits : bits;
+}
+
+// Maps an int to a key whose unsigned order matches the int order
+static inline uint32_t int_key(int value, int descending) {
+    uint32_t bits = (uint32_t)value ^ 0x80000000u;
+    return descending ? ~bits : bits;
+}
+
+static void *run_histogram(void *arg) {
+    RadixTask *task = arg;
+    memset(task->counts, 0, sizeof(task->counts));
+    for (size_t i = task->start; i < task->end; i++) {
+        task->counts[(task->keys[i] >> task->shift) & (RADIX_BUCKETS - 1)]++;
+    }
+    return NULL;
+}
+
+static void *run_scatter(void *arg) {
+    RadixTask *task = arg;
+    for (size_t i = task->start; i < task->end; i++) {
+        uint32_t key = task->keys[i];
+        size_t position = task->counts[(key >> task->shift) & (RADIX_BUCKETS - 1)]++;
+        task->out_keys[position] = key;
+        task->out_rows[position] = task->rows[i];
+    }
+    return NULL;
+}
+
+// Runs fn over every task; the calling thread takes the first and tasks whose thread fails to start run inline
+static void run_tasks(void *(*fn)(void *), RadixTask *tasks, pthread_t *threads, size_t num_tasks) {
+    size_t started = 0;
+    for (size_t i = 1; i < num_tasks; i++, started++) {
+        if (pthread_create(&threads[i], NULL, fn, &tasks[i]) != 0) break;
+    }
+    fn(&tasks[0]);
+    for (size_t i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = started + 1; i < num_tasks; i++) {
+        fn(&tasks[i]);
+    }
+}
+
+// Stable LSD radix sort of rows by keys; both arrays are reordered in place
+static int radix_sort(uint32_t *keys, size_t *rows, size_t count, size_t num_threads) {
+    uint32_t *spare_keys = malloc(count * sizeof(uint32_t));
+    size_t *spare_rows = malloc(count * sizeof(size_t));
+    RadixTask *tasks = calloc(num_threads, sizeof(RadixTask));
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    if (spare_keys == NULL || spare_rows == NULL || tasks == NULL || threads == NULL) {
+        fprintf(stderr, "Memory allocation failed for radix sort of %zu rows\n", count);
+        free(spare_keys);
+        free(spare_rows);
+        free(tasks);
+        free(threads);
+        return -1;
+    }
+
+    uint32_t *in_keys = keys, *out_keys = spare_keys;
+    size_t *in_rows = rows, *out_rows = spare_rows;
+    for (unsigned shift = 0; shift < 32; shift += RADIX_BITS) {
+        for (size_t t = 0; t < num_threads; t++) {
+            tasks[t] = (RadixTask){in_keys, in_rows, out_keys, out_rows,
+                                   count * t / num_threads, count * (t + 1) / num_threads, shift, {0}};
+        }
+        run_tasks(run_histogram, tasks, threads, num_threads);
+
+        // Turn the counts into each slice's first output position per digit
+        size_t position = 0;
+        int uniform = 0;
+        for (size_t digit = 0; digit < RADIX_BUCKETS; digit++) {
+            size_t total = 0;
+            for (size_t t = 0; t < num_threads; t++) {
+                size_t digit_count = tasks[t].counts[digit];
+                tasks[t].counts[digit] = position + total;
+                total += digit_count;
+            }
+            if (total == count) uniform = 1;
+            position += total;
+        }
+        // A pass in which every key has the same digit would not move anything
+        if (uniform) continue;
+
+        run_tasks(run_scatter, tasks, threads, num_threads);
+        uint32_t *swap_keys = in_keys;
+        in_keys = out_keys;
+        out_keys = swap_keys;
+        size_t *swap_rows = in_rows;
+        in_rows = out_rows;
+        out_rows = swap_rows;
+    }
+    if (in_rows != rows) {
+        memcpy(rows, in_rows, count * sizeof(size_t));
+    }
+
+    free(spare_keys);
+    free(spare_rows);
+    free(tasks);
+    free(threads);
+    return 0;
+}
+
+// Character of an entry at a depth, remapped so that descending order is ascending and the end sorts last
+static inline int entry_char(const StringEntry *entry, size_t depth, int descending) {
+    int c = (unsigned char)entry->text[depth];
+    if (!descending) return c;
+    return c == 0 ? RADIX_BUCKETS : RADIX_BUCKETS - c;
+}
+
+static int compare_positions(const void *a, const void *b) {
+    size_t x = ((const StringEntry *)a)->position;
+    size_t y = ((const StringEntry *)b)->position;
+    return (x > y) - (x < y);
+}
+
+// Compares two entries that agree before depth, breaking ties by position
+static int compare_entries(const StringEntry *a, const StringEntry *b, size_t depth, int descending) {
+    int end = descending ? RADIX_BUCKETS : 0;
+    for (size_t d = depth;; d++) {
+        int x = entry_char(a, d, descending);
+        int y = entry_char(b, d, descending);
+        if (x != y) return x < y ? -1 : 1;
+        if (x == end) break;
+    }
+    return (a->position > b->position) - (a->position < b->position);
+}
+
+static inline void swap_entries(StringEntry *a, StringEntry *b) {
+    StringEntry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Multi-key quicksort of entries that agree before depth; equal strings keep their position order
+static void string_quicksort(StringEntry *entries, size_t count, size_t depth, int descending) {
+    int end = descending ? RADIX_BUCKETS : 0;
+    while (count > 1) {
+        if (count < INSERTION_THRESHOLD) {
+            for (size_t i = 1; i < count; i++) {
+                for (size_t j = i; j > 0 && compare_entries(&entries[j - 1], &entries[j], depth, descending) > 0; j--) {
+                    swap_entries(&entries[j - 1], &entries[j]);
+                }
+            }
+            return;
+        }
+
+        // Median of three characters as the pivot
+        int a = entry_char(&entries[0], depth, descending);
+        int b = entry_char(&entries[count / 2], depth, descending);
+        int c = entry_char(&entries[count - 1], depth, descending);
+        int pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        // Three-way partition on the character at depth
+        size_t lt = 0, i = 0, gt = count;
+        while (i < gt) {
+            int ch = entry_char(&entries[i], depth, descending);
+            if (ch < pivot) {
+                swap_entries(&entries[lt++], &entries[i++]);
+            } else if (ch > pivot) {
+                swap_entries(&entries[i], &entries[--gt]);
+            } else {
+                i++;
+            }
+        }
+        string_quicksort(entries, lt, depth, descending);
+        string_quicksort(entries + gt, count - gt, depth, descending);
+
+        entries += lt;
+        count = gt - lt;
+        if (pivot == end) {
+            // Whole strings are equal; restore their earlier order
+            qsort(entries, count, sizeof(StringEntry), compare_positions);
+            return;
+        }
+        depth++;
+    }
+}
+
+// Stably sorts order by a STRING column, NULLs last
+static int sort_strings(const Column *column, size_t *order, size_t count, int descending) {
+    StringEntry *entries = malloc(count * sizeof(StringEntry));
+    size_t *previous = malloc(count * sizeof(size_t));
+    if (entries == NULL || previous == NULL) {
+        fprintf(stderr, "Memory allocation failed for string sort of %zu rows\n", count);
+        free(entries);
+        free(previous);
+        return -1;
+    }
+    memcpy(previous, order, count * sizeof(size_t));
+
+    size_t num_entries = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *text = column_string(column, previous[i]);
+        if (text != NULL) {
+            entries[num_entries].text = text;
+            entries[num_entries].position = i;
+            num_entries++;
+        }
+    }
+    string_quicksort(entries, num_entries, 0, descending);
+
+    size_t out = 0;
+    for (; out < num_entries; out++) {
+        order[out] = previous[entries[out].position];
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (column_string(column, previous[i]) == NULL) {
+            order[out++] = previous[i];
+        }
+    }
+    free(entries);
+    free(previous);
+    return 0;
+}
+
+// Ranks the categories of a CATEGORICAL column by their value
+static uint32_t *rank_categories(const Column *column) {
+    size_t num_categories = column->data.categorical_data.num_categories;
+    StringEntry *entries = malloc((num_categories ? num_categories : 1) * sizeof(StringEntry));
+    uint32_t *ranks = malloc((num_categories ? num_categories : 1) * sizeof(uint32_t));
+    if (entries == NULL || ranks == NULL) {
+        fprintf(stderr, "Memory allocation failed for %zu category ranks\n", num_categories);
+        free(entries);
+        free(ranks);
+        return NULL;
+    }
+    for (size_t code = 0; code < num_categories; code++) {
+        entries[code].text = category_string(column, (int)code);
+        entries[code].position = code;
+    }
+    string_quicksort(entries, num_categories, 0, 0);
+    for (size_t rank = 0; rank < num_categories; rank++) {
+        ranks[entries[rank].position] = (uint32_t)rank;
+    }
+    free(entries);
+    return ranks;
+}
+
+// Stably sorts order by an INT, FLOAT or CATEGORICAL column through radix keys
+static int sort_radix(const Column *column, size_t *order, size_t count, int descending, size_t num_threads) {
+    uint32_t *keys = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (keys == NULL) {
+        fprintf(stderr, "Memory allocation failed for %zu sort keys\n", count);
+        return -1;
+    }
+    switch (column->type) {
+        case DATA_TYPE_INT:
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = int_key(column_int(column, order[i]), descending);
+            }
+            break;
+        case DATA_TYPE_FLOAT:
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = float_key(column->data.float_data[order[i]], descending);
+            }
+            break;
+        default: {
+            uint32_t *ranks = rank_categories(column);
+            if (ranks == NULL) {
+                free(keys);
+                return -1;
+            }
+            // Small keys leave the high digits uniform, so their passes are skipped
+            uint32_t last = (uint32_t)column->data.categorical_data.num_categories - 1;
+            const int *codes = column->data.categorical_data.codes;
+            for (size_t i = 0; i < count; i++) {
+                int code = codes[order[i]];
+                keys[i] = code < 0 ? UINT32_MAX : descending ? last - ranks[code] : ranks[code];
+            }
+            free(ranks);
+            break;
+        }
+    }
+    int status = radix_sort(keys, order, count, num_threads);
+    free(keys);
+    return status;
+}
+
+// Function to compute the permutation that sorts a dataframe by the given keys
+size_t *argsort(const DataFrame *df, const SortKey *keys, size_t num_keys, size_t num_threads) {
+    if (df == NULL || keys == NULL || num_keys == 0) {
+        fprintf(stderr, "Invalid sort arguments\n");
+        return NULL;
+    }
+    for (size_t k = 0; k < num_keys; k++) {
+        if (keys[k].column >= df->num_columns) {
+            fprintf(stderr, "Sort column index %zu out of bounds\n", keys[k].column);
+            return NULL;
+        }
+    }
+
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    size_t max_threads = df->num_rows / MIN_ROWS_PER_THREAD;
+    if (num_threads > max_threads) num_threads = max_threads;
+    if (num_threads == 0) num_threads = 1;
+
+    size_t count = df->num_rows;
+    size_t *order = malloc((count ? count : 1) * sizeof(size_t));
+    if (order == NULL) {
+        fprintf(stderr, "Memory allocation failed for permutation of %zu rows\n", count);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+
+    // Each stable pass keeps the order of the less significant keys among equal values
+    for (size_t k = num_keys; k-- > 0;) {
+        const Column *column = &df->columns[keys[k].column];
+        int status = column->type == DATA_TYPE_STRING
+                         ? sort_strings(column, order, count, keys[k].descending)
+                         : sort_radix(column, order, count, keys[k].descending, num_threads);
+        if (status != 0) {
+            free(order);
+            return NULL;
+        }
+    }
+    return order;
+}
+
+// Function to create a copy of a dataframe sorted by the given keys
+DataFrame *sort_by(const DataFrame *df, const SortKey *keys, size_t num_keys, size_t num_threads) {
+    size_t *order = argsort(df, keys, num_keys, num_threads);
+    if (order == NULL) {
+        return NULL;
+    }
+    DataFrame *sorted = take_rows(df, order, df->num_rows);
+    free(order);
+    return sorted;
+}
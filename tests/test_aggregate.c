@@ -0,0 +1,162 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "aggregate.h"
+
+/**
+ * Test the statistics of an INT column, including sums that overflow 32 bits
+ * and tails that do not fill a SIMD register.
+ */
+void test_int_stats(void) {
+    size_t num_rows = 1003;
+    DataFrame *df = create_dataframe(num_rows, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "Value"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+
+    double expected_sum = 0.0;
+    for (size_t i = 0; i < num_rows; i++) {
+        int value = i % 2 ? INT_MAX - (int)i : (int)i;
+        if (i == 1001) value = INT_MIN;
+        set_value(df, i, 0, &value);
+        expected_sum += value;
+        if (i % 4 == 0) set_value(df, i, 1, "x");
+    }
+
+    ColumnStats stats;
+    CU_ASSERT_EQUAL(column_stats(df, 0, 1, &stats), 0);
+    CU_ASSERT_EQUAL(stats.count, num_rows);
+    CU_ASSERT_DOUBLE_EQUAL(stats.sum, expected_sum, 0.5);
+    CU_ASSERT_DOUBLE_EQUAL(stats.mean, expected_sum / num_rows, 1e-6);
+    CU_ASSERT_EQUAL(stats.min, (double)INT_MIN);
+    CU_ASSERT_EQUAL(stats.max, (double)(INT_MAX - 1));
+
+    double expected_m2 = 0.0;
+    for (size_t i = 0; i < num_rows; i++) {
+        double deviation = df->columns[0].data.int_data[i] - expected_sum / num_rows;
+        expected_m2 += deviation * deviation;
+    }
+    double variance;
+    CU_ASSERT_EQUAL(column_variance(df, 0, &variance), 0);
+    CU_ASSERT_DOUBLE_EQUAL(variance / (expected_m2 / (num_rows - 1)), 1.0, 1e-12);
+
+    size_t count;
+    CU_ASSERT_EQUAL(column_count(df, 1, &count), 0);
+    CU_ASSERT_EQUAL(count, (num_rows + 3) / 4);
+    double sum;
+    CU_ASSERT_EQUAL(column_sum(df, 1, &sum), -1);
+
+    destroy_dataframe(df);
+}
+
+/**
+ * Test that float sums stay accurate where naive float accumulation drifts,
+ * and that NaNs propagate into the sum but are skipped by min and max.
+ */
+void test_float_stats(void) {
+    size_t num_rows = 1000003;
+    DataFrame *df = create_dataframe(num_rows, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 0, "Value"), 0);
+
+    float value = 0.1f;
+    CU_ASSERT_EQUAL(fill_values(df, 0, 0, num_rows, &value), 0);
+    float big = 1e7f;
+    set_value(df, 17, 0, &big);
+
+    double sum, min, max, mean;
+    CU_ASSERT_EQUAL(column_sum(df, 0, &sum), 0);
+    CU_ASSERT_DOUBLE_EQUAL(sum, (double)0.1f * (num_rows - 1) + 1e7, 1e-6);
+    CU_ASSERT_EQUAL(column_min(df, 0, &min), 0);
+    CU_ASSERT_EQUAL(min, (double)0.1f);
+    CU_ASSERT_EQUAL(column_max(df, 0, &max), 0);
+    CU_ASSERT_EQUAL(max, 1e7);
+
+    float nan = NAN;
+    set_value(df, 100, 0, &nan);
+    CU_ASSERT_EQUAL(column_mean(df, 0, &mean), 0);
+    CU_ASSERT(isnan(mean));
+    CU_ASSERT_EQUAL(column_max(df, 0, &max), 0);
+    CU_ASSERT_EQUAL(max, 1e7);
+
+    destroy_dataframe(df);
+
+    // Empty columns have no mean, min or max
+    df = create_dataframe(0, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 0, "Value"), 0);
+    ColumnStats stats;
+    CU_ASSERT_EQUAL(column_stats(df, 0, 0, &stats), 0);
+    CU_ASSERT_EQUAL(stats.count, 0);
+    CU_ASSERT_EQUAL(stats.sum, 0.0);
+    CU_ASSERT(isnan(stats.mean) && isnan(stats.min) && isnan(stats.max) && isnan(stats.variance));
+    destroy_dataframe(df);
+}
+
+/**
+ * Test that splitting a column across threads gives the same statistics as a
+ * single pass.
+ */
+void test_parallel_stats(void) {
+    size_t num_rows = 2000000;
+    DataFrame *df = create_dataframe(num_rows, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "Count"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Value"), 0);
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < num_rows; i++) {
+        seed = seed * 1103515245u + 12345u;
+        df->columns[0].data.int_data[i] = (int)(seed >> 8) - (1 << 23);
+        df->columns[1].data.float_data[i] = 1000.0f + (float)(seed >> 16) / 65536.0f;
+    }
+
+    for (size_t column = 0; column < 2; column++) {
+        ColumnStats serial, parallel;
+        CU_ASSERT_EQUAL(column_stats(df, column, 1, &serial), 0);
+        CU_ASSERT_EQUAL(column_stats(df, column, 4, &parallel), 0);
+        CU_ASSERT_EQUAL(parallel.count, num_rows);
+        CU_ASSERT_DOUBLE_EQUAL(parallel.sum, serial.sum, fabs(serial.sum) * 1e-12);
+        CU_ASSERT_EQUAL(parallel.min, serial.min);
+        CU_ASSERT_EQUAL(parallel.max, serial.max);
+        CU_ASSERT_DOUBLE_EQUAL(parallel.variance / serial.variance, 1.0, 1e-9);
+    }
+
+    destroy_dataframe(df);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Aggregate Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_int_stats", test_int_stats) == NULL) ||
+        (CU_add_test(suite, "test_float_stats", test_float_stats) == NULL) ||
+        (CU_add_test(suite, "test_parallel_stats", test_parallel_stats) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
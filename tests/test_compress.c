@@ -0,0 +1,250 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compress.h"
+#include "dataframe.h"
+#include "dfio.h"
+
+#define NUM_ROWS 5000
+#define TEXT_SIZE 300000
+
+// Fills text with lines that compress well but not trivially
+static void fill_text(char *text, size_t size) {
+    unsigned state = 11;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1103515245u + 12345u;
+        text[i] = i % 64 == 63 ? '\n' : (char)('a' + (state >> 16) % 8);
+    }
+}
+
+// Compresses text into filename in uneven pieces
+static int compress_file(const char *filename, Compression compression, const char *text, size_t size) {
+    Compressor *compressor = compressor_open(filename, compression, 0);
+    if (compressor == NULL) return -1;
+    int status = 0;
+    for (size_t offset = 0; offset < size && status == 0; offset += 7777) {
+        size_t chunk = size - offset < 7777 ? size - offset : 7777;
+        status = compressor_write(compressor, text + offset, chunk);
+    }
+    return compressor_close(compressor) != 0 ? -1 : status;
+}
+
+// Decompresses filename and checks that it holds exactly the given bytes
+static int decompresses_to(const char *filename, Compression compression, const char *text, size_t size) {
+    Decompressor *decompressor = decompressor_open(filename, compression);
+    if (decompressor == NULL) return 0;
+    char buffer[5000];
+    size_t offset = 0;
+    int ok = 1;
+    ssize_t bytes;
+    while ((bytes = decompressor_read(decompressor, buffer, sizeof(buffer))) > 0) {
+        ok &= offset + (size_t)bytes <= size && memcmp(buffer, text + offset, (size_t)bytes) == 0;
+        offset += (size_t)bytes;
+    }
+    decompressor_close(decompressor);
+    return ok && bytes == 0 && offset == size;
+}
+
+// Size of a file in bytes
+static long file_size(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+/**
+ * Test that compressions are picked from file names, that gzip round-trips
+ * and accepts concatenated members, and that damaged input is reported.
+ */
+void test_gzip_stream(void) {
+    CU_ASSERT_EQUAL(compression_for_file("feed.csv.gz", COMPRESSION_AUTO), COMPRESSION_GZIP);
+    CU_ASSERT_EQUAL(compression_for_file("feed.csv.zst", COMPRESSION_AUTO), COMPRESSION_ZSTD);
+    CU_ASSERT_EQUAL(compression_for_file("feed.csv", COMPRESSION_AUTO), COMPRESSION_NONE);
+    CU_ASSERT_EQUAL(compression_for_file("gz", COMPRESSION_AUTO), COMPRESSION_NONE);
+    CU_ASSERT_EQUAL(compression_for_file("feed.csv.gz", COMPRESSION_NONE), COMPRESSION_NONE);
+    CU_ASSERT_EQUAL(compression_for_file("feed.csv", COMPRESSION_GZIP), COMPRESSION_GZIP);
+
+    static char text[TEXT_SIZE * 2];
+    fill_text(text, TEXT_SIZE);
+    memcpy(text + TEXT_SIZE, text, TEXT_SIZE);
+    const char *filename = "test_gzip_stream.gz";
+    CU_ASSERT_EQUAL_FATAL(compress_file(filename, COMPRESSION_GZIP, text, TEXT_SIZE), 0);
+    long size = file_size(filename);
+    CU_ASSERT(size > 0 && size < TEXT_SIZE / 2);
+    CU_ASSERT(decompresses_to(filename, COMPRESSION_GZIP, text, TEXT_SIZE));
+
+    // A second member appended to the file is read after the first
+    FILE *file = fopen(filename, "rb");
+    char *member = malloc((size_t)size);
+    CU_ASSERT_EQUAL(fread(member, 1, (size_t)size, file), (size_t)size);
+    fclose(file);
+    file = fopen(filename, "ab");
+    fwrite(member, 1, (size_t)size, file);
+    fclose(file);
+    CU_ASSERT(decompresses_to(filename, COMPRESSION_GZIP, text, TEXT_SIZE * 2));
+
+    // Truncated and corrupt input fail instead of ending early
+    file = fopen(filename, "wb");
+    fwrite(member, 1, (size_t)size / 2, file);
+    fclose(file);
+    CU_ASSERT_FALSE(decompresses_to(filename, COMPRESSION_GZIP, text, TEXT_SIZE / 2));
+    member[size / 2] ^= 0x55;
+    member[size / 2 + 1] ^= 0x55;
+    file = fopen(filename, "wb");
+    fwrite(member, 1, (size_t)size, file);
+    fclose(file);
+    CU_ASSERT_FALSE(decompresses_to(filename, COMPRESSION_GZIP, text, TEXT_SIZE));
+    free(member);
+
+    CU_ASSERT_PTR_NULL(compressor_open(filename, COMPRESSION_GZIP, 42));
+    CU_ASSERT_PTR_NULL(decompressor_open("does_not_exist.gz", COMPRESSION_GZIP));
+    CU_ASSERT_PTR_NULL(decompressor_open(filename, COMPRESSION_NONE));
+    remove(filename);
+
+#ifdef DF_HAVE_ZSTD
+    filename = "test_gzip_stream.zst";
+    CU_ASSERT_EQUAL(compress_file(filename, COMPRESSION_ZSTD, text, TEXT_SIZE), 0);
+    CU_ASSERT(decompresses_to(filename, COMPRESSION_ZSTD, text, TEXT_SIZE));
+    remove(filename);
+#else
+    CU_ASSERT_PTR_NULL(compressor_open("test_gzip_stream.zst", COMPRESSION_ZSTD, 0));
+#endif
+}
+
+// Builds a frame whose names contain quotes, commas and line breaks
+static DataFrame *sample_frame(void) {
+    DataFrame *df = create_dataframe(NUM_ROWS, 3);
+    add_column(df, DATA_TYPE_INT, 0, "ID");
+    add_column(df, DATA_TYPE_FLOAT, 1, "Value");
+    add_column(df, DATA_TYPE_STRING, 2, "Name");
+    char name[64];
+    for (int i = 0; i < NUM_ROWS; i++) {
+        float value = (float)i / 4;
+        snprintf(name, sizeof(name), i % 50 == 0 ? "say \"hi\", %d\nbye" : "name_%d", i);
+        set_value(df, (size_t)i, 0, &i);
+        set_value(df, (size_t)i, 1, &value);
+        set_string_value(df, (size_t)i, 2, name, strlen(name));
+    }
+    return df;
+}
+
+// Whether a frame read back holds the sample rows
+static int matches_sample(const DataFrame *df, const DataFrame *sample) {
+    if (df == NULL || df->num_rows != sample->num_rows) return 0;
+    for (size_t row = 0; row < df->num_rows; row++) {
+        int id;
+        float value;
+        char *name, *expected;
+        get_value(df, row, 0, &id);
+        get_value(df, row, 1, &value);
+        get_value(df, row, 2, &name);
+        get_value(sample, row, 2, &expected);
+        if (id != (int)row || value != (float)row / 4 || strcmp(name, expected) != 0) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Test that CSV files named .gz are written compressed and read back by every
+ * reader, and that compression can be chosen by option regardless of the name.
+ */
+void test_compressed_csv(void) {
+    const char *filename = "test_compressed_csv.csv.gz";
+    DataType types[3] = {DATA_TYPE_INT, DATA_TYPE_FLOAT, DATA_TYPE_STRING};
+    DataFrame *sample = sample_frame();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sample);
+
+    save_to_csv(sample, filename);
+    FILE *file = fopen(filename, "rb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    CU_ASSERT_EQUAL(fgetc(file), 0x1f);
+    CU_ASSERT_EQUAL(fgetc(file), 0x8b);
+    fclose(file);
+
+    DataFrame *df = read_csv(filename, types, 3);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    df = read_csv_mmap(filename, types, 3);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    df = read_csv_parallel(filename, types, 3, 2);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    CsvReadOptions all = {NULL, NULL};
+    df = read_csv_with_options(filename, types, 3, &all);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    const char *columns[1] = {"ID"};
+    CsvReadOptions projected = {columns, NULL};
+    CU_ASSERT_PTR_NULL(read_csv_with_options(filename, types, 1, &projected));
+
+    CsvReader *reader = csv_reader_open(filename, types, 3, 1000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    DataFrame *batch;
+    size_t rows = 0;
+    while (csv_reader_next_batch(reader, &batch) == 1) rows += batch->num_rows;
+    CU_ASSERT_EQUAL(rows, NUM_ROWS);
+    csv_reader_close(reader);
+    remove(filename);
+
+    // Options override the file name on both sides
+    filename = "test_compressed_csv.data";
+    CsvWriteOptions write_options = {2, COMPRESSION_GZIP, 9};
+    CU_ASSERT_EQUAL(save_to_csv_with_options(sample, filename, &write_options), 0);
+    ReadAheadOptions read_options = {8192, 2, 0, COMPRESSION_GZIP};
+    df = read_csv_pipelined(filename, types, 3, &read_options);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    CU_ASSERT_PTR_NULL(read_csv_pipelined(filename, types, 3, NULL));
+    remove(filename);
+
+    filename = "test_compressed_csv.csv.gz";
+    write_options.compression = COMPRESSION_NONE;
+    CU_ASSERT_EQUAL(save_to_csv_with_options(sample, filename, &write_options), 0);
+    read_options.compression = COMPRESSION_NONE;
+    df = read_csv_pipelined(filename, types, 3, &read_options);
+    CU_ASSERT(matches_sample(df, sample));
+    destroy_dataframe(df);
+    remove(filename);
+
+#ifndef DF_HAVE_ZSTD
+    write_options.compression = COMPRESSION_ZSTD;
+    CU_ASSERT_EQUAL(save_to_csv_with_options(sample, "test_compressed_csv.csv.zst", &write_options), -1);
+#endif
+    destroy_dataframe(sample);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Compression Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_gzip_stream", test_gzip_stream) == NULL) ||
+        (CU_add_test(suite, "test_compressed_csv", test_compressed_csv) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
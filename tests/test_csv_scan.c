@@ -0,0 +1,102 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "csv_scan.h"
+
+/**
+ * Test that fields are split on unquoted separators only, including quoted
+ * separators that straddle the 64-byte classification blocks.
+ */
+void test_scan_quoted_fields(void) {
+    char buffer[256];
+    // Pad so the quoted field crosses the first block boundary
+    snprintf(buffer, sizeof(buffer), "%060d,\"a,b\nc\"\"d\" , plain \r\nlast,", 1);
+
+    CsvScanner scanner;
+    CU_ASSERT_EQUAL_FATAL(csv_scanner_init(&scanner, buffer, buffer + strlen(buffer)), 0);
+
+    CsvField fields[4];
+    size_t count = 0;
+    char value[64];
+
+    CU_ASSERT_EQUAL(csv_scanner_next_record(&scanner, fields, 4, &count), 1);
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(fields[0].length, 60);
+    CU_ASSERT(fields[1].quoted && fields[1].escaped);
+    csv_copy_field(&fields[1], value);
+    CU_ASSERT_STRING_EQUAL(value, "a,b\nc\"d");
+    csv_copy_field(&fields[2], value);
+    CU_ASSERT_STRING_EQUAL(value, "plain");
+
+    // Trailing delimiter without a newline yields a final empty field
+    CU_ASSERT_EQUAL(csv_scanner_next_record(&scanner, fields, 4, &count), 1);
+    CU_ASSERT_EQUAL(count, 2);
+    CU_ASSERT_EQUAL(fields[1].length, 0);
+
+    CU_ASSERT_EQUAL(csv_scanner_next_record(&scanner, fields, 4, &count), 0);
+    csv_scanner_free(&scanner);
+}
+
+/**
+ * Test that records spanning several index windows are reassembled.
+ */
+void test_scan_large_buffer(void) {
+    size_t num_records = 20000;
+    size_t size = num_records * 16 + 1;
+    char *buffer = malloc(size);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(buffer);
+    size_t length = 0;
+    for (size_t i = 0; i < num_records; i++) {
+        length += snprintf(buffer + length, size - length, "%05zu,\"x\n,y\"\n", i);
+    }
+
+    CsvScanner scanner;
+    CU_ASSERT_EQUAL_FATAL(csv_scanner_init(&scanner, buffer, buffer + length), 0);
+    printf("CSV scanner implementation: %s\n", csv_scan_implementation());
+
+    CsvField fields[2];
+    size_t count = 0;
+    size_t records = 0;
+    int ok = 1;
+    while (csv_scanner_next_record(&scanner, fields, 2, &count)) {
+        ok &= count == 2 && fields[1].length == 4 && (size_t)atoi(fields[0].start) == records;
+        records++;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(records, num_records);
+
+    csv_scanner_free(&scanner);
+    free(buffer);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("CSV Scan Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_scan_quoted_fields", test_scan_quoted_fields) == NULL) ||
+        (CU_add_test(suite, "test_scan_large_buffer", test_scan_large_buffer) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -93,6 +93,382 @@ void test_big_dataframe(void) {
     destroy_dataframe(df);
 }
 
+// Test string columns stored in one contiguous buffer
+void test_string_column(void) {
+    DataFrame *df = create_dataframe(3, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 0, "Name"), 0);
+
+    // Unset entries read back as NULL
+    char *value = "unset";
+    CU_ASSERT_EQUAL(get_value(df, 0, 0, &value), 0);
+    CU_ASSERT_PTR_NULL(value);
+
+    CU_ASSERT_EQUAL(set_value(df, 0, 0, "Alice"), 0);
+    CU_ASSERT_EQUAL(set_string_value(df, 1, 0, "Bobcat", 3), 0);
+    CU_ASSERT_EQUAL(get_value(df, 0, 0, &value), 0);
+    CU_ASSERT_STRING_EQUAL(value, "Alice");
+    CU_ASSERT_EQUAL(get_value(df, 1, 0, &value), 0);
+    CU_ASSERT_STRING_EQUAL(value, "Bob");
+
+    // Strings share one buffer
+    CU_ASSERT_PTR_EQUAL(column_string(&df->columns[0], 0), df->columns[0].data.string_data.bytes);
+
+    // Copying a string within the column survives the buffer growing
+    for (int i = 0; i < 100; i++) {
+        CU_ASSERT_EQUAL(get_value(df, i % 2, 0, &value), 0);
+        CU_ASSERT_EQUAL(set_value(df, 2, 0, value), 0);
+    }
+    CU_ASSERT_EQUAL(get_value(df, 2, 0, &value), 0);
+    CU_ASSERT_STRING_EQUAL(value, "Bob");
+
+    destroy_dataframe(df);
+}
+
+// Test dictionary encoding of categorical columns
+void test_categorical_column(void) {
+    const char *values[] = {"US", "DE", "US", "FR", "DE", "US"};
+    DataFrame *df = create_dataframe(7, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 0, "Country"), 0);
+
+    for (size_t row = 0; row < 6; row++) {
+        CU_ASSERT_EQUAL(set_value(df, row, 0, values[row]), 0);
+    }
+
+    // Repeated values share one dictionary entry
+    const CategoricalData *categorical = &df->columns[0].data.categorical_data;
+    CU_ASSERT_EQUAL(categorical->num_categories, 3);
+    CU_ASSERT_EQUAL(categorical->codes[0], categorical->codes[2]);
+    CU_ASSERT_EQUAL(categorical->codes[1], categorical->codes[4]);
+    CU_ASSERT_EQUAL(find_category(&df->columns[0], "FR", 2), categorical->codes[3]);
+    CU_ASSERT_EQUAL(find_category(&df->columns[0], "IT", 2), -1);
+
+    char *value;
+    CU_ASSERT_EQUAL(get_value(df, 5, 0, &value), 0);
+    CU_ASSERT_STRING_EQUAL(value, "US");
+    CU_ASSERT_EQUAL(get_value(df, 6, 0, &value), 0);
+    CU_ASSERT_PTR_NULL(value);
+
+    // Many distinct values force the hash table to grow
+    char name[32];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "value%d", i);
+        CU_ASSERT_EQUAL(intern_category(&df->columns[0], name, strlen(name)), i + 3);
+    }
+    CU_ASSERT_EQUAL(find_category(&df->columns[0], "value500", 8), 503);
+    CU_ASSERT_STRING_EQUAL(category_string(&df->columns[0], 503), "value500");
+
+    destroy_dataframe(df);
+
+    // Writing to a borrowed column with no categories copies it and grows the dictionary
+    int codes[4] = {-1, -1, -1, -1};
+    ColumnData data;
+    memset(&data, 0, sizeof(data));
+    data.categorical_data.codes = codes;
+    df = create_dataframe(4, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(attach_column(df, DATA_TYPE_CATEGORICAL, 0, "Empty", &data), 0);
+    for (size_t row = 0; row < 4; row++) {
+        snprintf(name, sizeof(name), "new%zu", row);
+        CU_ASSERT_EQUAL(set_value(df, row, 0, name), 0);
+    }
+    CU_ASSERT_EQUAL(df->columns[0].data.categorical_data.num_categories, 4);
+    CU_ASSERT_EQUAL(get_value(df, 3, 0, &value), 0);
+    CU_ASSERT_STRING_EQUAL(value, "new3");
+    CU_ASSERT_EQUAL(codes[3], -1);
+    destroy_dataframe(df);
+}
+
+// Test bulk spans, range setters and range copies
+void test_bulk_access(void) {
+    size_t num_rows = 1000;
+    DataFrame *df = create_dataframe(num_rows, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "Id"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Price"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 2, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 3, "Side"), 0);
+
+    int *ids = malloc(num_rows * sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ids);
+    for (size_t i = 0; i < num_rows; i++) ids[i] = (int)i;
+    CU_ASSERT_EQUAL(set_values(df, 0, 0, num_rows, ids), 0);
+    free(ids);
+
+    float price = 2.5f;
+    CU_ASSERT_EQUAL(fill_values(df, 1, 0, num_rows, &price), 0);
+    CU_ASSERT_EQUAL(fill_values(df, 2, 0, num_rows, "same"), 0);
+    const char *sides[] = {"buy", "sell", NULL, "buy"};
+    CU_ASSERT_EQUAL(set_values(df, 3, 0, 4, sides), 0);
+
+    const int *id_span;
+    const float *price_span;
+    const int *codes;
+    size_t length = 0;
+    CU_ASSERT_EQUAL(get_int_span(df, 0, &id_span, &length), 0);
+    CU_ASSERT_EQUAL(length, num_rows);
+    CU_ASSERT_EQUAL(id_span[999], 999);
+    CU_ASSERT_EQUAL(get_float_span(df, 1, &price_span, &length), 0);
+    CU_ASSERT_DOUBLE_EQUAL(price_span[500], 2.5, 0.0001);
+    CU_ASSERT_EQUAL(get_category_codes(df, 3, &codes, &length), 0);
+    CU_ASSERT_EQUAL(codes[0], codes[3]);
+    CU_ASSERT_EQUAL(codes[2], -1);
+
+    // Spans are typed
+    CU_ASSERT_EQUAL(get_int_span(df, 1, &id_span, &length), -1);
+
+    // Filled strings share one copy
+    CU_ASSERT_EQUAL(df->columns[2].data.string_data.size, strlen("same") + 1);
+
+    // Copy rows within a frame and across frames
+    CU_ASSERT_EQUAL(copy_values(df, 0, 0, df, 0, 500, 10), 0);
+    CU_ASSERT_EQUAL(id_span[9], 509);
+    DataFrame *other = create_dataframe(4, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(other);
+    CU_ASSERT_EQUAL(add_column(other, DATA_TYPE_CATEGORICAL, 0, "Side"), 0);
+    CU_ASSERT_EQUAL(copy_values(other, 0, 0, df, 3, 0, 4), 0);
+    char *side;
+    CU_ASSERT_EQUAL(get_value(other, 1, 0, &side), 0);
+    CU_ASSERT_STRING_EQUAL(side, "sell");
+    CU_ASSERT_EQUAL(copy_values(other, 0, 0, df, 3, 998, 4), -1);
+
+    destroy_dataframe(other);
+    destroy_dataframe(df);
+}
+
+// Test gathering rows into a new dataframe, including NULL rows
+void test_take_rows(void) {
+    DataFrame *df = create_dataframe(5, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 2, "Side"), 0);
+    const char *names[5] = {"a", "b", NULL, "d", "e"};
+    const char *sides[5] = {"buy", "sell", "buy", NULL, "hold"};
+    int ids[5] = {10, 11, 12, 13, 14};
+    CU_ASSERT_EQUAL(set_values(df, 0, 0, 5, ids), 0);
+    CU_ASSERT_EQUAL(set_values(df, 1, 0, 5, names), 0);
+    CU_ASSERT_EQUAL(set_values(df, 2, 0, 5, sides), 0);
+
+    size_t rows[4] = {4, GATHER_NULL_ROW, 1, 4};
+    DataFrame *taken = take_rows(df, rows, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(taken);
+    CU_ASSERT_EQUAL(taken->num_rows, 4);
+    int id;
+    char *text;
+    get_value(taken, 0, 0, &id);
+    CU_ASSERT_EQUAL(id, 14);
+    get_value(taken, 1, 0, &id);
+    CU_ASSERT_EQUAL(id, 0);
+    get_value(taken, 1, 1, &text);
+    CU_ASSERT_PTR_NULL(text);
+    get_value(taken, 2, 1, &text);
+    CU_ASSERT_STRING_EQUAL(text, "b");
+    get_value(taken, 3, 2, &text);
+    CU_ASSERT_STRING_EQUAL(text, "hold");
+    // Only the gathered categories are copied
+    CU_ASSERT_EQUAL(taken->columns[2].data.categorical_data.num_categories, 2);
+
+    rows[0] = 5;
+    CU_ASSERT_PTR_NULL(take_rows(df, rows, 4));
+    CU_ASSERT_EQUAL(gather_values(df, 0, df, 0, rows + 2, 1), -1);
+
+    destroy_dataframe(taken);
+    destroy_dataframe(df);
+}
+
+// Test appending rows one at a time and in batches to a growable dataframe
+void test_append_rows(void) {
+    DataFrame *df = create_dataframe(0, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 2, "Side"), 0);
+
+    // Count the reallocations of the ID column over many appends
+    size_t reallocations = 0;
+    size_t capacity = df->capacity;
+    char name[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "n%d", i);
+        const void *values[3] = {&i, name, i % 2 ? "buy" : NULL};
+        CU_ASSERT_EQUAL_FATAL(append_row(df, values), 0);
+        if (df->capacity != capacity) {
+            reallocations++;
+            capacity = df->capacity;
+        }
+    }
+    CU_ASSERT_EQUAL(df->num_rows, 1000);
+    CU_ASSERT(reallocations <= 8);
+    int id;
+    char *text;
+    get_value(df, 999, 0, &id);
+    get_value(df, 999, 1, &text);
+    CU_ASSERT_EQUAL(id, 999);
+    CU_ASSERT_STRING_EQUAL(text, "n999");
+    get_value(df, 998, 2, &text);
+    CU_ASSERT_PTR_NULL(text);
+
+    // A batch grows the columns once; a NULL array stores NULLs
+    int ids[3] = {-1, -2, -3};
+    const char *names[3] = {"x", NULL, "z"};
+    const void *batch[3] = {ids, names, NULL};
+    CU_ASSERT_EQUAL(append_rows(df, batch, 3), 0);
+    CU_ASSERT_EQUAL(df->num_rows, 1003);
+    get_value(df, 1002, 0, &id);
+    get_value(df, 1002, 1, &text);
+    CU_ASSERT_EQUAL(id, -3);
+    CU_ASSERT_STRING_EQUAL(text, "z");
+    get_value(df, 1001, 1, &text);
+    CU_ASSERT_PTR_NULL(text);
+    get_value(df, 1000, 2, &text);
+    CU_ASSERT_PTR_NULL(text);
+
+    CU_ASSERT_EQUAL(shrink_to_fit(df), 0);
+    CU_ASSERT_EQUAL(df->capacity, 1003);
+    CU_ASSERT_EQUAL(reserve_rows(df, 2000), 0);
+    CU_ASSERT_EQUAL(df->capacity, 2000);
+    CU_ASSERT_EQUAL(df->num_rows, 1003);
+    CU_ASSERT_EQUAL(append_row(df, NULL), -1);
+
+    destroy_dataframe(df);
+}
+
+// Test row-range and column-subset views: they borrow the parent's buffers,
+// are copy-on-write, keep the parent read-only and outlive it
+void test_views(void) {
+    DataFrame *df = create_dataframe(6, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 0, "Price"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 2, "Side"), 0);
+    int buckets[6] = {1, 1, 1, 2, 2, 3};
+    CU_ASSERT_EQUAL(add_int_column(df, 3, "Bucket", buckets, INT_ENCODING_RLE), 0);
+    float prices[6] = {1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f};
+    const char *names[6] = {"a", "b", NULL, "d", "e", "f"};
+    const char *sides[6] = {"buy", "sell", "buy", NULL, "hold", "sell"};
+    CU_ASSERT_EQUAL(set_values(df, 0, 0, 6, prices), 0);
+    CU_ASSERT_EQUAL(set_values(df, 1, 0, 6, names), 0);
+    CU_ASSERT_EQUAL(set_values(df, 2, 0, 6, sides), 0);
+
+    DataFrame *slice = slice_rows(df, 2, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(slice);
+    CU_ASSERT_EQUAL(slice->num_rows, 3);
+    CU_ASSERT_PTR_EQUAL(slice->columns[0].data.float_data, df->columns[0].data.float_data + 2);
+    CU_ASSERT_PTR_EQUAL(slice->columns[1].data.string_data.bytes, df->columns[1].data.string_data.bytes);
+    float price;
+    char *text;
+    int bucket;
+    get_value(slice, 0, 0, &price);
+    CU_ASSERT_DOUBLE_EQUAL(price, 3.5, 0.001);
+    get_value(slice, 0, 1, &text);
+    CU_ASSERT_PTR_NULL(text);
+    get_value(slice, 2, 2, &text);
+    CU_ASSERT_STRING_EQUAL(text, "hold");
+    CU_ASSERT_EQUAL(find_category(&slice->columns[2], "sell", 4), find_category(&df->columns[2], "sell", 4));
+    // An encoded column is decoded for a partial range
+    CU_ASSERT_EQUAL(slice->columns[3].encoding, INT_ENCODING_PLAIN);
+    get_value(slice, 1, 3, &bucket);
+    CU_ASSERT_EQUAL(bucket, 2);
+
+    size_t columns[3] = {3, 2, 2};
+    CU_ASSERT_PTR_NULL(select_columns(df, columns + 1, 2));
+    DataFrame *selection = select_columns(df, columns, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(selection);
+    CU_ASSERT_EQUAL(selection->num_columns, 2);
+    CU_ASSERT_STRING_EQUAL(selection->columns[0].name, "Bucket");
+    CU_ASSERT_EQUAL(selection->columns[0].encoding, INT_ENCODING_RLE);
+
+    // The parent is read-only while views exist; views copy before writing
+    price = 9.5f;
+    CU_ASSERT_EQUAL(set_value(df, 0, 0, &price), -1);
+    CU_ASSERT_EQUAL(reserve_rows(df, 100), -1);
+    CU_ASSERT_EQUAL(set_value(slice, 0, 0, &price), 0);
+    CU_ASSERT_EQUAL(set_value(slice, 0, 2, "short"), 0);
+    bucket = 7;
+    CU_ASSERT_EQUAL(set_value(selection, 0, 0, &bucket), 0);
+    CU_ASSERT_EQUAL(selection->columns[0].encoding, INT_ENCODING_PLAIN);
+    get_value(df, 2, 0, &price);
+    CU_ASSERT_DOUBLE_EQUAL(price, 3.5, 0.001);
+    CU_ASSERT_EQUAL(df->columns[2].data.categorical_data.num_categories, 3);
+    get_value(df, 0, 3, &bucket);
+    CU_ASSERT_EQUAL(bucket, 1);
+
+    DataFrame *nested = slice_rows(selection, 4, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(nested);
+    get_value(nested, 1, 0, &bucket);
+    CU_ASSERT_EQUAL(bucket, 3);
+    CU_ASSERT_EQUAL(set_value(selection, 0, 1, "short"), -1);
+
+    // Destroying the parent first leaves the views readable
+    destroy_dataframe(slice);
+    destroy_dataframe(df);
+    get_value(nested, 0, 1, &text);
+    CU_ASSERT_STRING_EQUAL(text, "hold");
+    destroy_dataframe(selection);
+    get_value(nested, 0, 0, &bucket);
+    CU_ASSERT_EQUAL(bucket, 2);
+    destroy_dataframe(nested);
+
+    // A view of a categorical column with no categories yet can be written to
+    df = create_dataframe(4, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 0, "Side"), 0);
+    slice = slice_rows(df, 1, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(slice);
+    CU_ASSERT_EQUAL(set_value(slice, 0, 0, "hello"), 0);
+    CU_ASSERT_EQUAL(set_value(slice, 1, 0, "world"), 0);
+    get_value(slice, 1, 0, &text);
+    CU_ASSERT_STRING_EQUAL(text, "world");
+    CU_ASSERT_EQUAL(df->columns[0].data.categorical_data.num_categories, 0);
+    destroy_dataframe(slice);
+    destroy_dataframe(df);
+
+    CU_ASSERT_PTR_NULL(slice_rows(NULL, 0, 0));
+}
+
+// Test name lookups on a wide dataframe, duplicate names and names in views
+void test_find_column(void) {
+    DataFrame *df = create_dataframe(2, 2000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    char name[MAX_COLUMN_NAME_LENGTH];
+    int ok = 1;
+    for (size_t i = 0; i < df->num_columns; i++) {
+        snprintf(name, sizeof(name), "Metric%zu", i);
+        ok &= add_column(df, i % 2 ? DATA_TYPE_FLOAT : DATA_TYPE_INT, i, name) == 0;
+    }
+    CU_ASSERT(ok);
+    for (size_t i = 0; i < df->num_columns; i++) {
+        snprintf(name, sizeof(name), "Metric%zu", i);
+        ok &= find_column(df, name) == (int)i;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(find_column(df, "Metric2000"), -1);
+    CU_ASSERT_EQUAL(find_column(df, "metric1"), -1);
+    CU_ASSERT_EQUAL(find_column(NULL, "Metric1"), -1);
+
+    // A name can only be used once
+    DataFrame *pair = create_dataframe(2, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(pair);
+    CU_ASSERT_EQUAL(add_column(pair, DATA_TYPE_INT, 0, "Price"), 0);
+    CU_ASSERT_EQUAL(add_column(pair, DATA_TYPE_FLOAT, 1, "Price"), -1);
+    CU_ASSERT_EQUAL(find_column(pair, "Price"), 0);
+    int values[2] = {1, 2};
+    CU_ASSERT_EQUAL(add_int_column(pair, 1, "Price", values, INT_ENCODING_RLE), -1);
+    CU_ASSERT_EQUAL(add_int_column(pair, 1, "Size", values, INT_ENCODING_RLE), 0);
+    CU_ASSERT_EQUAL(find_column(pair, "Size"), 1);
+    destroy_dataframe(pair);
+
+    size_t columns[2] = {1999, 3};
+    DataFrame *view = select_columns(df, columns, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(view);
+    CU_ASSERT_EQUAL(find_column(view, "Metric3"), 1);
+    CU_ASSERT_EQUAL(find_column(view, "Metric0"), -1);
+    destroy_dataframe(view);
+    destroy_dataframe(df);
+}
+
 // Main function to run tests
 int main() {
     // Initialize CUnit
@@ -109,7 +485,14 @@ int main() {
     
     // Add tests to the suite
     if ((CU_add_test(suite, "test_create_dataframe", test_create_dataframe) == NULL) ||
-        (CU_add_test(suite, "test_big_dataframe", test_big_dataframe) == NULL)) {
+        (CU_add_test(suite, "test_big_dataframe", test_big_dataframe) == NULL) ||
+        (CU_add_test(suite, "test_string_column", test_string_column) == NULL) ||
+        (CU_add_test(suite, "test_categorical_column", test_categorical_column) == NULL) ||
+        (CU_add_test(suite, "test_bulk_access", test_bulk_access) == NULL) ||
+        (CU_add_test(suite, "test_take_rows", test_take_rows) == NULL) ||
+        (CU_add_test(suite, "test_append_rows", test_append_rows) == NULL) ||
+        (CU_add_test(suite, "test_views", test_views) == NULL) ||
+        (CU_add_test(suite, "test_find_column", test_find_column) == NULL)) {
         CU_cleanup_registry();
         return CU_get_error();
     }
@@ -0,0 +1,244 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "dfalloc.h"
+#include "dfio.h"
+
+// Counts the live allocations made through the hooks
+typedef struct {
+    size_t live;
+    size_t calls;
+} CountingContext;
+
+static void *counting_allocate(void *context, size_t size) {
+    CountingContext *counts = context;
+    void *ptr = malloc(size);
+    if (ptr) counts->live++;
+    counts->calls++;
+    return ptr;
+}
+
+static void *counting_reallocate(void *context, void *ptr, size_t size) {
+    CountingContext *counts = context;
+    void *moved = realloc(ptr, size);
+    if (moved && ptr == NULL) counts->live++;
+    counts->calls++;
+    return moved;
+}
+
+static void counting_release(void *context, void *ptr) {
+    CountingContext *counts = context;
+    if (ptr) counts->live--;
+    free(ptr);
+}
+
+/**
+ * Test arena allocation, alignment, in-place growth of the last allocation,
+ * copying of older ones and reuse of blocks after a reset.
+ */
+void test_arena(void) {
+    DataFrameArena *arena = arena_create(256);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    CU_ASSERT_EQUAL(arena_capacity(arena), 0);
+
+    char *first = arena_alloc(arena, 10);
+    char *second = arena_alloc(arena, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(second);
+    CU_ASSERT_EQUAL((uintptr_t)first % 16, 0);
+    CU_ASSERT_EQUAL((uintptr_t)second % 16, 0);
+    strcpy(first, "arena");
+    strcpy(second, "ab");
+
+    // The last allocation grows in place, an older one is copied
+    CU_ASSERT_PTR_EQUAL(arena_realloc(arena, second, 40), second);
+    char *moved = arena_realloc(arena, first, 64);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(moved);
+    CU_ASSERT_PTR_NOT_EQUAL(moved, first);
+    CU_ASSERT_STRING_EQUAL(moved, "arena");
+    CU_ASSERT_STRING_EQUAL(second, "ab");
+
+    // Freeing the last allocation hands its memory out again
+    arena_free(arena, moved);
+    CU_ASSERT_PTR_EQUAL(arena_alloc(arena, 64), moved);
+
+    // Oversized requests get a block of their own
+    char *big = arena_alloc(arena, 4096);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(big);
+    memset(big, 1, 4096);
+    size_t capacity = arena_capacity(arena);
+    CU_ASSERT(capacity >= 4096 + 256);
+
+    arena_reset(arena);
+    for (int i = 0; i < 8; i++) {
+        CU_ASSERT_PTR_NOT_NULL(arena_alloc(arena, 100));
+    }
+    CU_ASSERT_EQUAL(arena_capacity(arena), capacity);
+    arena_destroy(arena);
+}
+
+/**
+ * Test that every DataFrame allocation goes through custom hooks and that all
+ * of it is released by destroy_dataframe.
+ */
+void test_custom_allocator(void) {
+    CountingContext counts = {0, 0};
+    DataFrameAllocator allocator = {counting_allocate, counting_reallocate, counting_release, NULL, &counts};
+    DataFrame *df = create_dataframe_with_allocator(0, 3, &allocator);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 2, "Side"), 0);
+    for (int i = 0; i < 100; i++) {
+        const void *values[3] = {&i, i % 2 ? "odd" : "even", i % 3 ? "buy" : "sell"};
+        CU_ASSERT_EQUAL(append_row(df, values), 0);
+    }
+    CU_ASSERT(counts.calls > 5);
+    CU_ASSERT(counts.live > 0);
+
+    char *name;
+    CU_ASSERT_EQUAL(get_value(df, 41, 1, &name), 0);
+    CU_ASSERT_STRING_EQUAL(name, "odd");
+
+    destroy_dataframe(df);
+    CU_ASSERT_EQUAL(counts.live, 0);
+}
+
+/**
+ * Test a DataFrame that owns an arena: it grows row by row and is torn down
+ * together with the arena. CSV loads into a shared arena are checked too.
+ */
+void test_arena_dataframe(void) {
+    DataFrameArena *arena = arena_create(0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    DataFrameAllocator allocator = arena_allocator(arena, 1);
+    DataFrame *df = create_dataframe_with_allocator(0, 2, &allocator);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 0, "Price"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 1, "Side"), 0);
+    int ok = 1;
+    for (int i = 0; i < 10000; i++) {
+        float price = (float)i / 4;
+        const void *values[2] = {&price, i % 2 ? "buy" : "sell"};
+        ok &= append_row(df, values) == 0;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(shrink_to_fit(df), 0);
+    CU_ASSERT_EQUAL(df->num_rows, 10000);
+
+    const char *filename = "test_dfalloc.csv";
+    CU_ASSERT_EQUAL(save_to_csv_with_options(df, filename, NULL), 0);
+
+    float price;
+    char *side;
+    CU_ASSERT_EQUAL(get_value(df, 9999, 0, &price), 0);
+    CU_ASSERT_DOUBLE_EQUAL(price, 2499.75, 0.001);
+    CU_ASSERT_EQUAL(get_value(df, 9999, 1, &side), 0);
+    CU_ASSERT_STRING_EQUAL(side, "buy");
+    destroy_dataframe(df); // Also destroys the arena
+
+    // Two frames loaded into a shared arena that the caller frees
+    arena = arena_create(0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    allocator = arena_allocator(arena, 0);
+    DataType types[2] = {DATA_TYPE_FLOAT, DATA_TYPE_CATEGORICAL};
+    CsvReadOptions options = {NULL, &allocator};
+    DataFrame *first = read_csv_with_options(filename, types, 2, &options);
+    const char *columns[1] = {"Side"};
+    CsvReadOptions projected = {columns, &allocator};
+    DataFrame *second = read_csv_with_options(filename, &types[1], 1, &projected);
+    CU_ASSERT_PTR_NOT_NULL(first);
+    CU_ASSERT_PTR_NOT_NULL(second);
+    if (first && second) {
+        CU_ASSERT_EQUAL(first->num_rows, 10000);
+        CU_ASSERT_EQUAL(second->num_rows, 10000);
+        CU_ASSERT_EQUAL(get_value(first, 2, 0, &price), 0);
+        CU_ASSERT_DOUBLE_EQUAL(price, 0.5, 0.001);
+        CU_ASSERT_EQUAL(get_value(second, 2, 0, &side), 0);
+        CU_ASSERT_STRING_EQUAL(side, "sell");
+    }
+    destroy_dataframe(first);
+    destroy_dataframe(second);
+    arena_destroy(arena);
+    remove(filename);
+}
+
+/**
+ * Test that a read through an owned arena leaves the arena with the caller
+ * when it fails, whether before or after the DataFrame was created.
+ */
+void test_arena_failed_read(void) {
+    const char *filename = "test_dfalloc_invalid.csv";
+    const char *contents[3] = {
+        "ID,Name\n1,one\nx,two\n",    // Not a number
+        "ID,Name\n1,one\n2,two,more\n", // Wrong field count
+        "ID\n1\n",                      // Header mismatch, before the DataFrame exists
+    };
+    DataType types[2] = {DATA_TYPE_INT, DATA_TYPE_STRING};
+    DataFrameArena *arena = arena_create(0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    DataFrameAllocator allocator = arena_allocator(arena, 1);
+    CsvReadOptions options = {NULL, &allocator};
+
+    for (int i = 0; i < 3; i++) {
+        FILE *file = fopen(filename, "w");
+        CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+        fputs(contents[i], file);
+        fclose(file);
+        CU_ASSERT_PTR_NULL(read_csv_with_options(filename, types, 2, &options));
+        CU_ASSERT_PTR_NOT_NULL(arena_alloc(arena, 16));
+    }
+    CU_ASSERT_PTR_NULL(read_csv_with_options("does_not_exist.csv", types, 2, &options));
+
+    // The arena is still the caller's, and a later successful read takes it over
+    FILE *file = fopen(filename, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    fputs("ID,Name\n1,one\n2,two\n", file);
+    fclose(file);
+    arena_reset(arena);
+    DataFrame *df = read_csv_with_options(filename, types, 2, &options);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df) {
+        CU_ASSERT_EQUAL(df->num_rows, 2);
+        destroy_dataframe(df); // Also destroys the arena
+    } else {
+        arena_destroy(arena);
+    }
+    remove(filename);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Allocator Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_arena", test_arena) == NULL) ||
+        (CU_add_test(suite, "test_custom_allocator", test_custom_allocator) == NULL) ||
+        (CU_add_test(suite, "test_arena_dataframe", test_arena_dataframe) == NULL) ||
+        (CU_add_test(suite, "test_arena_failed_read", test_arena_failed_read) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <unistd.h>
 #include "dataframe.h"
 #include "dfio.h"
 
@@ -91,6 +93,497 @@ void test_read_csv(void) {
     remove(filename);
 }
 
+/**
+ * Test function for read_csv_mmap.
+ * Covers quoted fields with delimiters, escaped quotes and embedded newlines,
+ * CRLF line endings and lines longer than the stdio reader's buffer.
+ */
+void test_read_csv_mmap(void) {
+    DataType types[3] = {DATA_TYPE_INT, DATA_TYPE_FLOAT, DATA_TYPE_STRING};
+    const char *filename = "test_read_csv_mmap.csv";
+
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Value,\"Name\"\r\n");
+    fprintf(fp, "1, 3.14 ,\"Smith, Alice\"\r\n");
+    fprintf(fp, "-2,2.718,\"Bob \"\"The Builder\"\"\"\n");
+    fprintf(fp, "3,1.618,\"Multi\nLine\"\n");
+    fprintf(fp, "4,0.5,");
+    for (int i = 0; i < 3000; i++) fputc('x', fp);
+    fclose(fp);
+
+    DataFrame *df = read_csv_mmap(filename, types, 3);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df) {
+        CU_ASSERT_EQUAL(df->num_rows, 4);
+        CU_ASSERT_STRING_EQUAL(df->columns[2].name, "Name");
+
+        int id;
+        float value;
+        char *name;
+
+        CU_ASSERT_EQUAL(get_value(df, 0, 0, &id), 0);
+        CU_ASSERT_EQUAL(id, 1);
+        CU_ASSERT_EQUAL(get_value(df, 0, 1, &value), 0);
+        CU_ASSERT_DOUBLE_EQUAL(value, 3.14, 0.001);
+        CU_ASSERT_EQUAL(get_value(df, 0, 2, &name), 0);
+        CU_ASSERT_STRING_EQUAL(name, "Smith, Alice");
+
+        CU_ASSERT_EQUAL(get_value(df, 1, 0, &id), 0);
+        CU_ASSERT_EQUAL(id, -2);
+        CU_ASSERT_EQUAL(get_value(df, 1, 2, &name), 0);
+        CU_ASSERT_STRING_EQUAL(name, "Bob \"The Builder\"");
+
+        CU_ASSERT_EQUAL(get_value(df, 2, 2, &name), 0);
+        CU_ASSERT_STRING_EQUAL(name, "Multi\nLine");
+
+        CU_ASSERT_EQUAL(get_value(df, 3, 0, &id), 0);
+        CU_ASSERT_EQUAL(id, 4);
+        CU_ASSERT_EQUAL(get_value(df, 3, 2, &name), 0);
+        CU_ASSERT_EQUAL(strlen(name), 3000);
+
+        destroy_dataframe(df);
+    }
+
+    remove(filename);
+}
+
+/**
+ * Test function for read_csv_with_options.
+ * Loads two columns of a wider file in a different order than the header,
+ * including a quoted field in a skipped column, and rejects unknown names.
+ */
+void test_read_csv_projection(void) {
+    const char *filename = "test_read_csv_projection.csv";
+
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Note,Price,Side,Extra\n");
+    fprintf(fp, "1,\"skip, me\",2.5,buy,x\n");
+    fprintf(fp, "2,\"also\nskipped\",3.75,sell,y\n");
+    fprintf(fp, "3,,1.25,buy,z\n");
+    fclose(fp);
+
+    const char *columns[2] = {"Side", "Price"};
+    DataType types[2] = {DATA_TYPE_CATEGORICAL, DATA_TYPE_FLOAT};
+    CsvReadOptions options = {columns, NULL};
+    DataFrame *df = read_csv_with_options(filename, types, 2, &options);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df) {
+        CU_ASSERT_EQUAL(df->num_rows, 3);
+        CU_ASSERT_EQUAL(df->num_columns, 2);
+        CU_ASSERT_STRING_EQUAL(df->columns[0].name, "Side");
+        CU_ASSERT_STRING_EQUAL(df->columns[1].name, "Price");
+
+        char *side;
+        float price;
+        CU_ASSERT_EQUAL(get_value(df, 1, 0, &side), 0);
+        CU_ASSERT_STRING_EQUAL(side, "sell");
+        CU_ASSERT_EQUAL(get_value(df, 1, 1, &price), 0);
+        CU_ASSERT_DOUBLE_EQUAL(price, 3.75, 0.001);
+        CU_ASSERT_EQUAL(get_value(df, 2, 1, &price), 0);
+        CU_ASSERT_DOUBLE_EQUAL(price, 1.25, 0.001);
+        destroy_dataframe(df);
+    }
+
+    // Without a column list every column is loaded
+    DataType all_types[5] = {DATA_TYPE_INT, DATA_TYPE_STRING, DATA_TYPE_FLOAT, DATA_TYPE_STRING, DATA_TYPE_STRING};
+    CsvReadOptions all = {NULL, NULL};
+    df = read_csv_with_options(filename, all_types, 5, &all);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df) {
+        CU_ASSERT_EQUAL(df->num_columns, 5);
+        destroy_dataframe(df);
+    }
+
+    columns[1] = "Missing";
+    CU_ASSERT_PTR_NULL(read_csv_with_options(filename, types, 2, &options));
+
+    remove(filename);
+}
+
+/**
+ * Test that malformed and out-of-range numbers fail the load instead of
+ * silently becoming 0, while empty numeric fields still read as 0.
+ */
+void test_read_csv_invalid_number(void) {
+    const char *filename = "test_read_csv_invalid.csv";
+    DataType types[2] = {DATA_TYPE_INT, DATA_TYPE_FLOAT};
+
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Value\n1,2.5\n,\n");
+    fclose(fp);
+    DataFrame *df = read_csv_mmap(filename, types, 2);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df) {
+        int id = -1;
+        CU_ASSERT_EQUAL(get_value(df, 1, 0, &id), 0);
+        CU_ASSERT_EQUAL(id, 0);
+        destroy_dataframe(df);
+    }
+
+    fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Value\n1,2.5\n2x,3.0\n");
+    fclose(fp);
+    CU_ASSERT_PTR_NULL(read_csv_mmap(filename, types, 2));
+    CU_ASSERT_PTR_NULL(read_csv(filename, types, 2));
+
+    fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Value\n3000000000,1.0\n");
+    fclose(fp);
+    CU_ASSERT_PTR_NULL(read_csv_mmap(filename, types, 2));
+
+    remove(filename);
+}
+
+/**
+ * Test function for read_csv_parallel.
+ * Writes a file large enough to be split into several chunks, with quoted
+ * fields containing newlines, and checks it against read_csv_mmap.
+ */
+void test_read_csv_parallel(void) {
+    DataType types[4] = {DATA_TYPE_INT, DATA_TYPE_FLOAT, DATA_TYPE_STRING, DATA_TYPE_CATEGORICAL};
+    const char *statuses[] = {"open", "closed", "pending"};
+    const char *filename = "test_read_csv_parallel.csv";
+    size_t num_rows = 50000;
+
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Value,Name,Status\n");
+    for (size_t i = 0; i < num_rows; i++) {
+        // Later chunks see the statuses in a different order than the first one
+        const char *status = statuses[(i * i / 1000) % 3];
+        if (i % 7 == 0) {
+            fprintf(fp, "%zu,%zu.5,\"line\n%zu, \"\"quoted\"\"\",%s\n", i, i, i, status);
+        } else {
+            fprintf(fp, "%zu,%zu.25,name%zu,%s\n", i, i, i, status);
+        }
+    }
+    fclose(fp);
+
+    DataFrame *expected = read_csv_mmap(filename, types, 4);
+    DataFrame *df = read_csv_parallel(filename, types, 4, 4);
+    CU_ASSERT_PTR_NOT_NULL(expected);
+    CU_ASSERT_PTR_NOT_NULL(df);
+    if (df && expected) {
+        CU_ASSERT_EQUAL(df->num_rows, num_rows);
+        CU_ASSERT_EQUAL(expected->num_rows, num_rows);
+        CU_ASSERT_EQUAL(df->columns[3].data.categorical_data.num_categories, 3);
+        for (size_t row = 0; row < df->num_rows && row < expected->num_rows; row++) {
+            int id;
+            char *name, *expected_name;
+            get_value(df, row, 0, &id);
+            get_value(df, row, 2, &name);
+            get_value(expected, row, 2, &expected_name);
+            if ((size_t)id != row || strcmp(name, expected_name) != 0 ||
+                df->columns[3].data.categorical_data.codes[row] != expected->columns[3].data.categorical_data.codes[row]) {
+                CU_FAIL("Parallel result differs from sequential result");
+                break;
+            }
+        }
+    }
+
+    destroy_dataframe(df);
+    destroy_dataframe(expected);
+    remove(filename);
+}
+
+/**
+ * Test function for the streaming batch reader.
+ * The file is larger than the reader's buffer and contains a record longer
+ * than the buffer, so records are cut at buffer boundaries and the buffer grows.
+ */
+void test_csv_reader_batches(void) {
+    DataType types[2] = {DATA_TYPE_INT, DATA_TYPE_STRING};
+    const char *filename = "test_csv_reader.csv";
+    size_t num_rows = 100000;
+    size_t long_row = 60000;
+    size_t long_length = 3 * 1024 * 1024;
+
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        CU_FAIL("Failed to create sample CSV file");
+        return;
+    }
+    fprintf(fp, "ID,Name\n");
+    for (size_t i = 0; i < num_rows; i++) {
+        if (i == long_row) {
+            fprintf(fp, "%zu,\"", i);
+            for (size_t j = 0; j < long_length; j++) fputc(j % 1000 == 0 ? '\n' : 'x', fp);
+            fprintf(fp, "\"\n");
+        } else {
+            fprintf(fp, "%zu,\"name,%zu\"\n", i, i);
+        }
+    }
+    fclose(fp);
+
+    CsvReader *reader = csv_reader_open(filename, types, 2, 4096);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+
+    DataFrame *batch = NULL;
+    size_t rows = 0;
+    size_t batches = 0;
+    int ok = 1;
+    int status;
+    while ((status = csv_reader_next_batch(reader, &batch)) == 1) {
+        CU_ASSERT(batch->num_rows <= 4096);
+        for (size_t row = 0; row < batch->num_rows; row++, rows++) {
+            int id;
+            char *name;
+            char expected[32];
+            get_value(batch, row, 0, &id);
+            get_value(batch, row, 1, &name);
+            snprintf(expected, sizeof(expected), "name,%zu", rows);
+            if (rows == long_row) {
+                ok &= strlen(name) == long_length;
+            } else {
+                ok &= (size_t)id == rows && strcmp(name, expected) == 0;
+            }
+        }
+        batches++;
+    }
+    CU_ASSERT_EQUAL(status, 0);
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(rows, num_rows);
+    CU_ASSERT_EQUAL(batches, (num_rows + 4095) / 4096);
+
+    csv_reader_close(reader);
+    remove(filename);
+}
+
+/**
+ * Test function for the buffered CSV writer.
+ * Floats must match printf output at the requested precision and strings
+ * with quotes must survive a round trip.
+ */
+void test_save_to_csv_options(void) {
+    const char *filename = "test_save_to_csv.csv";
+    size_t num_rows = 20000;
+    DataFrame *df = create_dataframe(num_rows, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Value"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 2, "Name"), 0);
+
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < num_rows; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int id = i == 0 ? INT_MIN : (int)(seed % 2000000000u) - 1000000000;
+        float value = (float)((int)(seed >> 8) - (1 << 23)) / (float)(1 << (i % 24));
+        if (i == 1) value = 1e30f;
+        if (i == 2) value = -0.0001f;
+        set_value(df, i, 0, &id);
+        set_value(df, i, 1, &value);
+        set_value(df, i, 2, i % 3 ? "plain" : "say \"hi\", \"bye\"");
+    }
+
+    CsvWriteOptions options = {4, COMPRESSION_AUTO, 0};
+    CU_ASSERT_EQUAL(save_to_csv_with_options(df, filename, &options), 0);
+
+    FILE *fp = fopen(filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    char line[256];
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), fp));
+    CU_ASSERT_STRING_EQUAL(line, "\"ID\",\"Value\",\"Name\"\n");
+    int ok = 1;
+    for (size_t i = 0; i < num_rows && fgets(line, sizeof(line), fp); i++) {
+        int id;
+        float value;
+        char *name;
+        char expected[256];
+        get_value(df, i, 0, &id);
+        get_value(df, i, 1, &value);
+        get_value(df, i, 2, &name);
+        snprintf(expected, sizeof(expected), "%d,%.4f,\"%s\"\n", id, value,
+                 i % 3 ? "plain" : "say \"\"hi\"\", \"\"bye\"\"");
+        ok &= strcmp(line, expected) == 0;
+    }
+    CU_ASSERT(ok);
+    fclose(fp);
+
+    // Escaped quotes read back as the original strings
+    DataType types[3] = {DATA_TYPE_INT, DATA_TYPE_FLOAT, DATA_TYPE_STRING};
+    DataFrame *copy = read_csv_mmap(filename, types, 3);
+    CU_ASSERT_PTR_NOT_NULL(copy);
+    if (copy) {
+        char *name;
+        CU_ASSERT_EQUAL(copy->num_rows, num_rows);
+        CU_ASSERT_EQUAL(get_value(copy, 3, 2, &name), 0);
+        CU_ASSERT_STRING_EQUAL(name, "say \"hi\", \"bye\"");
+        destroy_dataframe(copy);
+    }
+
+    destroy_dataframe(df);
+    remove(filename);
+}
+
+/**
+ * Test function for save_binary and load_binary.
+ * Every column type must round trip, and writing to a loaded column must copy
+ * it instead of touching the read-only mapping.
+ */
+void test_binary_round_trip(void) {
+    const char *filename = "test_binary.dfb";
+    size_t num_rows = 1000;
+    DataFrame *df = create_dataframe(num_rows, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Value"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 2, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 3, "City"), 0);
+
+    const char *cities[3] = {"Oslo", "Lima", "Pune"};
+    for (size_t i = 0; i < num_rows; i++) {
+        int id = (int)i * 7;
+        float value = (float)i / 8.0f;
+        char name[32];
+        snprintf(name, sizeof(name), "name %zu", i);
+        set_value(df, i, 0, &id);
+        set_value(df, i, 1, &value);
+        if (i % 10 != 0) set_value(df, i, 2, name);
+        if (i % 11 != 0) set_value(df, i, 3, cities[i % 3]);
+    }
+    CU_ASSERT_EQUAL(save_binary(df, filename), 0);
+
+    DataFrame *loaded = load_binary(filename);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(loaded);
+    CU_ASSERT_EQUAL(loaded->num_rows, num_rows);
+    CU_ASSERT_EQUAL(loaded->num_columns, 4);
+    CU_ASSERT_STRING_EQUAL(loaded->columns[2].name, "Name");
+    CU_ASSERT_EQUAL(loaded->columns[3].type, DATA_TYPE_CATEGORICAL);
+
+    // Columns point into the mapping and are 64-byte aligned
+    const int *ids;
+    size_t length;
+    CU_ASSERT_EQUAL(get_int_span(loaded, 0, &ids, &length), 0);
+    CU_ASSERT((uintptr_t)ids % 64 == 0);
+    CU_ASSERT((const char *)ids >= (const char *)loaded->mapping &&
+              (const char *)ids < (const char *)loaded->mapping + loaded->mapping_size);
+
+    int ok = 1;
+    for (size_t i = 0; i < num_rows; i++) {
+        int id;
+        float value;
+        const char *name, *city;
+        get_value(loaded, i, 0, &id);
+        get_value(loaded, i, 1, &value);
+        get_value(loaded, i, 2, &name);
+        get_value(loaded, i, 3, &city);
+        char expected[32];
+        snprintf(expected, sizeof(expected), "name %zu", i);
+        ok &= id == (int)i * 7 && value == (float)i / 8.0f;
+        ok &= i % 10 == 0 ? name == NULL : name != NULL && strcmp(name, expected) == 0;
+        ok &= i % 11 == 0 ? city == NULL : city != NULL && strcmp(city, cities[i % 3]) == 0;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(find_category(&loaded->columns[3], "Lima", 4), loaded->columns[3].data.categorical_data.codes[1]);
+
+    // Writes copy the column out of the mapping
+    int id = -1;
+    CU_ASSERT_EQUAL(set_value(loaded, 5, 0, &id), 0);
+    CU_ASSERT_EQUAL(loaded->columns[0].borrowed, 0);
+    CU_ASSERT_EQUAL(loaded->columns[0].data.int_data[5], -1);
+    CU_ASSERT_EQUAL(loaded->columns[0].data.int_data[6], 42);
+    CU_ASSERT_EQUAL(set_value(loaded, 0, 3, "Rome"), 0);
+    const char *city;
+    get_value(loaded, 0, 3, &city);
+    CU_ASSERT_STRING_EQUAL(city, "Rome");
+    get_value(loaded, 2, 3, &city);
+    CU_ASSERT_STRING_EQUAL(city, "Pune");
+    CU_ASSERT_EQUAL(set_value(loaded, 1, 2, "renamed"), 0);
+    const char *name;
+    get_value(loaded, 2, 2, &name);
+    CU_ASSERT_STRING_EQUAL(name, "name 2");
+    destroy_dataframe(loaded);
+
+    // Truncated files are rejected
+    FILE *fp = fopen(filename, "r+b");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    CU_ASSERT_EQUAL(ftruncate(fileno(fp), 4096), 0);
+    fclose(fp);
+    CU_ASSERT_PTR_NULL(load_binary(filename));
+
+    destroy_dataframe(df);
+    remove(filename);
+}
+
+// Overwrites the first occurrence of pattern in a file with replacement of the same size
+static int patch_file(const char *filename, const void *pattern, const void *replacement, size_t size) {
+    FILE *fp = fopen(filename, "r+b");
+    if (fp == NULL) return -1;
+    char contents[16384];
+    size_t length = fread(contents, 1, sizeof(contents), fp);
+    int status = -1;
+    for (size_t i = 0; i + size <= length && status != 0; i++) {
+        if (memcmp(contents + i, pattern, size) == 0) {
+            status = fseek(fp, (long)i, SEEK_SET) == 0 && fwrite(replacement, 1, size, fp) == size ? 0 : -1;
+        }
+    }
+    fclose(fp);
+    return status;
+}
+
+/**
+ * Test that load_binary rejects string offsets and category codes that point
+ * outside their column instead of reading out of bounds later.
+ */
+void test_binary_corrupt_rows(void) {
+    const char *filename = "test_binary_corrupt.dfb";
+    DataFrame *df = create_dataframe(3, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 0, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 1, "City"), 0);
+    const char *names[3] = {"abcdefgh", "xyz", "q"};
+    const char *cities[3] = {"Oslo", "Lima", "Pune"};
+    for (size_t i = 0; i < 3; i++) {
+        set_value(df, i, 0, names[i]);
+        set_value(df, i, 1, cities[i]);
+    }
+
+    // String offsets are {0, 9, 13} and category codes {0, 1, 2}
+    size_t offsets[3] = {0, 9, 13};
+    size_t bad_offsets[3] = {0, 9, 4000};
+    int codes[3] = {0, 1, 2};
+    int bad_codes[2][3] = {{0, 1, 3}, {0, -2, 2}};
+
+    CU_ASSERT_EQUAL(save_binary(df, filename), 0);
+    DataFrame *loaded = load_binary(filename);
+    CU_ASSERT_PTR_NOT_NULL(loaded);
+    destroy_dataframe(loaded);
+    CU_ASSERT_EQUAL(patch_file(filename, offsets, bad_offsets, sizeof(offsets)), 0);
+    CU_ASSERT_PTR_NULL(load_binary(filename));
+
+    for (int i = 0; i < 2; i++) {
+        CU_ASSERT_EQUAL(save_binary(df, filename), 0);
+        CU_ASSERT_EQUAL(patch_file(filename, codes, bad_codes[i], sizeof(codes)), 0);
+        CU_ASSERT_PTR_NULL(load_binary(filename));
+    }
+
+    destroy_dataframe(df);
+    remove(filename);
+}
+
 /**
  * Main function to run CUnit tests.
  */
@@ -108,7 +601,15 @@ int main() {
     }
     
     // Add tests to the suite
-    if (CU_add_test(suite, "test_read_csv", test_read_csv) == NULL) {
+    if ((CU_add_test(suite, "test_read_csv", test_read_csv) == NULL) ||
+        (CU_add_test(suite, "test_read_csv_mmap", test_read_csv_mmap) == NULL) ||
+        (CU_add_test(suite, "test_read_csv_projection", test_read_csv_projection) == NULL) ||
+        (CU_add_test(suite, "test_read_csv_invalid_number", test_read_csv_invalid_number) == NULL) ||
+        (CU_add_test(suite, "test_read_csv_parallel", test_read_csv_parallel) == NULL) ||
+        (CU_add_test(suite, "test_csv_reader_batches", test_csv_reader_batches) == NULL) ||
+        (CU_add_test(suite, "test_save_to_csv_options", test_save_to_csv_options) == NULL) ||
+        (CU_add_test(suite, "test_binary_round_trip", test_binary_round_trip) == NULL) ||
+        (CU_add_test(suite, "test_binary_corrupt_rows", test_binary_corrupt_rows) == NULL)) {
         CU_cleanup_registry();
         return CU_get_error();
     }
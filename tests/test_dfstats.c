@@ -0,0 +1,144 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "dfio.h"
+#include "dfstats.h"
+
+static void *count_in_thread(void *arg) {
+    (void)arg;
+    stats_add(STATS_ROWS_PARSED, 5);
+    stats_record(STAGE_TOKENIZE, 100);
+    return NULL;
+}
+
+/**
+ * Test that counters of the calling thread and of threads that have exited
+ * are added up, reset and dumped as JSON.
+ */
+void test_stats_counters(void) {
+    stats_reset();
+    stats_add(STATS_ROWS_PARSED, 2);
+    stats_record(STAGE_TOKENIZE, 50);
+
+    pthread_t thread;
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&thread, NULL, count_in_thread, NULL), 0);
+    pthread_join(thread, NULL);
+
+    DataFrameStats stats;
+    stats_snapshot(&stats);
+    CU_ASSERT_EQUAL(stats.counters[STATS_ROWS_PARSED], 7);
+    CU_ASSERT_EQUAL(stats.stage_ns[STAGE_TOKENIZE], 150);
+    CU_ASSERT_EQUAL(stats.stage_calls[STAGE_TOKENIZE], 2);
+    CU_ASSERT_EQUAL(stats.counters[STATS_BYTES_READ], 0);
+
+    FILE *out = tmpfile();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(out);
+    CU_ASSERT_EQUAL(stats_dump(&stats, out), 0);
+    rewind(out);
+    char line[1024];
+    CU_ASSERT_PTR_NOT_NULL(fgets(line, sizeof(line), out));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "\"rows_parsed\":7"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(line, "\"tokenize\":{\"ns\":150,\"calls\":2}"));
+    fclose(out);
+
+    stats_reset();
+    stats_snapshot(&stats);
+    CU_ASSERT_EQUAL(stats.counters[STATS_ROWS_PARSED], 0);
+    CU_ASSERT_EQUAL(stats.stage_calls[STAGE_TOKENIZE], 0);
+    CU_ASSERT_STRING_EQUAL(stats_counter_name(STATS_ALLOCATIONS), "allocations");
+    CU_ASSERT_STRING_EQUAL(stats_stage_name(STAGE_WRITE), "write");
+}
+
+/**
+ * Test the counters collected by a CSV round trip. They are only filled in
+ * when the library is built with DF_ENABLE_STATS.
+ */
+void test_stats_csv_round_trip(void) {
+    const char *filename = "test_stats.csv";
+    DataFrame *df = create_dataframe(100, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    for (int i = 0; i < 100; i++) {
+        CU_ASSERT_EQUAL(set_value(df, (size_t)i, 0, &i), 0);
+        CU_ASSERT_EQUAL(set_value(df, (size_t)i, 1, "name"), 0);
+    }
+
+    stats_reset();
+    CU_ASSERT_EQUAL(save_to_csv_with_options(df, filename, NULL), 0);
+    DataType types[2] = {DATA_TYPE_INT, DATA_TYPE_STRING};
+    DataFrame *loaded = read_csv_mmap(filename, types, 2);
+    CU_ASSERT_PTR_NOT_NULL(loaded);
+
+    DataFrameStats stats;
+    stats_snapshot(&stats);
+    if (stats_enabled()) {
+        CU_ASSERT_EQUAL(stats.counters[STATS_ROWS_WRITTEN], 100);
+        CU_ASSERT_EQUAL(stats.counters[STATS_ROWS_PARSED], 100);
+        CU_ASSERT(stats.counters[STATS_BYTES_WRITTEN] > 0);
+        CU_ASSERT_EQUAL(stats.counters[STATS_BYTES_READ], stats.counters[STATS_BYTES_WRITTEN]);
+        CU_ASSERT(stats.counters[STATS_ALLOCATIONS] > 0);
+        // Stages are timed per window of records, not per record
+        CU_ASSERT(stats.stage_calls[STAGE_TOKENIZE] >= 1 && stats.stage_calls[STAGE_TOKENIZE] <= 2);
+        CU_ASSERT_EQUAL(stats.stage_calls[STAGE_CONVERT], 1);
+        CU_ASSERT(stats.stage_calls[STAGE_WRITE] >= 1);
+    } else {
+        DataFrameStats zero;
+        memset(&zero, 0, sizeof(zero));
+        CU_ASSERT_EQUAL(memcmp(&stats, &zero, sizeof(stats)), 0);
+    }
+    destroy_dataframe(loaded);
+
+    // Every reader counts the rows it parses and times its windows
+    for (int reader = 0; reader < 3; reader++) {
+        stats_reset();
+        if (reader == 0) loaded = read_csv(filename, types, 2);
+        else if (reader == 1) loaded = read_csv_parallel(filename, types, 2, 2);
+        else loaded = read_csv_pipelined(filename, types, 2, NULL);
+        CU_ASSERT_PTR_NOT_NULL(loaded);
+        CU_ASSERT_EQUAL(loaded ? loaded->num_rows : 0, 100);
+        stats_snapshot(&stats);
+        if (stats_enabled()) {
+            CU_ASSERT_EQUAL(stats.counters[STATS_ROWS_PARSED], 100);
+            CU_ASSERT_EQUAL(stats.stage_calls[STAGE_CONVERT], 1);
+            CU_ASSERT(stats.stage_calls[STAGE_TOKENIZE] >= 1);
+        }
+        destroy_dataframe(loaded);
+    }
+    destroy_dataframe(df);
+    remove(filename);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Stats Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_stats_counters", test_stats_counters) == NULL) ||
+        (CU_add_test(suite, "test_stats_csv_round_trip", test_stats_csv_round_trip) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,246 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aggregate.h"
+#include "dataframe.h"
+#include "dfio.h"
+#include "encoding.h"
+#include "filter.h"
+#include "groupby.h"
+#include "sort.h"
+
+#define NUM_ROWS 5000
+
+// Fills the test patterns: long runs, a narrow range and sorted timestamps
+static void fill_patterns(int *runs, int *narrow, int *sorted, size_t count) {
+    unsigned state = 7;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1103515245u + 12345u;
+        runs[i] = (int)(i / 300) % 4 - 2;
+        narrow[i] = 1000 + (int)(state >> 16) % 50;
+        sorted[i] = 1700000000 + (int)i * 60 + (int)(state >> 16) % 3;
+    }
+}
+
+// Whether decoding every row, a range and single rows gives the values back
+static int round_trips(const EncodedInts *encoded, const int *values, size_t count) {
+    int *out = malloc(count * sizeof(int));
+    decode_ints(encoded, 0, count, out);
+    int ok = memcmp(out, values, count * sizeof(int)) == 0;
+    decode_ints(encoded, 317, 700, out);
+    ok &= memcmp(out, values + 317, 700 * sizeof(int)) == 0;
+    for (size_t row = 0; row < count; row += 61) {
+        ok &= encoded_int_at(encoded, row) == values[row];
+    }
+    free(out);
+    return ok;
+}
+
+/**
+ * Test that every encoding round-trips, including the extremes of int, and
+ * that AUTO picks the encoding that suits each pattern.
+ */
+void test_encode_ints(void) {
+    static int runs[NUM_ROWS], narrow[NUM_ROWS], sorted[NUM_ROWS];
+    fill_patterns(runs, narrow, sorted, NUM_ROWS);
+    const int *patterns[3] = {runs, narrow, sorted};
+    const DataFrameAllocator *allocator = default_allocator();
+    EncodedInts encoded;
+
+    int ok = 1;
+    for (int p = 0; p < 3; p++) {
+        for (IntEncoding encoding = INT_ENCODING_RLE; encoding <= INT_ENCODING_DELTA; encoding++) {
+            ok &= encode_ints(patterns[p], NUM_ROWS, encoding, allocator, &encoded) == 0;
+            ok &= encoded.encoding == encoding && round_trips(&encoded, patterns[p], NUM_ROWS);
+            free_encoded_ints(&encoded, allocator);
+        }
+    }
+    CU_ASSERT(ok);
+
+    CU_ASSERT_EQUAL(encode_ints(runs, NUM_ROWS, INT_ENCODING_AUTO, allocator, &encoded), 0);
+    CU_ASSERT_EQUAL(encoded.encoding, INT_ENCODING_RLE);
+    CU_ASSERT_EQUAL(encoded.num_runs, 17);
+    CU_ASSERT_EQUAL(encoded.min, -2);
+    CU_ASSERT_EQUAL(encoded.max, 1);
+    free_encoded_ints(&encoded, allocator);
+    CU_ASSERT_EQUAL(encode_ints(narrow, NUM_ROWS, INT_ENCODING_AUTO, allocator, &encoded), 0);
+    CU_ASSERT_EQUAL(encoded.encoding, INT_ENCODING_FOR);
+    CU_ASSERT_EQUAL(encoded.bit_width, 6);
+    free_encoded_ints(&encoded, allocator);
+    CU_ASSERT_EQUAL(encode_ints(sorted, NUM_ROWS, INT_ENCODING_AUTO, allocator, &encoded), 0);
+    CU_ASSERT_EQUAL(encoded.encoding, INT_ENCODING_DELTA);
+    CU_ASSERT(encoded_ints_size(&encoded) * 8 < NUM_ROWS * sizeof(int));
+    free_encoded_ints(&encoded, allocator);
+
+    // Full-range values need 32 bits for FOR and 33 for DELTA
+    int extremes[6] = {INT_MIN, INT_MAX, 0, INT_MAX, INT_MIN, -1};
+    CU_ASSERT_EQUAL(encode_ints(extremes, 6, INT_ENCODING_FOR, allocator, &encoded), 0);
+    CU_ASSERT_EQUAL(encoded.bit_width, 32);
+    decode_ints(&encoded, 0, 6, narrow);
+    CU_ASSERT_EQUAL(memcmp(narrow, extremes, sizeof(extremes)), 0);
+    free_encoded_ints(&encoded, allocator);
+    CU_ASSERT_EQUAL(encode_ints(extremes, 6, INT_ENCODING_DELTA, allocator, &encoded), 0);
+    CU_ASSERT_EQUAL(encoded.bit_width, 33);
+    decode_ints(&encoded, 0, 6, narrow);
+    CU_ASSERT_EQUAL(memcmp(narrow, extremes, sizeof(extremes)), 0);
+    free_encoded_ints(&encoded, allocator);
+
+    CU_ASSERT_EQUAL(encode_ints(runs, NUM_ROWS, INT_ENCODING_PLAIN, allocator, &encoded), -1);
+}
+
+/**
+ * Test that scans, group-by, sort and saving give the same results on encoded
+ * columns as on plain ones.
+ */
+void test_encoded_columns(void) {
+    static int runs[NUM_ROWS], narrow[NUM_ROWS], sorted[NUM_ROWS];
+    fill_patterns(runs, narrow, sorted, NUM_ROWS);
+    DataFrame *plain = create_dataframe(NUM_ROWS, 3);
+    DataFrame *encoded = create_dataframe(NUM_ROWS, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(plain);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(encoded);
+    const int *patterns[3] = {runs, narrow, sorted};
+    const char *names[3] = {"Runs", "Narrow", "Sorted"};
+    IntEncoding encodings[3] = {INT_ENCODING_RLE, INT_ENCODING_FOR, INT_ENCODING_DELTA};
+    for (size_t c = 0; c < 3; c++) {
+        CU_ASSERT_EQUAL(add_int_column(plain, c, names[c], patterns[c], INT_ENCODING_PLAIN), 0);
+        CU_ASSERT_EQUAL(add_int_column(encoded, c, names[c], patterns[c], encodings[c]), 0);
+    }
+    CU_ASSERT_EQUAL(encoded->columns[2].encoding, INT_ENCODING_DELTA);
+    const int *span;
+    size_t length;
+    CU_ASSERT_EQUAL(get_int_span(encoded, 0, &span, &length), -1);
+
+    int ok = 1;
+    for (size_t c = 0; c < 3; c++) {
+        ColumnStats expected, actual;
+        ok &= column_stats(plain, c, 1, &expected) == 0 && column_stats(encoded, c, 1, &actual) == 0;
+        ok &= expected.sum == actual.sum && expected.min == actual.min && expected.max == actual.max;
+        ok &= expected.variance - actual.variance < 1e-6 * expected.variance + 1e-9;
+
+        // Values inside, at the edges of and outside each column's range
+        int constants[5] = {patterns[c][0], patterns[c][NUM_ROWS / 2], -3, 1025, 1700150000};
+        for (int k = 0; k < 5; k++) {
+            for (CompareOp op = COMPARE_EQ; op <= COMPARE_GE; op++) {
+                RowMask a, b;
+                row_mask_init(&a, NUM_ROWS);
+                row_mask_init(&b, NUM_ROWS);
+                ok &= filter_compare(plain, c, op, &constants[k], &a) == 0;
+                ok &= filter_compare(encoded, c, op, &constants[k], &b) == 0;
+                ok &= memcmp(a.words, b.words, (NUM_ROWS + 63) / 64 * sizeof(uint64_t)) == 0;
+                row_mask_free(&a);
+                row_mask_free(&b);
+            }
+        }
+    }
+    CU_ASSERT(ok);
+
+    size_t keys[1] = {0};
+    Aggregation sum = {1, AGGREGATE_SUM, NULL};
+    DataFrame *expected = group_by(plain, keys, 1, &sum, 1, 1);
+    DataFrame *grouped = group_by(encoded, keys, 1, &sum, 1, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(grouped);
+    CU_ASSERT_EQUAL(grouped->num_rows, 4);
+    for (size_t g = 0; g < grouped->num_rows; g++) {
+        CU_ASSERT_EQUAL(grouped->columns[0].data.int_data[g], expected->columns[0].data.int_data[g]);
+        CU_ASSERT_EQUAL(grouped->columns[1].data.float_data[g], expected->columns[1].data.float_data[g]);
+    }
+    destroy_dataframe(expected);
+    destroy_dataframe(grouped);
+
+    SortKey key = {1, 1};
+    size_t *order = argsort(encoded, &key, 1, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(order);
+    int value, previous = INT_MAX;
+    ok = 1;
+    for (size_t i = 0; i < NUM_ROWS; i++) {
+        get_value(encoded, order[i], 1, &value);
+        ok &= value <= previous;
+        previous = value;
+    }
+    CU_ASSERT(ok);
+    free(order);
+
+    const char *filename = "test_encoding.bin";
+    CU_ASSERT_EQUAL(save_binary(encoded, filename), 0);
+    DataFrame *loaded = load_binary(filename);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(loaded);
+    CU_ASSERT_EQUAL(memcmp(loaded->columns[2].data.int_data, sorted, sizeof(sorted)), 0);
+    destroy_dataframe(loaded);
+    remove(filename);
+
+    destroy_dataframe(plain);
+    destroy_dataframe(encoded);
+}
+
+/**
+ * Test that writes decode a column back to plain ints and that columns can be
+ * re-encoded, while appends keep working.
+ */
+void test_encoded_mutation(void) {
+    int values[1000];
+    for (int i = 0; i < 1000; i++) values[i] = i / 100;
+    DataFrame *df = create_dataframe(1000, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_int_column(df, 0, "Bucket", values, INT_ENCODING_AUTO), 0);
+    CU_ASSERT_EQUAL(df->columns[0].encoding, INT_ENCODING_RLE);
+
+    int value = 42;
+    CU_ASSERT_EQUAL(set_value(df, 500, 0, &value), 0);
+    CU_ASSERT_EQUAL(df->columns[0].encoding, INT_ENCODING_PLAIN);
+    CU_ASSERT_EQUAL(get_value(df, 500, 0, &value), 0);
+    CU_ASSERT_EQUAL(value, 42);
+    CU_ASSERT_EQUAL(get_value(df, 501, 0, &value), 0);
+    CU_ASSERT_EQUAL(value, 5);
+
+    CU_ASSERT_EQUAL(encode_int_column(df, 0, INT_ENCODING_FOR), 0);
+    CU_ASSERT_EQUAL(encode_int_column(df, 0, INT_ENCODING_DELTA), 0);
+    CU_ASSERT_EQUAL(df->columns[0].encoding, INT_ENCODING_DELTA);
+    const void *row[1] = {&value};
+    value = -7;
+    CU_ASSERT_EQUAL(append_row(df, row), 0);
+    CU_ASSERT_EQUAL(df->columns[0].encoding, INT_ENCODING_PLAIN);
+    CU_ASSERT_EQUAL(df->num_rows, 1001);
+    CU_ASSERT_EQUAL(df->columns[0].data.int_data[500], 42);
+    CU_ASSERT_EQUAL(df->columns[0].data.int_data[1000], -7);
+
+    CU_ASSERT_EQUAL(encode_int_column(df, 0, INT_ENCODING_RLE), 0);
+    CU_ASSERT_EQUAL(encode_int_column(df, 0, INT_ENCODING_PLAIN), 0);
+    CU_ASSERT_EQUAL(df->columns[0].data.int_data[999], 9);
+    CU_ASSERT_EQUAL(encode_int_column(df, 1, INT_ENCODING_RLE), -1);
+    destroy_dataframe(df);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Encoding Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_encode_ints", test_encode_ints) == NULL) ||
+        (CU_add_test(suite, "test_encoded_columns", test_encoded_columns) == NULL) ||
+        (CU_add_test(suite, "test_encoded_mutation", test_encoded_mutation) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,159 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "filter.h"
+
+/**
+ * Test every comparison on INT and FLOAT columns against a scalar reference,
+ * with a row count that leaves a partial mask word.
+ */
+void test_numeric_compare(void) {
+    size_t num_rows = 1000;
+    DataFrame *df = create_dataframe(num_rows, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "Count"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Value"), 0);
+    for (size_t i = 0; i < num_rows; i++) {
+        df->columns[0].data.int_data[i] = (int)(i * 37 % 101) - 50;
+        df->columns[1].data.float_data[i] = i % 97 == 0 ? NAN : (float)(i * 13 % 29) / 4.0f;
+    }
+
+    RowMask mask;
+    CU_ASSERT_EQUAL_FATAL(row_mask_init(&mask, num_rows), 0);
+    int threshold = 7;
+    float limit = 3.25f;
+    int ok = 1;
+    for (int op = COMPARE_EQ; op <= COMPARE_GE; op++) {
+        CU_ASSERT_EQUAL(filter_compare(df, 0, (CompareOp)op, &threshold, &mask), 0);
+        for (size_t i = 0; i < num_rows; i++) {
+            int v = df->columns[0].data.int_data[i];
+            int expected = op == COMPARE_EQ ? v == threshold : op == COMPARE_NE ? v != threshold :
+                           op == COMPARE_LT ? v < threshold : op == COMPARE_LE ? v <= threshold :
+                           op == COMPARE_GT ? v > threshold : v >= threshold;
+            ok &= (int)(mask.words[i / 64] >> (i % 64) & 1) == expected;
+        }
+        CU_ASSERT_EQUAL(filter_compare(df, 1, (CompareOp)op, &limit, &mask), 0);
+        for (size_t i = 0; i < num_rows; i++) {
+            float v = df->columns[1].data.float_data[i];
+            int expected = op == COMPARE_EQ ? v == limit : op == COMPARE_NE ? v != limit :
+                           op == COMPARE_LT ? v < limit : op == COMPARE_LE ? v <= limit :
+                           op == COMPARE_GT ? v > limit : v >= limit;
+            ok &= (int)(mask.words[i / 64] >> (i % 64) & 1) == expected;
+        }
+        // Bits past the last row stay clear
+        ok &= (mask.words[num_rows / 64] >> (num_rows % 64)) == 0;
+    }
+    CU_ASSERT(ok);
+
+    row_mask_free(&mask);
+    destroy_dataframe(df);
+}
+
+/**
+ * Test string and categorical predicates, AND/OR/NOT combinations and
+ * gathering the selected rows into a new DataFrame.
+ */
+void test_filter_rows(void) {
+    size_t num_rows = 300;
+    DataFrame *df = create_dataframe(num_rows, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "ID"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 1, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 2, "City"), 0);
+    const char *cities[3] = {"Oslo", "Lima", "Pune"};
+    for (size_t i = 0; i < num_rows; i++) {
+        int id = (int)i;
+        char name[16];
+        snprintf(name, sizeof(name), "n%03zu", i);
+        set_value(df, i, 0, &id);
+        if (i % 5 != 0) set_value(df, i, 1, name);
+        if (i % 7 != 0) set_value(df, i, 2, cities[i % 3]);
+    }
+
+    RowMask lima, late;
+    CU_ASSERT_EQUAL_FATAL(row_mask_init(&lima, num_rows), 0);
+    CU_ASSERT_EQUAL_FATAL(row_mask_init(&late, num_rows), 0);
+
+    // NULLs match neither = nor !=
+    CU_ASSERT_EQUAL(filter_compare(df, 2, COMPARE_NE, "Lima", &lima), 0);
+    CU_ASSERT_EQUAL(row_mask_count(&lima), 171);
+    CU_ASSERT_EQUAL(filter_compare(df, 2, COMPARE_EQ, "Rome", &lima), 0);
+    CU_ASSERT_EQUAL(row_mask_count(&lima), 0);
+    CU_ASSERT_EQUAL(filter_compare(df, 2, COMPARE_LT, "Oslo", &lima), 0);
+    CU_ASSERT_EQUAL(filter_compare(df, 1, COMPARE_GE, "n250", &late), 0);
+    CU_ASSERT_EQUAL(row_mask_count(&late), 40);
+
+    // City < "Oslo" is Lima; keep the late rows among them
+    CU_ASSERT_EQUAL(row_mask_and(&lima, &late), 0);
+    size_t count = 0;
+    size_t *rows = row_mask_selection(&lima, &count);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(rows);
+    int ok = count > 0;
+    for (size_t i = 0; i < count; i++) {
+        ok &= rows[i] >= 250 && rows[i] % 3 == 1 && rows[i] % 5 != 0 && rows[i] % 7 != 0;
+        ok &= i == 0 || rows[i] > rows[i - 1];
+    }
+    CU_ASSERT(ok);
+
+    DataFrame *filtered = filter_rows(df, &lima);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(filtered);
+    CU_ASSERT_EQUAL(filtered->num_rows, count);
+    for (size_t i = 0; i < count; i++) {
+        int id;
+        const char *name, *city;
+        get_value(filtered, i, 0, &id);
+        get_value(filtered, i, 1, &name);
+        get_value(filtered, i, 2, &city);
+        ok &= (size_t)id == rows[i] && strcmp(city, "Lima") == 0 && name != NULL && atoi(name + 1) == id;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(filtered->columns[2].data.categorical_data.num_categories, 1);
+    destroy_dataframe(filtered);
+    free(rows);
+
+    // NOT and OR cover every row
+    CU_ASSERT_EQUAL(row_mask_or(&late, &lima), 0);
+    memcpy(lima.words, late.words, ((num_rows + 63) / 64) * sizeof(uint64_t));
+    row_mask_not(&lima);
+    CU_ASSERT_EQUAL(row_mask_count(&lima), num_rows - 40);
+    CU_ASSERT_EQUAL(row_mask_or(&lima, &late), 0);
+    CU_ASSERT_EQUAL(row_mask_count(&lima), num_rows);
+
+    row_mask_free(&lima);
+    row_mask_free(&late);
+    destroy_dataframe(df);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Filter Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_numeric_compare", test_numeric_compare) == NULL) ||
+        (CU_add_test(suite, "test_filter_rows", test_filter_rows) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,166 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "groupby.h"
+
+/**
+ * Test grouping by a categorical and an int key against hand-computed
+ * aggregates, with groups in order of first appearance.
+ */
+void test_group_by_keys(void) {
+    const char *cities[6] = {"Oslo", "Lima", "Oslo", "Lima", NULL, "Oslo"};
+    int bands[6] = {1, 1, 1, 2, 1, 2};
+    int counts[6] = {5, 3, 7, 4, 9, 1};
+    float prices[6] = {1.5f, 2.0f, 2.5f, NAN, 4.0f, 8.0f};
+    DataFrame *df = create_dataframe(6, 5);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 0, "City"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 1, "Band"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 2, "Count"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 3, "Price"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 4, "Note"), 0);
+    CU_ASSERT_EQUAL(set_values(df, 0, 0, 6, cities), 0);
+    CU_ASSERT_EQUAL(set_values(df, 1, 0, 6, bands), 0);
+    CU_ASSERT_EQUAL(set_values(df, 2, 0, 6, counts), 0);
+    CU_ASSERT_EQUAL(set_values(df, 3, 0, 6, prices), 0);
+    CU_ASSERT_EQUAL(set_value(df, 0, 4, "first"), 0);
+
+    size_t keys[2] = {0, 1};
+    Aggregation aggregations[5] = {
+        {2, AGGREGATE_SUM, "total"},
+        {4, AGGREGATE_COUNT, NULL},
+        {2, AGGREGATE_MIN, NULL},
+        {3, AGGREGATE_MAX, NULL},
+        {3, AGGREGATE_MEAN, NULL},
+    };
+    DataFrame *groups = group_by(df, keys, 2, aggregations, 5, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(groups);
+    CU_ASSERT_EQUAL(groups->num_rows, 5);
+    CU_ASSERT_EQUAL(groups->num_columns, 7);
+    CU_ASSERT_STRING_EQUAL(groups->columns[0].name, "City");
+    CU_ASSERT_STRING_EQUAL(groups->columns[2].name, "total");
+    CU_ASSERT_STRING_EQUAL(groups->columns[3].name, "count_Note");
+    CU_ASSERT_EQUAL(groups->columns[4].type, DATA_TYPE_INT);
+    CU_ASSERT_EQUAL(groups->columns[5].type, DATA_TYPE_FLOAT);
+
+    // (Oslo, 1) holds rows 0 and 2
+    const char *city;
+    int band, count, min;
+    float total, max, mean;
+    get_value(groups, 0, 0, &city);
+    get_value(groups, 0, 1, &band);
+    get_value(groups, 0, 2, &total);
+    get_value(groups, 0, 3, &count);
+    get_value(groups, 0, 4, &min);
+    get_value(groups, 0, 5, &max);
+    get_value(groups, 0, 6, &mean);
+    CU_ASSERT_STRING_EQUAL(city, "Oslo");
+    CU_ASSERT_EQUAL(band, 1);
+    CU_ASSERT_EQUAL(total, 12.0f);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(min, 5);
+    CU_ASSERT_EQUAL(max, 2.5f);
+    CU_ASSERT_EQUAL(mean, 2.0f);
+
+    // (Lima, 2) only holds a NaN price; NULL cities form their own group
+    get_value(groups, 2, 0, &city);
+    get_value(groups, 2, 5, &max);
+    get_value(groups, 2, 6, &mean);
+    CU_ASSERT_STRING_EQUAL(city, "Lima");
+    CU_ASSERT(isinf(max));
+    CU_ASSERT(isnan(mean));
+    get_value(groups, 3, 0, &city);
+    get_value(groups, 3, 2, &total);
+    CU_ASSERT_PTR_NULL(city);
+    CU_ASSERT_EQUAL(total, 9.0f);
+    destroy_dataframe(groups);
+
+    // Only numeric columns can be summed
+    Aggregation invalid = {4, AGGREGATE_SUM, NULL};
+    CU_ASSERT_PTR_NULL(group_by(df, keys, 2, &invalid, 1, 1));
+    size_t float_key = 3;
+    CU_ASSERT_PTR_NULL(group_by(df, &float_key, 1, aggregations, 1, 1));
+
+    destroy_dataframe(df);
+}
+
+/**
+ * Test that merging per-thread partial tables gives the same groups, in the
+ * same order and with the same aggregates, as a single thread.
+ */
+void test_group_by_parallel(void) {
+    size_t num_rows = 400000;
+    DataFrame *df = create_dataframe(num_rows, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 0, "Key"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 1, "Value"), 0);
+    unsigned int seed = 7;
+    for (size_t i = 0; i < num_rows; i++) {
+        seed = seed * 1103515245u + 12345u;
+        char key[16];
+        snprintf(key, sizeof(key), "k%u", (seed >> 8) % 20000);
+        set_value(df, i, 0, key);
+        df->columns[1].data.int_data[i] = (int)(seed % 1000);
+    }
+
+    size_t key = 0;
+    Aggregation aggregations[3] = {{1, AGGREGATE_SUM, NULL}, {1, AGGREGATE_COUNT, NULL}, {1, AGGREGATE_MAX, NULL}};
+    DataFrame *serial = group_by(df, &key, 1, aggregations, 3, 1);
+    DataFrame *parallel = group_by(df, &key, 1, aggregations, 3, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(serial);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parallel);
+    CU_ASSERT_EQUAL(serial->num_rows, 20000);
+    CU_ASSERT_EQUAL(parallel->num_rows, serial->num_rows);
+
+    int ok = 1;
+    size_t total = 0;
+    for (size_t g = 0; g < serial->num_rows && g < parallel->num_rows; g++) {
+        ok &= strcmp(column_string(&serial->columns[0], g), column_string(&parallel->columns[0], g)) == 0;
+        ok &= serial->columns[1].data.float_data[g] == parallel->columns[1].data.float_data[g];
+        ok &= serial->columns[2].data.int_data[g] == parallel->columns[2].data.int_data[g];
+        ok &= serial->columns[3].data.int_data[g] == parallel->columns[3].data.int_data[g];
+        total += (size_t)serial->columns[2].data.int_data[g];
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(total, num_rows);
+    // The first group is the key of the first row
+    CU_ASSERT_STRING_EQUAL(column_string(&parallel->columns[0], 0), column_string(&df->columns[0], 0));
+
+    destroy_dataframe(serial);
+    destroy_dataframe(parallel);
+    destroy_dataframe(df);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Group By Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_group_by_keys", test_group_by_keys) == NULL) ||
+        (CU_add_test(suite, "test_group_by_parallel", test_group_by_parallel) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,167 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "join.h"
+
+/**
+ * Test inner and left joins of a fact table with a dimension table on a
+ * string key, including duplicate keys, NULL keys and clashing names.
+ */
+void test_join_string_key(void) {
+    DataFrame *facts = create_dataframe(6, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(facts);
+    CU_ASSERT_EQUAL(add_column(facts, DATA_TYPE_STRING, 0, "City"), 0);
+    CU_ASSERT_EQUAL(add_column(facts, DATA_TYPE_INT, 1, "Amount"), 0);
+    const char *fact_cities[6] = {"Oslo", "Lima", "Rome", NULL, "Oslo", "Pune"};
+    int amounts[6] = {10, 20, 30, 40, 50, 60};
+    CU_ASSERT_EQUAL(set_values(facts, 0, 0, 6, fact_cities), 0);
+    CU_ASSERT_EQUAL(set_values(facts, 1, 0, 6, amounts), 0);
+
+    // Categorical on the other side; Pune appears twice
+    DataFrame *cities = create_dataframe(4, 3);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(cities);
+    CU_ASSERT_EQUAL(add_column(cities, DATA_TYPE_CATEGORICAL, 0, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(cities, DATA_TYPE_STRING, 1, "Country"), 0);
+    CU_ASSERT_EQUAL(add_column(cities, DATA_TYPE_INT, 2, "Amount"), 0);
+    const char *names[4] = {"Pune", "Oslo", "Lima", "Pune"};
+    const char *countries[4] = {"India", "Norway", "Peru", "India (west)"};
+    int populations[4] = {7, 1, 10, 8};
+    CU_ASSERT_EQUAL(set_values(cities, 0, 0, 4, names), 0);
+    CU_ASSERT_EQUAL(set_values(cities, 1, 0, 4, countries), 0);
+    CU_ASSERT_EQUAL(set_values(cities, 2, 0, 4, populations), 0);
+
+    JoinOptions options = {JOIN_INNER, 0};
+    DataFrame *inner = hash_join(facts, 0, cities, 0, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(inner);
+    CU_ASSERT_EQUAL(inner->num_rows, 5);
+    CU_ASSERT_EQUAL(inner->num_columns, 4);
+    CU_ASSERT_STRING_EQUAL(inner->columns[2].name, "Country");
+    CU_ASSERT_STRING_EQUAL(inner->columns[3].name, "Amount_right");
+
+    // Rows follow the left side, duplicates in right order
+    int amount;
+    const char *country;
+    get_value(inner, 0, 1, &amount);
+    get_value(inner, 0, 2, &country);
+    CU_ASSERT_EQUAL(amount, 10);
+    CU_ASSERT_STRING_EQUAL(country, "Norway");
+    get_value(inner, 3, 2, &country);
+    CU_ASSERT_STRING_EQUAL(country, "India");
+    get_value(inner, 4, 2, &country);
+    CU_ASSERT_STRING_EQUAL(country, "India (west)");
+    destroy_dataframe(inner);
+
+    options.type = JOIN_LEFT;
+    DataFrame *left = hash_join(facts, 0, cities, 0, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(left);
+    CU_ASSERT_EQUAL(left->num_rows, 7);
+    const char *city;
+    int population;
+    get_value(left, 2, 0, &city);
+    get_value(left, 2, 2, &country);
+    get_value(left, 2, 3, &population);
+    CU_ASSERT_STRING_EQUAL(city, "Rome");
+    CU_ASSERT_PTR_NULL(country);
+    CU_ASSERT_EQUAL(population, 0);
+    get_value(left, 3, 0, &city);
+    get_value(left, 3, 2, &country);
+    CU_ASSERT_PTR_NULL(city);
+    CU_ASSERT_PTR_NULL(country);
+    destroy_dataframe(left);
+
+    // Keys must be comparable
+    CU_ASSERT_PTR_NULL(hash_join(facts, 1, cities, 0, NULL));
+
+    destroy_dataframe(facts);
+    destroy_dataframe(cities);
+}
+
+/**
+ * Test that a partitioned join finds the same pairs as an unpartitioned one
+ * when the build side is spread over many partitions.
+ */
+void test_join_partitioned(void) {
+    size_t num_facts = 300000, num_keys = 100000;
+    DataFrame *facts = create_dataframe(num_facts, 2);
+    DataFrame *dims = create_dataframe(num_keys, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(facts);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(dims);
+    CU_ASSERT_EQUAL(add_column(facts, DATA_TYPE_INT, 0, "Key"), 0);
+    CU_ASSERT_EQUAL(add_column(facts, DATA_TYPE_INT, 1, "Row"), 0);
+    CU_ASSERT_EQUAL(add_column(dims, DATA_TYPE_INT, 0, "Key"), 0);
+    CU_ASSERT_EQUAL(add_column(dims, DATA_TYPE_INT, 1, "Double"), 0);
+    for (size_t i = 0; i < num_keys; i++) {
+        // Only even keys exist on the dimension side
+        dims->columns[0].data.int_data[i] = (int)(2 * i);
+        dims->columns[1].data.int_data[i] = (int)(4 * i);
+    }
+    unsigned int seed = 3;
+    for (size_t i = 0; i < num_facts; i++) {
+        seed = seed * 1103515245u + 12345u;
+        facts->columns[0].data.int_data[i] = (int)((seed >> 8) % (2 * num_keys));
+        facts->columns[1].data.int_data[i] = (int)i;
+    }
+
+    JoinOptions plain = {JOIN_LEFT, 0};
+    JoinOptions partitioned = {JOIN_LEFT, 1};
+    DataFrame *a = hash_join(facts, 0, dims, 0, &plain);
+    DataFrame *b = hash_join(facts, 0, dims, 0, &partitioned);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(a);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(b);
+    CU_ASSERT_EQUAL(a->num_rows, num_facts);
+    CU_ASSERT_EQUAL(b->num_rows, num_facts);
+
+    // Partitioned output is in partition order; compare by original row
+    int *doubles = calloc(num_facts, sizeof(int));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(doubles);
+    int ok = 1;
+    for (size_t i = 0; i < num_facts; i++) {
+        int key = a->columns[0].data.int_data[i];
+        ok &= a->columns[1].data.int_data[i] == (int)i;
+        ok &= a->columns[2].data.int_data[i] == (key % 2 == 0 ? 2 * key : 0);
+        doubles[b->columns[1].data.int_data[i]] = b->columns[2].data.int_data[i];
+    }
+    for (size_t i = 0; i < num_facts; i++) {
+        ok &= doubles[i] == a->columns[2].data.int_data[i];
+    }
+    CU_ASSERT(ok);
+
+    free(doubles);
+    destroy_dataframe(a);
+    destroy_dataframe(b);
+    destroy_dataframe(facts);
+    destroy_dataframe(dims);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Join Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_join_string_key", test_join_string_key) == NULL) ||
+        (CU_add_test(suite, "test_join_partitioned", test_join_partitioned) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,155 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numparse.h"
+
+/**
+ * Test integer conversion: signs, blanks, long digit runs that take the
+ * eight-digit path, the int range limits and malformed input.
+ */
+void test_parse_int32(void) {
+    int value;
+    CU_ASSERT_EQUAL(parse_int32("42", 2, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 42);
+    CU_ASSERT_EQUAL(parse_int32(" -17\t", 5, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, -17);
+    CU_ASSERT_EQUAL(parse_int32("+0001234567890", 14, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 1234567890);
+    CU_ASSERT_EQUAL(parse_int32("2147483647", 10, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 2147483647);
+    CU_ASSERT_EQUAL(parse_int32("-2147483648", 11, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, -2147483647 - 1);
+
+    // The length bounds the field, trailing bytes are not read
+    CU_ASSERT_EQUAL(parse_int32("12345678,9", 8, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 12345678);
+
+    CU_ASSERT_EQUAL(parse_int32("2147483648", 10, &value), PARSE_OVERFLOW);
+    CU_ASSERT_EQUAL(parse_int32("-2147483649", 11, &value), PARSE_OVERFLOW);
+    CU_ASSERT_EQUAL(parse_int32("99999999999999999999999", 23, &value), PARSE_OVERFLOW);
+    CU_ASSERT_EQUAL(value, 0);
+
+    CU_ASSERT_EQUAL(parse_int32("", 0, &value), PARSE_EMPTY);
+    CU_ASSERT_EQUAL(parse_int32("  ", 2, &value), PARSE_EMPTY);
+    CU_ASSERT_EQUAL(parse_int32("-", 1, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_int32("12a", 3, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_int32("1.5", 3, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_int32("1 2", 3, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_int32("1234567a9", 9, &value), PARSE_INVALID);
+
+    // Agrees with strtol on every value of a sweep
+    char text[32];
+    int ok = 1;
+    for (long n = -3000000000L; n <= 3000000000L; n += 12345679L) {
+        int length = snprintf(text, sizeof(text), "%ld", n);
+        ParseStatus status = parse_int32(text, (size_t)length, &value);
+        if (n < -2147483648L || n > 2147483647L) {
+            ok &= status == PARSE_OVERFLOW;
+        } else {
+            ok &= status == PARSE_OK && value == (int)n;
+        }
+    }
+    CU_ASSERT(ok);
+}
+
+/**
+ * Test float conversion against strtof on short decimals, long mantissas
+ * and large exponents, plus special values and malformed input.
+ */
+void test_parse_float32(void) {
+    float value;
+    CU_ASSERT_EQUAL(parse_float32("3.25", 4, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 3.25f);
+    CU_ASSERT_EQUAL(parse_float32(" -0.1 ", 6, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, -0.1f);
+    CU_ASSERT_EQUAL(parse_float32(".5", 2, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 0.5f);
+    CU_ASSERT_EQUAL(parse_float32("7.", 2, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 7.0f);
+    CU_ASSERT_EQUAL(parse_float32("1e3", 3, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 1000.0f);
+    CU_ASSERT_EQUAL(parse_float32("-0", 2, &value), PARSE_OK);
+    CU_ASSERT(value == 0.0f && signbit(value));
+    CU_ASSERT_EQUAL(parse_float32("0e999", 5, &value), PARSE_OK);
+    CU_ASSERT_EQUAL(value, 0.0f);
+    CU_ASSERT_EQUAL(parse_float32("-Infinity", 9, &value), PARSE_OK);
+    CU_ASSERT(isinf(value) && value < 0);
+    CU_ASSERT_EQUAL(parse_float32("NaN", 3, &value), PARSE_OK);
+    CU_ASSERT(isnan(value));
+
+    CU_ASSERT_EQUAL(parse_float32("1e39", 4, &value), PARSE_OVERFLOW);
+    CU_ASSERT(isinf(value));
+    CU_ASSERT_EQUAL(parse_float32("", 0, &value), PARSE_EMPTY);
+    CU_ASSERT_EQUAL(parse_float32(".", 1, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_float32("1e", 2, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_float32("1.2.3", 5, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_float32("0x10", 4, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(parse_float32("abc", 3, &value), PARSE_INVALID);
+    CU_ASSERT_EQUAL(value, 0.0f);
+
+    // Bit-for-bit agreement with strtof, which rounds correctly
+    const char *formats[4] = {"%d.%02d", "%d.%06de-3", "%d%06d.5e12", "%d.%09de-30"};
+    char text[64];
+    int ok = 1;
+    srand(7);
+    for (int i = 0; i < 200000; i++) {
+        int length = snprintf(text, sizeof(text), formats[i % 4], rand() % 100000 - 50000, rand() % 1000000);
+        float expected = strtof(text, NULL);
+        ok &= parse_float32(text, (size_t)length, &value) == PARSE_OK;
+        ok &= memcmp(&value, &expected, sizeof(float)) == 0;
+    }
+    const char *hard[4] = {"16777217", "0.1000000000000000055511151231257827", "3.4028235e38",
+                           "1.00000005960464477539062500000000000001"};
+    for (int i = 0; i < 4; i++) {
+        float expected = strtof(hard[i], NULL);
+        ok &= parse_float32(hard[i], strlen(hard[i]), &value) == PARSE_OK;
+        ok &= memcmp(&value, &expected, sizeof(float)) == 0;
+    }
+    CU_ASSERT(ok);
+
+    // The slow path ignores a locale whose decimal separator is a comma
+    const char *locales[3] = {"de_DE.UTF-8", "fr_FR.UTF-8", "de_DE"};
+    for (int i = 0; i < 3; i++) {
+        if (setlocale(LC_NUMERIC, locales[i]) == NULL) continue;
+        CU_ASSERT_EQUAL(parse_float32("1.23456789", 10, &value), PARSE_OK);
+        CU_ASSERT_DOUBLE_EQUAL(value, 1.23456789, 1e-6);
+        setlocale(LC_NUMERIC, "C");
+        break;
+    }
+    CU_ASSERT_EQUAL(parse_float32("1.23456789", 10, &value), PARSE_OK);
+    CU_ASSERT_DOUBLE_EQUAL(value, 1.23456789, 1e-6);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Numeric Parsing Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_parse_int32", test_parse_int32) == NULL) ||
+        (CU_add_test(suite, "test_parse_float32", test_parse_float32) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
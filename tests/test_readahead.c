@@ -0,0 +1,233 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "dfio.h"
+#include "readahead.h"
+
+#define NUM_ROWS 20000
+
+// Byte at offset i of the patterned test input
+static char pattern_byte(size_t i) {
+    return (char)('a' + (i * 7 + i / 4096) % 26);
+}
+
+// Source that yields size bytes of the pattern in uneven pieces
+typedef struct {
+    size_t offset;
+    size_t size;
+} PatternSource;
+
+static ssize_t pattern_read(void *context, char *buffer, size_t size) {
+    PatternSource *source = context;
+    size_t bytes = source->size - source->offset;
+    if (bytes > size) bytes = size;
+    if (bytes > 1000) bytes = 1000;
+    for (size_t i = 0; i < bytes; i++) {
+        buffer[i] = pattern_byte(source->offset + i);
+    }
+    source->offset += bytes;
+    return (ssize_t)bytes;
+}
+
+// Source that fails after its first piece
+static ssize_t failing_read(void *context, char *buffer, size_t size) {
+    int *calls = context;
+    if ((*calls)++ > 0) return -1;
+    memset(buffer, 'x', size < 100 ? size : 100);
+    return size < 100 ? (ssize_t)size : 100;
+}
+
+// Consumes a ring and checks that it yields exactly size bytes of the pattern in order
+static int consumes_pattern(ReadAhead *ra, size_t size) {
+    size_t offset = 0;
+    const char *data;
+    size_t length;
+    int ok = 1;
+    int status;
+    while ((status = readahead_next(ra, &data, &length)) == 1) {
+        const char *again;
+        size_t again_length;
+        ok &= readahead_next(ra, &again, &again_length) == 1 && again == data && again_length == length;
+        for (size_t i = 0; ok && i < length; i++) {
+            ok &= data[i] == pattern_byte(offset + i);
+        }
+        offset += length;
+        readahead_release(ra);
+    }
+    return ok && status == 0 && offset == size;
+}
+
+/**
+ * Test that small rings deliver a file and a custom source whole and in
+ * order, that failures surface, and that a ring can be closed early.
+ */
+void test_readahead_ring(void) {
+    const char *filename = "test_readahead_ring.bin";
+    size_t size = 4096 * 9 + 123;
+    FILE *file = fopen(filename, "wb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    for (size_t i = 0; i < size; i++) fputc(pattern_byte(i), file);
+    fclose(file);
+
+    ReadAheadOptions options = {4096, 2, 0, COMPRESSION_AUTO};
+    ReadAhead *ra = readahead_open(filename, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    CU_ASSERT(consumes_pattern(ra, size));
+    readahead_close(ra);
+
+    // Direct I/O falls back to buffered reads where it is not supported
+    options.direct_io = 1;
+    ra = readahead_open(filename, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    CU_ASSERT(consumes_pattern(ra, size));
+    readahead_close(ra);
+
+    PatternSource source = {0, 100000};
+    options.num_blocks = 3;
+    ra = readahead_start(pattern_read, &source, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    CU_ASSERT(consumes_pattern(ra, 100000));
+    readahead_close(ra);
+
+    // Closing while the reader thread waits on a full ring
+    options.num_blocks = 2;
+    options.direct_io = 0;
+    ra = readahead_open(filename, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    const char *data;
+    size_t length;
+    CU_ASSERT_EQUAL(readahead_next(ra, &data, &length), 1);
+    readahead_close(ra);
+
+    int calls = 0;
+    ra = readahead_start(failing_read, &calls, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    CU_ASSERT_EQUAL(readahead_next(ra, &data, &length), -1);
+    readahead_close(ra);
+
+    CU_ASSERT_PTR_NULL(readahead_open("does_not_exist.bin", NULL));
+    CU_ASSERT_PTR_NULL(readahead_start(NULL, NULL, NULL));
+    remove(filename);
+}
+
+// Writes a CSV file whose quoted names contain commas and line breaks
+static void write_sample_csv(const char *filename) {
+    FILE *file = fopen(filename, "w");
+    fprintf(file, "ID,Value,Name,Kind\n");
+    for (int i = 0; i < NUM_ROWS; i++) {
+        if (i % 97 == 0) {
+            fprintf(file, "%d,%d.5,\"name, %d\nsecond line\",k%d\n", i, i, i, i % 5);
+        } else {
+            fprintf(file, "%d,%d.25,name_%d,k%d\n", i, i, i, i % 5);
+        }
+    }
+    fclose(file);
+}
+
+// Whether two frames hold the same rows
+static int frames_equal(const DataFrame *a, const DataFrame *b) {
+    if (a->num_rows != b->num_rows || a->num_columns != b->num_columns) return 0;
+    for (size_t row = 0; row < a->num_rows; row++) {
+        int id_a, id_b;
+        float value_a, value_b;
+        char *name_a, *name_b, *kind_a, *kind_b;
+        get_value(a, row, 0, &id_a);
+        get_value(b, row, 0, &id_b);
+        get_value(a, row, 1, &value_a);
+        get_value(b, row, 1, &value_b);
+        get_value(a, row, 2, &name_a);
+        get_value(b, row, 2, &name_b);
+        if (id_a != id_b || value_a != value_b || strcmp(name_a, name_b) != 0) return 0;
+        get_value(a, row, 3, &kind_a);
+        get_value(b, row, 3, &kind_b);
+        if (strcmp(kind_a, kind_b) != 0) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Test that pipelined reads give the same frame as a memory-mapped read, with
+ * records straddling the blocks of a small ring, and that batches stream.
+ */
+void test_read_csv_pipelined(void) {
+    const char *filename = "test_read_csv_pipelined.csv";
+    write_sample_csv(filename);
+    DataType types[4] = {DATA_TYPE_INT, DATA_TYPE_FLOAT, DATA_TYPE_STRING, DATA_TYPE_CATEGORICAL};
+
+    DataFrame *expected = read_csv_mmap(filename, types, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(expected);
+    CU_ASSERT_EQUAL(expected->num_rows, NUM_ROWS);
+
+    DataFrame *df = read_csv_pipelined(filename, types, 4, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT(frames_equal(df, expected));
+    CU_ASSERT_STRING_EQUAL(df->columns[2].name, "Name");
+    destroy_dataframe(df);
+
+    ReadAheadOptions options = {4096, 2, 0, COMPRESSION_AUTO};
+    df = read_csv_pipelined(filename, types, 4, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT(frames_equal(df, expected));
+    destroy_dataframe(df);
+
+    CsvReader *reader = csv_reader_open_pipelined(filename, types, 4, 3000, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    DataFrame *batch;
+    size_t rows = 0;
+    int ok = 1;
+    while (csv_reader_next_batch(reader, &batch) == 1) {
+        for (size_t row = 0; row < batch->num_rows; row++) {
+            int id;
+            get_value(batch, row, 0, &id);
+            ok &= id == (int)(rows + row);
+        }
+        rows += batch->num_rows;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT_EQUAL(rows, NUM_ROWS);
+    csv_reader_close(reader);
+
+    // Closing before the input is consumed stops the reader thread
+    reader = csv_reader_open_pipelined(filename, types, 4, 10, &options);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    CU_ASSERT_EQUAL(csv_reader_next_batch(reader, &batch), 1);
+    csv_reader_close(reader);
+
+    CU_ASSERT_PTR_NULL(read_csv_pipelined("does_not_exist.csv", types, 4, NULL));
+    CU_ASSERT_PTR_NULL(read_csv_pipelined(filename, types, 3, NULL));
+    destroy_dataframe(expected);
+    remove(filename);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Read-Ahead Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_readahead_ring", test_readahead_ring) == NULL) ||
+        (CU_add_test(suite, "test_read_csv_pipelined", test_read_csv_pipelined) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,150 @@
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dataframe.h"
+#include "sort.h"
+
+/**
+ * Test sorting by categorical, float and string keys in both directions,
+ * including NaNs, NULL strings and ties that must keep their input order.
+ */
+void test_sort_mixed_keys(void) {
+    DataFrame *df = create_dataframe(7, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_CATEGORICAL, 0, "Team"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Score"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_STRING, 2, "Name"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 3, "Id"), 0);
+    const char *teams[7] = {"red", "blue", "red", "blue", "green", "red", "blue"};
+    float scores[7] = {1.5f, -2.0f, NAN, 3.25f, 0.0f, 1.5f, -0.5f};
+    const char *names[7] = {"bo", "al", NULL, "b", "ali", "alice", "bob"};
+    int ids[7] = {0, 1, 2, 3, 4, 5, 6};
+    CU_ASSERT_EQUAL(set_values(df, 0, 0, 7, teams), 0);
+    CU_ASSERT_EQUAL(set_values(df, 1, 0, 7, scores), 0);
+    CU_ASSERT_EQUAL(set_values(df, 2, 0, 7, names), 0);
+    CU_ASSERT_EQUAL(set_values(df, 3, 0, 7, ids), 0);
+
+    // Team ascending by value, not by code, then Score descending with NaN last
+    SortKey keys[2] = {{0, 0}, {1, 1}};
+    size_t *order = argsort(df, keys, 2, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(order);
+    size_t expected[7] = {3, 6, 1, 4, 0, 5, 2};
+    for (size_t i = 0; i < 7; i++) {
+        CU_ASSERT_EQUAL(order[i], expected[i]);
+    }
+    free(order);
+
+    // Strings ascending: prefixes first, NULL last
+    SortKey by_name = {2, 0};
+    order = argsort(df, &by_name, 1, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(order);
+    size_t ascending[7] = {1, 4, 5, 3, 0, 6, 2};
+    for (size_t i = 0; i < 7; i++) {
+        CU_ASSERT_EQUAL(order[i], ascending[i]);
+    }
+    free(order);
+
+    // Strings descending: longer strings before their prefixes, NULL still last
+    by_name.descending = 1;
+    DataFrame *sorted = sort_by(df, &by_name, 1, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sorted);
+    CU_ASSERT_EQUAL(sorted->num_rows, 7);
+    size_t descending[7] = {6, 0, 3, 5, 4, 1, 2};
+    for (size_t i = 0; i < 7; i++) {
+        int id;
+        get_value(sorted, i, 3, &id);
+        CU_ASSERT_EQUAL((size_t)id, descending[i]);
+    }
+    const char *team;
+    float score;
+    get_value(sorted, 0, 0, &team);
+    get_value(sorted, 0, 1, &score);
+    CU_ASSERT_STRING_EQUAL(team, "blue");
+    CU_ASSERT_DOUBLE_EQUAL(score, -0.5, 1e-6);
+    destroy_dataframe(sorted);
+
+    // Invalid keys
+    SortKey bad = {4, 0};
+    CU_ASSERT_PTR_NULL(argsort(df, &bad, 1, 1));
+    CU_ASSERT_PTR_NULL(argsort(df, keys, 0, 1));
+
+    destroy_dataframe(df);
+}
+
+/**
+ * Test that the multi-threaded radix sort gives the same stable order as the
+ * single-threaded one on a large input with many ties.
+ */
+void test_sort_parallel(void) {
+    size_t num_rows = 300000;
+    DataFrame *df = create_dataframe(num_rows, 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(df);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_INT, 0, "Key"), 0);
+    CU_ASSERT_EQUAL(add_column(df, DATA_TYPE_FLOAT, 1, "Value"), 0);
+    srand(42);
+    for (size_t i = 0; i < num_rows; i++) {
+        df->columns[0].data.int_data[i] = rand() % 2001 - 1000;
+        df->columns[1].data.float_data[i] = (float)(rand() % 100000) / 7.0f - 7000.0f;
+    }
+
+    SortKey key = {0, 0};
+    size_t *serial = argsort(df, &key, 1, 1);
+    size_t *parallel = argsort(df, &key, 1, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(serial);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parallel);
+    int ok = memcmp(serial, parallel, num_rows * sizeof(size_t)) == 0;
+    const int *ints = df->columns[0].data.int_data;
+    for (size_t i = 1; i < num_rows; i++) {
+        int a = ints[parallel[i - 1]], b = ints[parallel[i]];
+        ok &= a < b || (a == b && parallel[i - 1] < parallel[i]);
+    }
+    CU_ASSERT(ok);
+    free(serial);
+    free(parallel);
+
+    SortKey by_value = {1, 1};
+    DataFrame *sorted = sort_by(df, &by_value, 1, 4);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(sorted);
+    const float *floats = sorted->columns[1].data.float_data;
+    ok = 1;
+    for (size_t i = 1; i < num_rows; i++) {
+        ok &= floats[i - 1] >= floats[i];
+    }
+    CU_ASSERT(ok);
+    destroy_dataframe(sorted);
+
+    destroy_dataframe(df);
+}
+
+// Main function to run tests
+int main() {
+    // Initialize CUnit
+    if (CUE_SUCCESS != CU_initialize_registry()) {
+        return CU_get_error();
+    }
+
+    // Create a test suite
+    CU_pSuite suite = CU_add_suite("Sort Suite", NULL, NULL);
+    if (suite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Add tests to the suite
+    if ((CU_add_test(suite, "test_sort_mixed_keys", test_sort_mixed_keys) == NULL) ||
+        (CU_add_test(suite, "test_sort_parallel", test_sort_parallel) == NULL)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    // Run the tests using the basic interface
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Clean up
+    CU_cleanup_registry();
+    return CU_get_error();
+}